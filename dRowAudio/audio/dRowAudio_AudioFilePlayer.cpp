@@ -29,6 +29,71 @@
   ==============================================================================
 */
 
+//==============================================================================
+class AudioFilePlayer::AsyncLoadJob  : public ThreadPoolJob
+{
+public:
+    AsyncLoadJob (AudioFilePlayer& owner_, const File& file_, const LoadSettings& settings_, int generation_)
+        : ThreadPoolJob ("AudioFilePlayer file opener"),
+          owner (owner_),
+          file (file_),
+          settings (settings_),
+          generation (generation_)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        if (! shouldExit())
+        {
+            SourceChain* newChain = owner.loadSourceChain (file, settings);
+
+            // hands over ownership of the chain, which is deleted if the load has been cancelled
+            owner.asyncLoadFinished (generation, file, newChain);
+        }
+
+        return jobHasFinished;
+    }
+
+    /** Picks out the load jobs, leaving any old chains in the pool to be deleted. */
+    struct Selector  : public ThreadPool::JobSelector
+    {
+        bool isJobSuitable (ThreadPoolJob* job)     { return dynamic_cast<AsyncLoadJob*> (job) != nullptr; }
+    };
+
+private:
+    AudioFilePlayer& owner;
+    const File file;
+    const LoadSettings settings;
+    const int generation;
+
+    JUCE_DECLARE_NON_COPYABLE (AsyncLoadJob);
+};
+
+//==============================================================================
+class AudioFilePlayer::DeleteSourceChainJob  : public ThreadPoolJob
+{
+public:
+    DeleteSourceChainJob (SourceChain* chainToDelete)
+        : ThreadPoolJob ("AudioFilePlayer source deleter"),
+          chain (chainToDelete)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        chain = nullptr;
+
+        return jobHasFinished;
+    }
+
+private:
+    ScopedPointer<SourceChain> chain;
+
+    JUCE_DECLARE_NON_COPYABLE (DeleteSourceChainJob);
+};
+
+//==============================================================================
 
 AudioFilePlayer::AudioFilePlayer()
     : bufferingTimeSliceThread (new TimeSliceThread ("Shared Buffering Thread"), true),
@@ -54,6 +119,8 @@ AudioFilePlayer::AudioFilePlayer (TimeSliceThread* threadToUse,
 
 AudioFilePlayer::~AudioFilePlayer()
 {
+    stopLoadingThread();
+
 	audioTransportSource.setSource (nullptr);
     audioTransportSource.removeChangeListener (this);
 }
@@ -100,33 +167,179 @@ void AudioFilePlayer::setPosition (double newPosition, bool /*ignoreAnyLoopPoint
     audioTransportSource.setPosition (newPosition);
 }
 
+double AudioFilePlayer::getCurrentPosition() const
+{
+    if (scrubbingAudioSource != nullptr && getFileSampleRate() > 0.0)
+        return scrubbingAudioSource->getTargetPosition() / getFileSampleRate();
+    
+    return audioTransportSource.getCurrentPosition();
+}
+
+double AudioFilePlayer::getAudiblePosition() const
+{
+    if (scrubbingAudioSource != nullptr)
+        return getCurrentPosition();
+    
+    const double latencyInSeconds = (getLatencySamples() + outputLatency) / preparedSampleRate;
+    
+    return jlimit (0.0, jmax (0.0, getLengthInSeconds()),
+                   getCurrentPosition() - latencyInSeconds * getPlaybackSpeed());
+}
+
+double AudioFilePlayer::getSecondsAvailable() const
+{
+    const double lengthInSeconds = jmax (0.0, getLengthInSeconds());
+    const double position = jlimit (0.0, lengthInSeconds, getCurrentPosition());
+    
+   #if DROWAUDIO_USE_CURL
+    if (CURLStreamingInputStream* stream = getStreamingInputStream())
+    {
+        const int64 totalBytes = stream->getTotalLength();
+        
+        if (totalBytes <= 0 || lengthInSeconds <= 0.0)
+            return 0.0;
+        
+        // assumes the data is spread evenly through the stream which is close enough for PCM and CBR files
+        const int64 bytePosition = (int64) (totalBytes * (position / lengthInSeconds));
+        const double secondsAvailable = lengthInSeconds * stream->getNumBytesAvailable (bytePosition) / (double) totalBytes;
+        
+        return jmin (lengthInSeconds - position, secondsAvailable);
+    }
+   #endif
+    
+    return lengthInSeconds - position;
+}
+
 //==============================================================================
 void AudioFilePlayer::setAudioFormatManager (AudioFormatManager* newManager, bool deleteWhenNotNeeded)
 {
+    stopLoadingThread();
     formatManager.set (newManager, deleteWhenNotNeeded);
 }
 
 void AudioFilePlayer::setTimeSliceThread (TimeSliceThread* newThreadToUse, bool deleteWhenNotNeeded)
 {
+    stopLoadingThread();
     bufferingTimeSliceThread.set (newThreadToUse, deleteWhenNotNeeded);
 }
 
+bool AudioFilePlayer::isMemoryMapped() const
+{
+    return audioFormatReaderSource != nullptr
+            && isMemoryMappedReader (audioFormatReaderSource->getAudioFormatReader());
+}
+
+//==============================================================================
+void AudioFilePlayer::setFileAsync (const File& newFile)
+{
+    cancelAsyncLoad();
+    
+    // the settings are copied now as they could be changed whilst the file is loading
+    isLoadingFile = true;
+    getLoadingThreadPool().addJob (new AsyncLoadJob (*this, newFile, getLoadSettings(),
+                                                     loadGeneration.get()), true);
+}
+
+void AudioFilePlayer::cancelAsyncLoad()
+{
+    // bumping the generation makes any jobs already running throw their result away
+    ++loadGeneration;
+    isLoadingFile = false;
+    
+    if (loadingThreadPool != nullptr)
+    {
+        AsyncLoadJob::Selector loadJobs;
+        loadingThreadPool->removeAllJobs (true, 0, &loadJobs);
+    }
+    
+    {
+        const ScopedLock sl (asyncLoadLock);
+        pendingSourceChain = nullptr;
+        pendingLoadGeneration = -1;
+    }
+    
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void AudioFilePlayer::setScrubbing (bool shouldScrub)
+{
+    if (shouldScrub == isScrubbing())
+        return;
+    
+    if (shouldScrub)
+    {
+        const double sampleRate = getFileSampleRate();
+        
+        if (sampleRate <= 0.0)
+            return;
+        
+        AudioFormatReader* const reader = createScrubbingReader();
+        
+        if (reader == nullptr)
+            return;
+        
+        // keep a few seconds either side so the window never needs to catch up with a fast drag
+        ScopedPointer<ScrubbingAudioSource> newSource (new ScrubbingAudioSource (new AudioFormatReaderSource (reader, true), true,
+                                                                                 *getBufferingThreadForSource(),
+                                                                                 roundToInt (sampleRate * 3.0)));
+        newSource->prepareToPlay (preparedBlockSize, preparedSampleRate);
+        newSource->setNextReadPosition (secondsToSamples (audioTransportSource.getCurrentPosition(), sampleRate));
+        
+        const ScopedLock sl (scrubLock);
+        scrubbingAudioSource = newSource;
+    }
+    else
+    {
+        const double lastPosition = getCurrentPosition();
+        removeScrubbingAudioSource();
+        
+        audioTransportSource.setPosition (lastPosition);
+    }
+}
+
+void AudioFilePlayer::setScrubPosition (double newPositionInSeconds)
+{
+    if (scrubbingAudioSource != nullptr)
+        scrubbingAudioSource->setTargetPosition (newPositionInSeconds * getFileSampleRate());
+}
+
 //==============================================================================
 void AudioFilePlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
+    preparedBlockSize = samplesPerBlockExpected;
+    preparedSampleRate = sampleRate;
+    isPrepared = true;
+    
+    {
+        const ScopedLock sl (scrubLock);
+        
+        if (scrubbingAudioSource != nullptr)
+            scrubbingAudioSource->prepareToPlay (samplesPerBlockExpected, sampleRate);
+    }
+    
     if (masterSource != nullptr)
         masterSource->prepareToPlay (samplesPerBlockExpected, sampleRate);
 }
 
 void AudioFilePlayer::releaseResources()
 {
+    isPrepared = false;
+    
     if (masterSource != nullptr)
         masterSource->releaseResources();
 }
 
 void AudioFilePlayer::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-    if (masterSource != nullptr)
+    // the lock is only held briefly whilst scrubbing is started or stopped
+    const ScopedTryLock sl (scrubLock);
+    
+    if (! sl.isLocked())
+        bufferToFill.clearActiveBufferRegion();
+    else if (scrubbingAudioSource != nullptr)
+        scrubbingAudioSource->getNextAudioBlock (bufferToFill);
+    else if (masterSource != nullptr)
         masterSource->getNextAudioBlock (bufferToFill);
 }
 
@@ -139,7 +352,10 @@ void AudioFilePlayer::setLooping (bool shouldLoop)
 //==============================================================================
 bool AudioFilePlayer::fileChanged (const File& file)
 {
-    if (setSourceWithReader (formatManager->createReaderFor (file)))
+    cancelAsyncLoad();
+    removeScrubbingAudioSource();
+    
+    if (setSourceWithReader (createReaderFor (file, getLoadSettings())))
         return true;
     
     clear();
@@ -148,6 +364,19 @@ bool AudioFilePlayer::fileChanged (const File& file)
 
 bool AudioFilePlayer::streamChanged (InputStream* inputStream)
 {
+    cancelAsyncLoad();
+    removeScrubbingAudioSource();
+    
+   #if DROWAUDIO_USE_CURL
+    // reading a URL can block whilst it downloads so it gets a thread of its own
+    // rather than holding up the buffering of every other player sharing ours
+    if (getStreamingInputStream() != nullptr && streamingBufferingThread == nullptr)
+    {
+        streamingBufferingThread = new TimeSliceThread ("URL Buffering Thread");
+        streamingBufferingThread->startThread (3);
+    }
+   #endif
+    
     if (setSourceWithReader (formatManager->createReaderFor (inputStream)))
         return true;
     
@@ -173,37 +402,305 @@ void AudioFilePlayer::removeListener (AudioFilePlayer::Listener* const listener)
 }
 
 //==============================================================================
-bool AudioFilePlayer::setSourceWithReader (AudioFormatReader* reader)
+AudioFilePlayer::LoadSettings AudioFilePlayer::getLoadSettings() const
 {
-    bool shouldBeLooping = isLooping();
-	audioTransportSource.setSource (nullptr);
+    LoadSettings settings;
+    settings.formatManager = formatManager.get();
+    settings.bufferingThread = getBufferingThreadForSource();
+    settings.decodedAudioCache = decodedAudioCache;
+    settings.useMemoryMapping = useMemoryMapping;
+    settings.preloadIntoMemory = preloadIntoMemory;
+    settings.isPrepared = isPrepared;
+    settings.blockSize = preparedBlockSize;
+    settings.sampleRate = preparedSampleRate;
+    
+    return settings;
+}
 
-	if (reader != nullptr)
-	{										
-		// we SHOULD let the AudioFormatReaderSource delete the reader for us..
-		audioFormatReaderSource = new AudioFormatReaderSource (reader, true);
-        audioTransportSource.setSource (audioFormatReaderSource, 32768,
-                                        bufferingTimeSliceThread, reader->sampleRate);
-        
-        if (shouldBeLooping)
-            audioFormatReaderSource->setLooping (true);
-        
-		// let our listeners know that we have loaded a new file
-		audioTransportSource.sendChangeMessage();
-        listeners.call (&Listener::fileChanged, this);
+AudioFilePlayer::SourceChain* AudioFilePlayer::createSourceChain (AudioFormatReader* reader, const LoadSettings& settings)
+{
+    if (reader == nullptr)
+        return nullptr;
+    
+    SourceChain* newChain = new SourceChain();
+    newChain->sampleRate = reader->sampleRate;
 
-		return true;
-	}
-	
+    // we SHOULD let the AudioFormatReaderSource delete the reader for us..
+    newChain->readerSource = new AudioFormatReaderSource (reader, true);
+    
+    // memory mapped files can be read from directly so don't need buffering
+    if (isMemoryMappedReader (reader))
+    {
+        newChain->transportInput = newChain->readerSource;
+    }
+    else if (shouldPreloadReader (reader, settings))
+    {
+        newChain->preloadingSource = new PreloadingAudioSource (newChain->readerSource,
+                                                                *settings.bufferingThread,
+                                                                false);
+        newChain->transportInput = newChain->preloadingSource;
+    }
+    else
+    {
+        newChain->bufferingSource = new BufferingAudioSource (newChain->readerSource,
+                                                              *settings.bufferingThread,
+                                                              false, 32768);
+        newChain->transportInput = newChain->bufferingSource;
+    }
+    
+    return newChain;
+}
+
+bool AudioFilePlayer::setSourceChain (SourceChain* newChain)
+{
+    if (newChain != nullptr && isLooping())
+        newChain->readerSource->setLooping (true);
+    
+    swapSourceChain (newChain);
+    
+    // let our listeners know that we have loaded a new file
     audioTransportSource.sendChangeMessage();
     listeners.call (&Listener::fileChanged, this);
+    
+    return newChain != nullptr;
+}
+
+void AudioFilePlayer::swapSourceChain (SourceChain* newChain)
+{
+    ScopedPointer<SourceChain> oldChain (sourceChain.release());
+    sourceChain = newChain;
+    
+    if (newChain != nullptr)
+    {
+        audioFormatReaderSource = newChain->readerSource;
+        preloadingAudioSource = newChain->preloadingSource;
+        
+        // the chain does its own buffering so the transport is given the same
+        // settings each time and a chain prepared in advance doesn't need re-preparing
+        audioTransportSource.setSource (newChain->transportInput, 0,
+                                        nullptr, newChain->sampleRate);
+    }
+    else
+    {
+        audioFormatReaderSource = nullptr;
+        preloadingAudioSource = nullptr;
+        audioTransportSource.setSource (nullptr);
+    }
+    
+    if (oldChain != nullptr)
+        getLoadingThreadPool().addJob (new DeleteSourceChainJob (oldChain.release()), true);
+}
+
+bool AudioFilePlayer::setSourceWithReader (AudioFormatReader* reader)
+{
+    return setSourceChain (createSourceChain (reader, getLoadSettings()));
+}
+
+void AudioFilePlayer::stopLoadingThread()
+{
+    cancelAsyncLoad();
+    
+    // a load in progress uses the format manager, thread and cache, and an old
+    // chain waiting to be deleted is still registered with the buffering thread,
+    // so every job must be finished first. Any chains that haven't been reached
+    // yet are deleted here when their jobs are removed.
+    if (loadingThreadPool != nullptr)
+        loadingThreadPool->removeAllJobs (true, 10000);
+}
+
+//==============================================================================
+bool AudioFilePlayer::isMemoryMappedReader (AudioFormatReader* reader)
+{
+    return dynamic_cast<MemoryMappedAudioFormatReader*> (reader) != nullptr;
+}
 
-    return false;    
+bool AudioFilePlayer::shouldPreloadReader (AudioFormatReader* reader, const LoadSettings& settings)
+{
+    return settings.preloadIntoMemory
+            && ! isMemoryMappedReader (reader)
+            && PreloadingAudioSource::canPreload (reader->lengthInSamples);
 }
 
 //==============================================================================
 void AudioFilePlayer::commonInitialise()
 {
+    audioFormatReaderSource = nullptr;
+    preloadingAudioSource = nullptr;
+    useMemoryMapping = true;
+    preloadIntoMemory = false;
+    decodedAudioCache = nullptr;
+    pendingLoadGeneration = -1;
+    isLoadingFile = false;
+    preparedBlockSize = 512;
+    preparedSampleRate = 44100.0;
+    isPrepared = false;
+    outputLatency = 0;
     audioTransportSource.addChangeListener (this);
     masterSource = &audioTransportSource;
 }
+
+TimeSliceThread* AudioFilePlayer::getBufferingThreadForSource() const
+{
+   #if DROWAUDIO_USE_CURL
+    if (getStreamingInputStream() != nullptr && streamingBufferingThread != nullptr)
+        return streamingBufferingThread;
+   #endif
+    
+    return bufferingTimeSliceThread.get();
+}
+
+ThreadPool& AudioFilePlayer::getLoadingThreadPool()
+{
+    if (loadingThreadPool == nullptr)
+        loadingThreadPool = new ThreadPool (1);
+    
+    return *loadingThreadPool;
+}
+
+AudioFormatReader* AudioFilePlayer::createScrubbingReader()
+{
+    // the scrubber moves its reader around on the buffering thread so it needs one of its
+    // own rather than sharing the one the audio thread is playing from
+    switch (getInputType())
+    {
+        case file:
+            return createReaderFor (getFile(), getLoadSettings());
+        
+        case memoryBlock:
+        case memoryInputStream:
+        case urlStream:
+            return formatManager->createReaderFor (getInputStream());
+        
+        default:
+            return nullptr;
+    }
+}
+
+void AudioFilePlayer::removeScrubbingAudioSource()
+{
+    ScopedPointer<ScrubbingAudioSource> oldSource;
+    
+    {
+        const ScopedLock sl (scrubLock);
+        oldSource = scrubbingAudioSource.release();
+    }
+}
+
+double AudioFilePlayer::getFileSampleRate() const
+{
+    if (audioFormatReaderSource != nullptr && audioFormatReaderSource->getAudioFormatReader() != nullptr)
+        return audioFormatReaderSource->getAudioFormatReader()->sampleRate;
+    
+    return 0.0;
+}
+
+AudioFilePlayer::SourceChain* AudioFilePlayer::loadSourceChain (const File& file, const LoadSettings& settings)
+{
+    ScopedPointer<SourceChain> newChain (createSourceChain (createReaderFor (file, settings), settings));
+    
+    if (newChain != nullptr && settings.isPrepared && settings.sampleRate > 0.0)
+    {
+        // prepare it through a resampler like the transport does so when it's swapped in
+        // the transport's prepare sees the same settings and the buffers are already full
+        ResamplingAudioSource resampler (newChain->transportInput, false);
+        resampler.setResamplingRatio (newChain->sampleRate / settings.sampleRate);
+        resampler.prepareToPlay (settings.blockSize, settings.sampleRate);
+    }
+    
+    return newChain.release();
+}
+
+AudioFormatReader* AudioFilePlayer::createReaderFor (const File& file, const LoadSettings& settings)
+{
+    AudioFormatReader* reader = nullptr;
+    
+    if (settings.useMemoryMapping)
+        reader = createMemoryMappedReaderFor (file, *settings.formatManager);
+    
+    if (reader == nullptr && settings.decodedAudioCache != nullptr)
+    {
+        reader = settings.decodedAudioCache->createReaderFor (file);
+        
+        if (reader == nullptr)
+            settings.decodedAudioCache->addToCache (file);
+    }
+    
+    if (reader == nullptr)
+        reader = settings.formatManager->createReaderFor (file);
+    
+    return reader;
+}
+
+MemoryMappedAudioFormatReader* AudioFilePlayer::createMemoryMappedReaderFor (const File& file, AudioFormatManager& formatManager)
+{
+    for (int i = 0; i < formatManager.getNumKnownFormats(); ++i)
+    {
+        AudioFormat* const format = formatManager.getKnownFormat (i);
+        
+        if (format->canHandleFile (file))
+        {
+            ScopedPointer<MemoryMappedAudioFormatReader> reader (format->createMemoryMappedReader (file));
+            
+            if (reader != nullptr && reader->mapEntireFile())
+            {
+                // fault in the first couple of seconds now so starting
+                // playback doesn't have to wait for the disk
+                const int64 numSamplesToTouch = jmin (reader->lengthInSamples,
+                                                      (int64) (reader->sampleRate * 2.0));
+                
+                for (int64 sample = 0; sample < numSamplesToTouch; sample += 256)
+                    reader->touchSample (sample);
+                
+                return reader.release();
+            }
+        }
+    }
+    
+    return nullptr;
+}
+
+//==============================================================================
+void AudioFilePlayer::asyncLoadFinished (int generation, const File& file, SourceChain* newChain)
+{
+    ScopedPointer<SourceChain> chain (newChain);
+    
+    const ScopedLock sl (asyncLoadLock);
+    
+    if (generation == loadGeneration.get())
+    {
+        pendingSourceChain = chain.release();
+        pendingFile = file;
+        pendingLoadGeneration = generation;
+        
+        triggerAsyncUpdate();
+    }
+}
+
+void AudioFilePlayer::handleAsyncUpdate()
+{
+    ScopedPointer<SourceChain> newChain;
+    File file;
+    
+    {
+        const ScopedLock sl (asyncLoadLock);
+        
+        if (pendingLoadGeneration != loadGeneration.get())
+            return;
+        
+        newChain = pendingSourceChain.release();
+        file = pendingFile;
+        pendingLoadGeneration = -1;
+    }
+    
+    isLoadingFile = false;
+    
+    // the chain has been built and prepared on the loading thread so only needs swapping in
+    removeScrubbingAudioSource();
+    setCurrentFile (file);
+    const bool loadedOk = setSourceChain (newChain.release());
+    
+    if (! loadedOk)
+        clear();
+    
+    listeners.call (&Listener::asyncFileLoadFinished, this, file, loadedOk);
+}
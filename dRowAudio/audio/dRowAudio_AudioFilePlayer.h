@@ -33,6 +33,10 @@
 #define __DROWAUDIO_AUDIOFILEPLAYER_H__
 
 #include "../streams/dRowAudio_StreamAndFileHandler.h"
+#include "dRowAudio_PreloadingAudioSource.h"
+#include "dRowAudio_DecodedAudioCache.h"
+#include "dRowAudio_ScrubbingAudioSource.h"
+#include "dRowAudio_AudioSourceWithLatency.h"
 
 //==============================================================================
 /**
@@ -48,7 +52,9 @@
  */
 class AudioFilePlayer : public StreamAndFileHandler,
                         public PositionableAudioSource,
-                        public ChangeListener
+                        public AudioSourceWithLatency,
+                        public ChangeListener,
+                        private AsyncUpdater
 {
 public:
     //==============================================================================
@@ -98,8 +104,9 @@ public:
     virtual void setPosition (double newPosition, bool ignoreAnyLoopBounds = false);
     
     /** Returns the position that the next data block will be read from in seconds.
+        Whilst scrubbing this is the position set with setScrubPosition().
      */
-    double getCurrentPosition() const           { return audioTransportSource.getCurrentPosition();}
+    double getCurrentPosition() const;
     
     /** Returns the stream's length in seconds.
      */
@@ -109,6 +116,48 @@ public:
      */
     bool hasStreamFinished() const noexcept     { return audioTransportSource.hasStreamFinished(); }
     
+    /** Returns the number of seconds after the current position that can be
+        played without waiting for them to download.
+     
+        For files and memory this is the rest of the source. For a URL set with
+        setURL() it is estimated from how much of the stream has arrived, so to
+        start playing once the first few seconds are there, set the URL and wait
+        for this to reach the amount you want before calling start().
+     */
+    double getSecondsAvailable() const;
+    
+    //==============================================================================
+    /** Sets the number of samples between the player's output and the speakers.
+        This would usually be the audio device's output latency plus its buffer
+        size. It is added to the latency of the source chain by getAudiblePosition().
+     */
+    void setOutputLatency (int numSamples) noexcept     { outputLatency = jmax (0, numSamples); }
+    
+    /** Returns the output latency set with setOutputLatency().
+     */
+    int getOutputLatency() const noexcept               { return outputLatency; }
+    
+    /** Returns the latency of the player's source chain in output samples.
+        This doesn't include the output latency. The plain player doesn't delay
+        its audio so this returns 0, subclasses should add the latency of any
+        sources they use.
+     */
+    int getLatencySamples() const override              { return 0; }
+    
+    /** Returns the number of seconds of the file played for each second of output.
+        This is negative when playing backwards.
+     */
+    virtual double getPlaybackSpeed() const             { return 1.0; }
+    
+    /** Returns the position in seconds of the audio that can currently be heard.
+     
+        This is the value of getCurrentPosition() compensated for the latency of
+        the source chain and the output latency, so is the one to use for
+        displaying the playhead or syncing players together. Whilst scrubbing this
+        is the scrub position.
+     */
+    double getAudiblePosition() const;
+    
     //==============================================================================
 	/** Returns the AudioFormatReaderSource currently being used.
      */
@@ -119,6 +168,7 @@ public:
     inline AudioTransportSource* getAudioTransportSource()         {   return &audioTransportSource;         }
 
     /** Sets the AudioFormatManager to use.
+        Any file being loaded by setFileAsync() is cancelled.
      */
     void setAudioFormatManager (AudioFormatManager* newManager, bool deleteWhenNotNeeded);
     
@@ -127,6 +177,9 @@ public:
 	inline AudioFormatManager* getAudioFormatManager()             {   return formatManager;                }
 
     /** Sets the TimeSliceThread to use.
+        Any file being loaded by setFileAsync() is cancelled. A URL set with
+        setURL() is buffered on a thread of the player's own instead, as its reads
+        can block waiting for the download.
      */
     void setTimeSliceThread (TimeSliceThread* newThreadToUse, bool deleteWhenNotNeeded);
     
@@ -134,6 +187,111 @@ public:
      */
 	inline TimeSliceThread* getTimeSliceThread()                    {   return bufferingTimeSliceThread;    }
 
+    //==============================================================================
+    /** Sets whether uncompressed files should be played directly from a memory map.
+     
+        When this is enabled, files whose format can be memory mapped (e.g. WAV and
+        AIFF) are read using a MemoryMappedAudioFormatReader instead of going
+        through a BufferingAudioSource. This removes the background read-ahead and
+        its copy, makes seeking instant and lets several players share the
+        operating system's page cache. Other files are unaffected.
+     
+        This is enabled by default and takes effect the next time a file is loaded.
+     */
+    void setUsesMemoryMapping (bool shouldUseMemoryMapping)         {   useMemoryMapping = shouldUseMemoryMapping;  }
+    
+    /** Returns true if uncompressed files will be memory mapped.
+        @see setUsesMemoryMapping
+     */
+    bool getUsesMemoryMapping() const noexcept                      {   return useMemoryMapping;    }
+    
+    /** Returns true if the current file is being read from a memory map.
+     */
+    bool isMemoryMapped() const;
+
+    /** Sets whether files that can't be memory mapped should be loaded into memory.
+     
+        When this is enabled the whole of a compressed file is decoded into memory
+        on the background thread as soon as it is loaded. Playback can start as
+        soon as the first second is ready and once a section has been decoded,
+        seeking within it is instant. Use getPreloadingAudioSource() to find out
+        how much has been loaded.
+     
+        This is disabled by default and takes effect the next time a file is loaded.
+     */
+    void setPreloadsIntoMemory (bool shouldPreload)                 {   preloadIntoMemory = shouldPreload;  }
+    
+    /** Returns true if files will be loaded into memory.
+        @see setPreloadsIntoMemory
+     */
+    bool getPreloadsIntoMemory() const noexcept                     {   return preloadIntoMemory;   }
+    
+    /** Returns the PreloadingAudioSource loading the current file, or nullptr if
+        it isn't being loaded into memory.
+     */
+    inline PreloadingAudioSource* getPreloadingAudioSource()       {   return preloadingAudioSource;   }
+    
+    /** Sets a cache of decoded files to use.
+     
+        When a file is loaded that can't be memory mapped it is looked up in the
+        cache and if it has already been decoded the cached copy is played from a
+        memory map instead. If it hasn't, it is added to the cache in the background
+        so it will be next time it is loaded. The same cache can be shared between
+        lots of players and must stay in existence for as long as they use it.
+        Pass nullptr to stop using a cache.
+     */
+    void setDecodedAudioCache (DecodedAudioCache* cacheToUse)      {   decodedAudioCache = cacheToUse; }
+    
+    /** Returns the cache of decoded files being used, if any.
+     */
+    inline DecodedAudioCache* getDecodedAudioCache() const noexcept {   return decodedAudioCache;       }
+
+    //==============================================================================
+    /** Loads a file without blocking the calling thread.
+     
+        The file is opened and its sources created and filled on a background thread
+        so a slow disk or network share won't hold up the message thread. Once they
+        are ready the new sources are swapped in on the message thread, the listeners
+        are sent the usual fileChanged() callback and then asyncFileLoadFinished().
+        Until then the current file carries on playing.
+     
+        Calling this again, or setting a file or stream directly, before the load
+        has finished cancels it. This must be called from the message thread.
+     */
+    void setFileAsync (const File& newFile);
+    
+    /** Cancels any file being loaded by setFileAsync().
+     */
+    void cancelAsyncLoad();
+    
+    /** Returns true if a file is being loaded by setFileAsync().
+     */
+    bool isLoadingAsync() const noexcept                            {   return isLoadingFile;   }
+
+    //==============================================================================
+    /** Starts or stops scrubbing.
+     
+        Whilst scrubbing, a few seconds of audio either side of the scrub position
+        are decoded into memory and played straight from there, in either direction
+        and at whatever speed the position set with setScrubPosition() is moved.
+        The normal buffering and processing chain is bypassed so moving the position
+        doesn't flush anything. When scrubbing stops the transport is moved to the
+        last scrub position and carries on as it was.
+     
+        The audio is read with a reader of its own so scrubbing isn't available for
+        a stream the player can't make a copy of, i.e. an unknownStream.
+     */
+    void setScrubbing (bool shouldScrub);
+    
+    /** Returns true if the player is scrubbing.
+     */
+    bool isScrubbing() const noexcept                               {   return scrubbingAudioSource != nullptr; }
+    
+    /** Sets the position in seconds to scrub to.
+        This can be called as often as you like, e.g. on every mouse move.
+     */
+    void setScrubPosition (double newPositionInSeconds);
+
     //==============================================================================
     /** A class for receiving callbacks from a AudioFilePlayer.
 	 
@@ -166,6 +324,11 @@ public:
             e.g. playback rate, filter gain etc.
          */
         virtual void audioFilePlayerSettingChanged (AudioFilePlayer* /*player*/, int /*settingCode*/) {}
+        
+        /** Called when a file being loaded by setFileAsync() has finished loading.
+            This isn't called if the load was cancelled.
+         */
+        virtual void asyncFileLoadFinished (AudioFilePlayer* /*player*/, const File& /*file*/, bool /*loadedOk*/) {}
     };
 	
     /** Adds a listener to be called when this slider's value changes. */
@@ -216,24 +379,132 @@ protected:
 	OptionalScopedPointer<AudioFormatManager> formatManager;
 
     AudioSource* masterSource;
-    ScopedPointer<AudioFormatReaderSource> audioFormatReaderSource;
+    AudioFormatReaderSource* audioFormatReaderSource;
+    PreloadingAudioSource* preloadingAudioSource;
 	AudioTransportSource audioTransportSource;
 
     ListenerList <Listener> listeners;
 
     //==============================================================================
-    /** Sets up the audio chain when a new source is chosen.
+    /** The player's settings used to build a source chain.
+        These are copied on the message thread when a load starts so the chain can
+        be built on the loading thread without reading the player's members.
+     */
+    struct LoadSettings
+    {
+        AudioFormatManager* formatManager;
+        TimeSliceThread* bufferingThread;
+        DecodedAudioCache* decodedAudioCache;
+        bool useMemoryMapping, preloadIntoMemory;
+        bool isPrepared;
+        int blockSize;
+        double sampleRate;
+    };
+
+    /** The sources that read a file and feed the AudioTransportSource.
      
-        By default this will create a new AudioFormatReader source and attach it to the 
-        AudioTransportSource. If you want to add your own sources overide this method.
-        If you do change this make sure you set the masterSource member to the top level
-        of your audio source chain.
+        Subclasses that add their own sources should derive from this to hold them,
+        declaring each one after the source it reads from so they are deleted from
+        the top of the chain down.
      */
-	virtual bool setSourceWithReader (AudioFormatReader* reader);
+    struct SourceChain
+    {
+        SourceChain() : transportInput (nullptr), sampleRate (0.0)   {}
+        virtual ~SourceChain()                                        {}
+        
+        ScopedPointer<AudioFormatReaderSource> readerSource;
+        ScopedPointer<PreloadingAudioSource> preloadingSource;
+        ScopedPointer<BufferingAudioSource> bufferingSource;
+        
+        /** The top of the chain, this is the source given to the AudioTransportSource. */
+        PositionableAudioSource* transportInput;
+        double sampleRate;
+    };
+
+    /** Returns a copy of the settings needed to build a source chain. */
+    LoadSettings getLoadSettings() const;
+    
+    /** Creates the chain of sources to play a reader.
+     
+        This takes ownership of the reader and returns nullptr if it is nullptr.
+        It is called on the loading thread for setFileAsync() so it must only use
+        the settings passed in and not the player's members. If you want to add your
+        own sources override this and setSourceChain().
+     */
+    virtual SourceChain* createSourceChain (AudioFormatReader* reader, const LoadSettings& settings);
+    
+    /** Replaces the current sources with a chain made by createSourceChain().
+     
+        This is called on the message thread and takes ownership of the chain,
+        which can be nullptr to remove the current file. It returns true if there
+        is a new source to play. Overrides should call swapSourceChain() then
+        update their own sources, making sure the masterSource member is set to the
+        top level of the audio source chain, and tell the listeners.
+     */
+    virtual bool setSourceChain (SourceChain* newChain);
+    
+    /** Attaches a new chain to the AudioTransportSource.
+        The old chain is deleted on the loading thread so none of its sources'
+        background threads can hold up the caller.
+     */
+    void swapSourceChain (SourceChain* newChain);
+    
+    /** Creates a source chain for a reader and swaps it in straight away. */
+	bool setSourceWithReader (AudioFormatReader* reader);
+    
+    /** Cancels any load and waits for the loading thread to finish, including
+        deleting any old source chains it was holding on to. If you override createSourceChain() call this from your destructor, so a
+        load can't use your class whilst it's being deleted.
+     */
+    void stopLoadingThread();
+    
+    /** Returns true if the reader reads from a memory mapped file.
+        These readers don't need buffering so can be used directly on the audio thread.
+     */
+    static bool isMemoryMappedReader (AudioFormatReader* reader);
+    
+    /** Returns true if a file using this reader should be loaded into memory.
+        @see setPreloadsIntoMemory
+     */
+    static bool shouldPreloadReader (AudioFormatReader* reader, const LoadSettings& settings);
     
 private:
+    //==============================================================================
+    bool useMemoryMapping, preloadIntoMemory;
+    DecodedAudioCache* decodedAudioCache;
+    ScopedPointer<TimeSliceThread> streamingBufferingThread;
+    
+    class AsyncLoadJob;
+    class DeleteSourceChainJob;
+    ScopedPointer<ThreadPool> loadingThreadPool;
+    CriticalSection asyncLoadLock;
+    Atomic<int> loadGeneration;
+    int pendingLoadGeneration;
+    File pendingFile;
+    ScopedPointer<SourceChain> pendingSourceChain;
+    bool isLoadingFile;
+    
+    ScopedPointer<SourceChain> sourceChain;
+    
+    CriticalSection scrubLock;
+    ScopedPointer<ScrubbingAudioSource> scrubbingAudioSource;
+    int preparedBlockSize;
+    double preparedSampleRate;
+    bool isPrepared;
+    int volatile outputLatency;
+    
     //==============================================================================
     void commonInitialise();
+    TimeSliceThread* getBufferingThreadForSource() const;
+    ThreadPool& getLoadingThreadPool();
+    SourceChain* loadSourceChain (const File& file, const LoadSettings& settings);
+    static AudioFormatReader* createReaderFor (const File& file, const LoadSettings& settings);
+    static MemoryMappedAudioFormatReader* createMemoryMappedReaderFor (const File& file, AudioFormatManager& formatManager);
+    void asyncLoadFinished (int generation, const File& file, SourceChain* newChain);
+    AudioFormatReader* createScrubbingReader();
+    void removeScrubbingAudioSource();
+    double getFileSampleRate() const;
+    void handleAsyncUpdate() override;
     
     //==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFilePlayer);
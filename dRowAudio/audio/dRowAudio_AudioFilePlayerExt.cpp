@@ -33,8 +33,14 @@
 
 
 AudioFilePlayerExt::AudioFilePlayerExt()
+    : bufferingAudioSource (nullptr),
+      cueSnippetAudioSource (nullptr),
+      loopingAudioSource (nullptr),
+      soundTouchAudioSource (nullptr),
+      shouldBeLooping (false),
+      currentLoopStartTime (0.0),
+      currentLoopEndTime (0.0)
 {
-    loopingAudioSource = new LoopingAudioSource (&audioTransportSource, false);
     reversibleAudioSource = new ReversibleAudioSource (&audioTransportSource, false);
     filteringAudioSource = new FilteringAudioSource (reversibleAudioSource, false);
 
@@ -43,14 +49,26 @@ AudioFilePlayerExt::AudioFilePlayerExt()
 
 AudioFilePlayerExt::~AudioFilePlayerExt()
 {
+    stopLoadingThread();
     audioTransportSource.setSource (nullptr);
 }
 
+void AudioFilePlayerExt::setLibraryEntry (ValueTree newEntry)
+{
+    libraryEntry = newEntry;
+    updateCueSnippets();
+}
+
 void AudioFilePlayerExt::setPlaybackSettings (SoundTouchProcessor::PlaybackSettings newSettings)
 {
     currentSoundtouchSettings = newSettings;
     soundTouchAudioSource->setPlaybackSettings (newSettings);
+    updateBufferingPlayback();
     
+    // any cached loop start will have been processed with the old settings
+    if (loopingAudioSource != nullptr)
+        loopingAudioSource->invalidateLoopCache();
+
     listeners.call (&Listener::audioFilePlayerSettingChanged, this, SoundTouchSetting);
 }
 
@@ -65,6 +83,7 @@ SoundTouchProcessor::PlaybackSettings AudioFilePlayerExt::getPlaybackSettings()
 void AudioFilePlayerExt::setPlayDirection (bool shouldPlayForwards)
 {
     reversibleAudioSource->setPlayDirection (shouldPlayForwards);
+    updateBufferingPlayback();
 
     listeners.call (&Listener::audioFilePlayerSettingChanged, this, PlayDirectionSetting);
 }
@@ -87,7 +106,14 @@ void AudioFilePlayerExt::setLoopTimes (double startTime, double endTime)
     currentLoopStartTime = startTime;
     currentLoopEndTime = endTime;
     
-    loopingAudioSource->setLoopTimes (startTime, endTime);
+    if (loopingAudioSource != nullptr)
+        loopingAudioSource->setLoopTimes (startTime, endTime);
+}
+
+void AudioFilePlayerExt::getLoopTimes (double& startTime, double& endTime) const
+{
+    startTime = currentLoopStartTime;
+    endTime = currentLoopEndTime;
 }
 
 void AudioFilePlayerExt::setLoopBetweenTimes (bool shouldLoop)
@@ -124,32 +150,93 @@ void AudioFilePlayerExt::setPosition (double newPosition, bool ignoreAnyLoopBoun
 }
 
 //==============================================================================
-bool AudioFilePlayerExt::setSourceWithReader (AudioFormatReader* reader)
+int AudioFilePlayerExt::getLatencySamples() const
+{
+    // the transport breaks the chain so add each side of it separately
+    return AudioSourceWithLatency::getLatencySamplesOf (filteringAudioSource)
+            + AudioSourceWithLatency::getLatencySamplesOf (loopingAudioSource);
+}
+
+double AudioFilePlayerExt::getPlaybackSpeed() const
+{
+    const double speed = soundTouchAudioSource != nullptr
+                            ? soundTouchAudioSource->getSoundTouchProcessor().getEffectivePlaybackRatio()
+                            : 1.0;
+
+    return reversibleAudioSource->getPlayDirection() ? speed : -speed;
+}
+
+//==============================================================================
+AudioFilePlayer::SourceChain* AudioFilePlayerExt::createSourceChain (AudioFormatReader* reader, const LoadSettings& settings)
+{
+    if (reader == nullptr)
+        return nullptr;
+    
+    ExtSourceChain* newChain = new ExtSourceChain();
+    newChain->sampleRate = reader->sampleRate;
+
+    // we SHOULD let the AudioFormatReaderSource delete the reader for us..
+    newChain->readerSource = new AudioFormatReaderSource (reader, true);
+    
+    // memory mapped files can be read from directly so don't need buffering
+    if (isMemoryMappedReader (reader))
+    {
+        newChain->soundTouchSource = new SoundTouchAudioSource (newChain->readerSource);
+    }
+    else if (shouldPreloadReader (reader, settings))
+    {
+        newChain->preloadingSource = new PreloadingAudioSource (newChain->readerSource,
+                                                                *settings.bufferingThread,
+                                                                false);
+        newChain->soundTouchSource = new SoundTouchAudioSource (newChain->preloadingSource);
+    }
+    else
+    {
+        newChain->bidirectionalBufferingSource = new BidirectionalBufferingAudioSource (newChain->readerSource,
+                                                                                        *settings.bufferingThread,
+                                                                                        false,
+                                                                                        32768);
+
+        // jumps to cue points are played from memory whilst the buffer catches up
+        newChain->cueSnippetSource = new CueSnippetAudioSource (newChain->bidirectionalBufferingSource,
+                                                                newChain->readerSource,
+                                                                *settings.bufferingThread,
+                                                                (int) reader->sampleRate,
+                                                                false);
+        newChain->soundTouchSource = new SoundTouchAudioSource (newChain->cueSnippetSource);
+    }
+
+    newChain->loopingSource = new LoopingAudioSource (newChain->soundTouchSource, false);
+    newChain->transportInput = newChain->loopingSource;
+    
+    return newChain;
+}
+
+bool AudioFilePlayerExt::setSourceChain (SourceChain* newChain)
 {
     if (soundTouchAudioSource != nullptr)
         currentSoundtouchSettings = soundTouchAudioSource->getPlaybackSettings();
     
-	audioTransportSource.setSource (nullptr);
+    // the old sources are deleted on another thread once they've been swapped out
+    bufferingAudioSource = nullptr;
+    cueSnippetAudioSource = nullptr;
     loopingAudioSource = nullptr;
     soundTouchAudioSource = nullptr;
-    bufferingAudioSource = nullptr;
     
-	if (reader != nullptr)
-	{										
-		// we SHOULD let the AudioFormatReaderSource delete the reader for us..
-		audioFormatReaderSource = new AudioFormatReaderSource (reader, true);
-        bufferingAudioSource = new BufferingAudioSource (audioFormatReaderSource,
-                                                         *bufferingTimeSliceThread,
-                                                         false,
-                                                         32768);
-        soundTouchAudioSource = new SoundTouchAudioSource (bufferingAudioSource);
-        loopingAudioSource = new LoopingAudioSource (soundTouchAudioSource, false);
-        loopingAudioSource->setLoopBetweenTimes (shouldBeLooping);
+    swapSourceChain (newChain);
+    
+	if (ExtSourceChain* const chain = static_cast<ExtSourceChain*> (newChain))
+	{
+        bufferingAudioSource = chain->bidirectionalBufferingSource;
+        cueSnippetAudioSource = chain->cueSnippetSource;
+        loopingAudioSource = chain->loopingSource;
+        soundTouchAudioSource = chain->soundTouchSource;
+
         updateLoopTimes();
-        
-        audioTransportSource.setSource (loopingAudioSource,
-                                        0, nullptr,
-                                        reader->sampleRate);
+        loopingAudioSource->setLoopTimes (currentLoopStartTime, currentLoopEndTime);
+        loopingAudioSource->setLoopBetweenTimes (shouldBeLooping);
+        updateCueSnippets();
+        updateBufferingPlayback();
         
         listeners.call (&Listener::fileChanged, this);
         setPlaybackSettings (currentSoundtouchSettings);
@@ -172,4 +259,42 @@ void AudioFilePlayerExt::updateLoopTimes()
         currentLoopStartTime = jmax (0.0, currentLoopEndTime - 1.0);
 }
 
+void AudioFilePlayerExt::updateBufferingPlayback()
+{
+    // the buffer can't tell which way it's being played from the read position
+    // as SoundTouch reads several chunks forwards for each reverse step
+    if (bufferingAudioSource == nullptr)
+        return;
+
+    bufferingAudioSource->setPlaybackDirection (reversibleAudioSource->getPlayDirection());
+    bufferingAudioSource->setPlaybackSpeed (soundTouchAudioSource->getSoundTouchProcessor().getEffectivePlaybackRatio());
+}
+
+void AudioFilePlayerExt::updateCueSnippets()
+{
+    if (cueSnippetAudioSource == nullptr)
+        return;
+
+    const double sampleRate = audioFormatReaderSource->getAudioFormatReader()->sampleRate;
+    Array<int64> cueSamplePositions;
+
+    ValueTree cueTree (libraryEntry.getChildWithName (MusicColumns::libraryCuePointIdentifier));
+
+    for (int i = 0; i < cueTree.getNumProperties(); ++i)
+        cueSamplePositions.add (secondsToSamples (LoopAndCueHelpers::getTimeFromCueTree (cueTree, i), sampleRate));
+
+    ValueTree loopTree (libraryEntry.getChildWithName (MusicColumns::libraryLoopIdentifier));
+
+    for (int i = 0; i < loopTree.getNumProperties(); ++i)
+    {
+        double startTime, endTime;
+        uint32 colour;
+        LoopAndCueHelpers::getTimeAndColourFromLoopTree (loopTree, i, startTime, endTime, colour);
+
+        cueSamplePositions.add (secondsToSamples (startTime, sampleRate));
+    }
+
+    cueSnippetAudioSource->setCuePoints (cueSamplePositions);
+}
+
 #endif
@@ -37,6 +37,8 @@
 #include "dRowAudio_SoundTouchAudioSource.h"
 #include "dRowAudio_ReversibleAudioSource.h"
 #include "dRowAudio_LoopingAudioSource.h"
+#include "dRowAudio_BidirectionalBufferingAudioSource.h"
+#include "dRowAudio_CueSnippetAudioSource.h"
 #include "dRowAudio_FilteringAudioSource.h"
 
 //==============================================================================
@@ -73,8 +75,11 @@ public:
 	
     //==============================================================================
     /** Sets the current library entry.
+        Any cue points and loop starts in the entry will have a short snippet of
+        audio kept in memory so they can be jumped to without waiting for the
+        buffer to refill.
      */
-    void setLibraryEntry (ValueTree newEntry)               {   libraryEntry = newEntry;    }
+    void setLibraryEntry (ValueTree newEntry);
 
     /** Returns the currents library entry.
      */
@@ -107,6 +112,10 @@ public:
      */
 	void setLoopTimes (double startTime, double endTime);
 	
+    /** Returns the start and end times of the loop.
+     */
+    void getLoopTimes (double& startTime, double& endTime) const;
+
     /** Enables the loop point set.
      */
     void setLoopBetweenTimes (bool shouldLoop);
@@ -119,6 +128,18 @@ public:
      */
     void setPosition (double newPosition, bool ignoreAnyLoopBounds = false);
     
+    //==============================================================================
+    /** Returns the latency of the processing chain in output samples.
+        This is mostly the time stretching so is only approximate, and can be
+        negative as SoundTouch tends to run ahead of its position.
+     */
+    int getLatencySamples() const;
+
+    /** Returns the number of seconds of the file played for each second of output,
+        taking into account the SoundTouch settings and the play direction.
+     */
+    double getPlaybackSpeed() const;
+
     //==============================================================================
     /** Returns the SoundTouchAudioSource being used.
      */
@@ -130,9 +151,20 @@ public:
     
 private:	
     //==============================================================================
-    ScopedPointer<BufferingAudioSource> bufferingAudioSource;
-    ScopedPointer<LoopingAudioSource> loopingAudioSource;
-    ScopedPointer<SoundTouchAudioSource> soundTouchAudioSource;
+    struct ExtSourceChain  : public SourceChain
+    {
+        ScopedPointer<BidirectionalBufferingAudioSource> bidirectionalBufferingSource;
+        ScopedPointer<CueSnippetAudioSource> cueSnippetSource;
+        ScopedPointer<SoundTouchAudioSource> soundTouchSource;
+        ScopedPointer<LoopingAudioSource> loopingSource;
+    };
+
+    // these belong to the current source chain
+    BidirectionalBufferingAudioSource* bufferingAudioSource;
+    CueSnippetAudioSource* cueSnippetAudioSource;
+    LoopingAudioSource* loopingAudioSource;
+    SoundTouchAudioSource* soundTouchAudioSource;
+
     ScopedPointer<ReversibleAudioSource> reversibleAudioSource;
     ScopedPointer<FilteringAudioSource> filteringAudioSource;
 
@@ -143,8 +175,11 @@ private:
     ValueTree libraryEntry;
 
     //==============================================================================
-	bool setSourceWithReader (AudioFormatReader* reader);
+    SourceChain* createSourceChain (AudioFormatReader* reader, const LoadSettings& settings) override;
+    bool setSourceChain (SourceChain* newChain) override;
     void updateLoopTimes();
+    void updateCueSnippets();
+    void updateBufferingPlayback();
     
     //==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFilePlayerExt);
@@ -35,9 +35,72 @@
 namespace
 {
     const char* const audioSampleBufferAudioFormatName = "AudioSampleBuffer format stream";
+    const char* const audioSampleBufferFileExtension = ".asb";
+
+    const int audioSampleBufferFileMagic = (int) ByteOrder::littleEndianInt ("dRAB");
+    const int audioSampleBufferFileVersion = 1;
+    const int audioSampleBufferFileHeaderSize = 32;
+    const int audioSampleBufferFileBlockSize = 8192;
+
+    bool clearSamplesPastEnd (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                              int64 startSampleInFile, int& numSamples, int64 lengthInSamples) noexcept
+    {
+        const int64 samplesAvailable = lengthInSamples - startSampleInFile;
+
+        if (samplesAvailable < numSamples)
+        {
+            for (int i = numDestChannels; --i >= 0;)
+                if (destSamples[i] != nullptr)
+                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+            numSamples = (int) samplesAvailable;
+        }
+
+        return numSamples > 0;
+    }
 }
 
 //==============================================================================
+/*  Files start with a 32 byte header:
+        int32   magic number 'dRAB'
+        int32   version
+        int32   number of channels
+        int32   number of samples per channel in each block
+        double  sample rate
+        int64   length in samples
+    followed by the blocks. Each holds the block's samples for the first
+    channel, then the second channel and so on. Only the last block can
+    be shorter than the block size.
+ */
+struct AudioSampleBufferFileLayout
+{
+    AudioSampleBufferFileLayout() noexcept
+        : numChannels (0), blockSize (audioSampleBufferFileBlockSize), lengthInSamples (0)
+    {
+    }
+
+    int64 getSamplePosition (int channel, int64 sample) const noexcept
+    {
+        const int64 blockStart = sample - sample % blockSize;
+        const int64 numInBlock = jmin ((int64) blockSize, lengthInSamples - blockStart);
+
+        return audioSampleBufferFileHeaderSize
+                + (blockStart * numChannels + channel * numInBlock + sample - blockStart) * (int64) sizeof (float);
+    }
+
+    int getNumSamplesLeftInBlock (int64 sample) const noexcept
+    {
+        return blockSize - (int) (sample % blockSize);
+    }
+
+    int numChannels, blockSize;
+    int64 lengthInSamples;
+};
+
+//==============================================================================
+/*  Reads from the memory layout of an AudioSampleBuffer, i.e. a null terminated
+    list of channel pointers followed by each channel's samples.
+ */
 class AudioSampleBufferReader : public AudioFormatReader
 {
 public:
@@ -64,41 +127,27 @@ public:
                       int64 startSampleInFile, int numSamples)
     {
         jassert (destSamples != nullptr);
-        const int64 samplesAvailable = lengthInSamples - startSampleInFile;
         
-        if (samplesAvailable < numSamples)
-        {
-            for (int i = numDestChannels; --i >= 0;)
-                if (destSamples[i] != nullptr)
-                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * numSamples);
-            
-            numSamples = (int) samplesAvailable;
-        }
-        
-        if (numSamples <= 0)
+        if (! clearSamplesPastEnd (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                   startSampleInFile, numSamples, lengthInSamples))
             return true;
         
-        while (numSamples > 0)
+        const int numBytes = numSamples * (int) sizeof (float);
+        
+        for (int c = 0; c < numDestChannels; ++c)
         {
-            const int numThisTime = jmin (8192, numSamples);
-            const int numBytes = numThisTime * sizeof (float);
+            if (destSamples[c] == nullptr)
+                continue;
             
-            for (int c = (int) numChannels; --c >= 0;)
+            if (c < (int) numChannels)
             {
-                const int64 pos = sampleToReadPosition (c, startSampleInFile);
-                input->setPosition (pos);
-                
-                if (destSamples[c] != nullptr)
-                {
-                    if (c < (int) numChannels)
-                        input->read (destSamples[c] + startOffsetInDestBuffer, numBytes);
-                    else
-                        zeromem (destSamples[c] + startOffsetInDestBuffer, numBytes);
-                }
+                input->setPosition (sampleToReadPosition (c, startSampleInFile));
+                input->read (destSamples[c] + startOffsetInDestBuffer, numBytes);
+            }
+            else
+            {
+                zeromem (destSamples[c] + startOffsetInDestBuffer, (size_t) numBytes);
             }
-            
-            startOffsetInDestBuffer += numThisTime;
-            numSamples -= numThisTime;
         }
         
         return true;
@@ -119,24 +168,319 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSampleBufferReader);
 };
 
+//==============================================================================
+class AudioSampleBufferFileReader : public AudioFormatReader
+{
+public:
+    AudioSampleBufferFileReader (InputStream* const inp)
+        : AudioFormatReader (inp, TRANS (audioSampleBufferAudioFormatName)),
+          ok (false)
+    {
+        usesFloatingPointData = true;
+        bitsPerSample = 32;
+        
+        if (inp != nullptr
+             && inp->readInt() == audioSampleBufferFileMagic
+             && inp->readInt() == audioSampleBufferFileVersion)
+        {
+            numChannels = (unsigned int) inp->readInt();
+            layout.blockSize = inp->readInt();
+            sampleRate = inp->readDouble();
+            lengthInSamples = inp->readInt64();
+            
+            layout.numChannels = (int) numChannels;
+            layout.lengthInSamples = lengthInSamples;
+            
+            ok = numChannels > 0 && layout.blockSize > 0 && sampleRate > 0 && lengthInSamples >= 0
+                  && inp->getTotalLength() >= AudioSampleBufferAudioFormat::getFileSize ((int) numChannels, lengthInSamples);
+        }
+    }
+    
+    //==============================================================================
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples)
+    {
+        if (! clearSamplesPastEnd (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                   startSampleInFile, numSamples, lengthInSamples))
+            return true;
+        
+        for (int c = 0; c < numDestChannels; ++c)
+        {
+            if (destSamples[c] == nullptr)
+                continue;
+            
+            if (c >= (int) numChannels)
+            {
+                zeromem (destSamples[c] + startOffsetInDestBuffer, sizeof (float) * (size_t) numSamples);
+                continue;
+            }
+            
+            float* dest = reinterpret_cast<float*> (destSamples[c] + startOffsetInDestBuffer);
+            int64 sample = startSampleInFile;
+            
+            for (int numLeft = numSamples; numLeft > 0;)
+            {
+                const int numThisTime = jmin (numLeft, layout.getNumSamplesLeftInBlock (sample));
+                
+                input->setPosition (layout.getSamplePosition (c, sample));
+                input->read (dest, numThisTime * (int) sizeof (float));
+                
+                dest += numThisTime;
+                sample += numThisTime;
+                numLeft -= numThisTime;
+            }
+        }
+        
+        return true;
+    }
+    
+    AudioSampleBufferFileLayout layout;
+    bool ok;
+    
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSampleBufferFileReader);
+};
+
+//==============================================================================
+class MemoryMappedAudioSampleBufferReader : public MemoryMappedAudioFormatReader
+{
+public:
+    MemoryMappedAudioSampleBufferReader (const File& file, const AudioSampleBufferFileReader& details)
+        : MemoryMappedAudioFormatReader (file, details, audioSampleBufferFileHeaderSize,
+                                         details.lengthInSamples * details.numChannels * (int64) sizeof (float),
+                                         (int) (details.numChannels * sizeof (float))),
+          layout (details.layout)
+    {
+    }
+    
+    //==============================================================================
+    /*  The channels are stored in blocks so only the sections of them that are
+        within the mapped range can be read. Use mapEntireFile() to be able to
+        read everything.
+     */
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples)
+    {
+        if (! clearSamplesPastEnd (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                   startSampleInFile, numSamples, lengthInSamples))
+            return true;
+        
+        bool allMapped = true;
+        
+        for (int c = 0; c < numDestChannels; ++c)
+        {
+            if (destSamples[c] == nullptr)
+                continue;
+            
+            float* dest = reinterpret_cast<float*> (destSamples[c] + startOffsetInDestBuffer);
+            
+            if (c >= (int) numChannels)
+            {
+                zeromem (dest, sizeof (float) * (size_t) numSamples);
+                continue;
+            }
+            
+            int64 sample = startSampleInFile;
+            
+            for (int numLeft = numSamples; numLeft > 0;)
+            {
+                const int numThisTime = jmin (numLeft, layout.getNumSamplesLeftInBlock (sample));
+                
+                if (const float* const source = getChannelData (c, sample, numThisTime))
+                {
+                    memcpy (dest, source, sizeof (float) * (size_t) numThisTime);
+                }
+                else
+                {
+                    zeromem (dest, sizeof (float) * (size_t) numThisTime);
+                    allMapped = false;
+                }
+                
+                dest += numThisTime;
+                sample += numThisTime;
+                numLeft -= numThisTime;
+            }
+        }
+        
+        jassert (allMapped); // trying to read a section that hasn't been mapped
+        return allMapped;
+    }
+    
+    void getSample (int64 sample, float* result) const noexcept
+    {
+        for (int c = 0; c < (int) numChannels; ++c)
+        {
+            const float* const source = isPositiveAndBelow (sample, lengthInSamples)
+                                            ? getChannelData (c, sample, 1) : nullptr;
+            
+            result[c] = source != nullptr ? *source : 0.0f;
+        }
+    }
+    
+private:
+    const AudioSampleBufferFileLayout layout;
+    
+    const float* getChannelData (int channel, int64 sample, int numSamples) const noexcept
+    {
+        if (map == nullptr)
+            return nullptr;
+        
+        const Range<int64> mappedBytes (map->getRange());
+        const int64 start = layout.getSamplePosition (channel, sample);
+        
+        if (start < mappedBytes.getStart() || start + numSamples * (int64) sizeof (float) > mappedBytes.getEnd())
+            return nullptr;
+        
+        return addBytesToPointer (static_cast<const float*> (map->getData()), start - mappedBytes.getStart());
+    }
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedAudioSampleBufferReader);
+};
+
+//==============================================================================
+class AudioSampleBufferWriter : public AudioFormatWriter
+{
+public:
+    AudioSampleBufferWriter (OutputStream* const out, double sampleRate_, unsigned int numChannels_)
+        : AudioFormatWriter (out, TRANS (audioSampleBufferAudioFormatName), sampleRate_, numChannels_, 32),
+          headerPosition (out->getPosition()),
+          lengthInSamples (0),
+          numBuffered (0),
+          writeFailed (false)
+    {
+        usesFloatingPointData = true;
+        block.allocate ((size_t) numChannels * audioSampleBufferFileBlockSize, true);
+        
+        writeHeader();
+    }
+    
+    ~AudioSampleBufferWriter()
+    {
+        writeBlock();
+        
+        // go back and fill in the length
+        const int64 endPosition = output->getPosition();
+        
+        if (output->setPosition (headerPosition))
+        {
+            writeHeader();
+            output->setPosition (endPosition);
+        }
+        else
+        {
+            jassertfalse; // the stream needs to be able to seek back to the header
+        }
+        
+        output->flush();
+    }
+    
+    //==============================================================================
+    bool write (const int** data, int numSamples)
+    {
+        jassert (data != nullptr && *data != nullptr); // the input must contain at least one channel!
+        
+        if (writeFailed)
+            return false;
+        
+        for (int offset = 0; offset < numSamples;)
+        {
+            const int numThisTime = jmin (numSamples - offset, audioSampleBufferFileBlockSize - numBuffered);
+            bool reachedLastChannel = false;
+            
+            for (int c = 0; c < (int) numChannels; ++c)
+            {
+                // the channel list is null terminated so any missing channels are written as silence
+                reachedLastChannel = reachedLastChannel || data[c] == nullptr;
+                float* const dest = block + c * audioSampleBufferFileBlockSize + numBuffered;
+                
+                if (reachedLastChannel)
+                    zeromem (dest, sizeof (float) * (size_t) numThisTime);
+                else
+                    memcpy (dest, data[c] + offset, sizeof (float) * (size_t) numThisTime);
+            }
+            
+            numBuffered += numThisTime;
+            lengthInSamples += numThisTime;
+            offset += numThisTime;
+            
+            if (numBuffered == audioSampleBufferFileBlockSize && ! writeBlock())
+                return false;
+        }
+        
+        return true;
+    }
+    
+private:
+    //==============================================================================
+    HeapBlock<float> block;
+    const int64 headerPosition;
+    int64 lengthInSamples;
+    int numBuffered;
+    bool writeFailed;
+    
+    void writeHeader()
+    {
+        output->writeInt (audioSampleBufferFileMagic);
+        output->writeInt (audioSampleBufferFileVersion);
+        output->writeInt ((int) numChannels);
+        output->writeInt (audioSampleBufferFileBlockSize);
+        output->writeDouble (sampleRate);
+        output->writeInt64 (lengthInSamples);
+    }
+    
+    bool writeBlock()
+    {
+        for (int c = 0; c < (int) numChannels && ! writeFailed; ++c)
+            writeFailed = ! output->write (block + c * audioSampleBufferFileBlockSize,
+                                           sizeof (float) * (size_t) numBuffered);
+        
+        numBuffered = 0;
+        
+        return ! writeFailed;
+    }
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSampleBufferWriter);
+};
+
 //==============================================================================
 AudioSampleBufferAudioFormat::AudioSampleBufferAudioFormat()
-: AudioFormat (TRANS (audioSampleBufferAudioFormatName), StringArray())
+: AudioFormat (TRANS (audioSampleBufferAudioFormatName), StringArray (audioSampleBufferFileExtension))
 {
 }
 
 AudioSampleBufferAudioFormat::~AudioSampleBufferAudioFormat() {}
 
 Array<int> AudioSampleBufferAudioFormat::getPossibleSampleRates()    { return Array<int>(); }
-Array<int> AudioSampleBufferAudioFormat::getPossibleBitDepths()      { return Array<int>(); }
+Array<int> AudioSampleBufferAudioFormat::getPossibleBitDepths()      { return Array<int> (32); }
 
 bool AudioSampleBufferAudioFormat::canDoStereo()     { return true; }
 bool AudioSampleBufferAudioFormat::canDoMono()       { return true; }
 
+int64 AudioSampleBufferAudioFormat::getFileSize (int numChannels, int64 numSamples) noexcept
+{
+    return audioSampleBufferFileHeaderSize + numChannels * numSamples * (int64) sizeof (float);
+}
+
 //==============================================================================
 AudioFormatReader* AudioSampleBufferAudioFormat::createReaderFor (InputStream* sourceStream,
                                                                   bool deleteStreamIfOpeningFails)
 {
+    if (sourceStream == nullptr)
+        return nullptr;
+    
+    const int64 startPosition = sourceStream->getPosition();
+    
+    {
+        ScopedPointer<AudioSampleBufferFileReader> r (new AudioSampleBufferFileReader (sourceStream));
+        
+        if (r->ok)
+            return r.release();
+        
+        r->input = nullptr;
+    }
+    
+    sourceStream->setPosition (startPosition);
+    
     ScopedPointer<AudioSampleBufferReader> r (new AudioSampleBufferReader (sourceStream));
     
     if (r->ok)
@@ -148,14 +492,29 @@ AudioFormatReader* AudioSampleBufferAudioFormat::createReaderFor (InputStream* s
     return nullptr;
 }
 
-AudioFormatWriter* AudioSampleBufferAudioFormat::createWriterFor (OutputStream* /*streamToWriteTo*/,
-                                                                  double /*sampleRateToUse*/,
-                                                                  unsigned int /*numberOfChannels*/,
+MemoryMappedAudioFormatReader* AudioSampleBufferAudioFormat::createMemoryMappedReader (const File& file)
+{
+    if (FileInputStream* const fin = file.createInputStream())
+    {
+        AudioSampleBufferFileReader details (fin);
+        
+        if (details.ok)
+            return new MemoryMappedAudioSampleBufferReader (file, details);
+    }
+    
+    return nullptr;
+}
+
+AudioFormatWriter* AudioSampleBufferAudioFormat::createWriterFor (OutputStream* streamToWriteTo,
+                                                                  double sampleRateToUse,
+                                                                  unsigned int numberOfChannels,
                                                                   int /*bitsPerSample*/,
                                                                   const StringPairArray& /*metadataValues*/,
                                                                   int /*qualityOptionIndex*/)
 {
-    jassertfalse; // not yet implemented!
-    return nullptr;
+    // the samples are always written as 32-bit floats
+    if (streamToWriteTo == nullptr || numberOfChannels == 0 || sampleRateToUse <= 0.0)
+        return nullptr;
+    
+    return new AudioSampleBufferWriter (streamToWriteTo, sampleRateToUse, numberOfChannels);
 }
-
@@ -34,14 +34,24 @@
 
 //==============================================================================
 /**
-    Streams data from an AudioSampleBuffer.
+    Reads and writes planar 32-bit float audio.
  
-    This reads from a stream that has been initialised from the AudioSampleBuffer
-    method getArrayOfChannels(). The AudioSampleBuffer needs to stay in exisistance
-    for the duration of this object and not be changed as the stream is unique to
-    the memory layout of the buffer.
+    This is intended as a fast interchange and cache format. Files start with a
+    small header giving the number of channels, sample rate and length, followed
+    by the samples stored as floats in blocks of up to 8192 samples per channel,
+    each block holding one channel after the other. This means the writer can
+    stream the data without knowing the length up front and the readers can
+    copy runs of samples for each channel straight into the destination buffer.
+    Files can be memory mapped with createMemoryMappedReader(), in which case
+    the samples are copied straight out of the mapping. The samples use the
+    machine's native byte order.
  
-    @see AudioFormat
+    For compatibility this can also read from a stream that has been initialised
+    from the AudioSampleBuffer method getArrayOfReadPointers(). In that case the
+    AudioSampleBuffer needs to stay in exisistance for the duration of the reader
+    and not be changed as the stream is unique to the memory layout of the buffer.
+ 
+    @see AudioFormat, DecodedAudioCache
  */
 class AudioSampleBufferAudioFormat :    public AudioFormat
 {
@@ -63,6 +73,12 @@ public:
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
     
+    MemoryMappedAudioFormatReader* createMemoryMappedReader (const File& file);
+    
+    /** Creates a writer that streams planar float blocks to the stream.
+        The stream must be able to seek back to where it started so that the
+        length can be written to the header when the writer is deleted.
+     */
     AudioFormatWriter* createWriterFor (OutputStream* streamToWriteTo,
                                         double sampleRateToUse,
                                         unsigned int numberOfChannels,
@@ -70,9 +86,13 @@ public:
                                         const StringPairArray& metadataValues,
                                         int qualityOptionIndex);
     
+    //==============================================================================
+    /** Returns the number of bytes a file holding a number of samples will take up. */
+    static int64 getFileSize (int numChannels, int64 numSamples) noexcept;
+    
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSampleBufferAudioFormat);
 };
 
 
-#endif // __DROWAUDIO_AUDIOSAMPLEBUFFERAUDIOFORMAT_H__
\ No newline at end of file
+#endif // __DROWAUDIO_AUDIOSAMPLEBUFFERAUDIOFORMAT_H__
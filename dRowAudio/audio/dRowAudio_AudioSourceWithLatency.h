@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_AUDIOSOURCEWITHLATENCY_H__
+#define __DROWAUDIO_AUDIOSOURCEWITHLATENCY_H__
+
+//==============================================================================
+/** An interface for AudioSources that can report the latency of the audio they
+    produce.
+
+    The latency is the number of output samples by which the audio coming out of
+    the source lags behind the position it has reported. It includes the latency
+    of any sources it reads from so the value at the top of a chain is the total
+    for the chain. A negative value means the audio is ahead of the position.
+
+    @see AudioFilePlayer::getAudiblePosition
+ */
+class AudioSourceWithLatency
+{
+public:
+    //==============================================================================
+    /** Destructor. */
+    virtual ~AudioSourceWithLatency() {}
+
+    /** Returns the latency of this source and its inputs in output samples. */
+    virtual int getLatencySamples() const = 0;
+
+    //==============================================================================
+    /** Returns the latency of any AudioSource.
+        Sources that don't implement this interface are assumed to have none.
+     */
+    static int getLatencySamplesOf (const AudioSource* source)
+    {
+        if (const AudioSourceWithLatency* const s = dynamic_cast<const AudioSourceWithLatency*> (source))
+            return s->getLatencySamples();
+
+        return 0;
+    }
+};
+
+#endif // __DROWAUDIO_AUDIOSOURCEWITHLATENCY_H__
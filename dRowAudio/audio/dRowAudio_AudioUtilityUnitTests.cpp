@@ -85,11 +85,325 @@ public:
             expectEquals ((int) numChannels, 3);
             expectEquals ((int) numSamples, 256);
         }
+        
+        {
+            AudioSampleBuffer buffer (2, 10000);
+            buffer.clear();
+            buffer.setSample (1, 9000, 0.5f);
+            
+            AudioSampleBufferAudioFormat format;
+            ScopedPointer<AudioFormatReader> reader (format.createReaderFor (new MemoryInputStream (buffer.getArrayOfReadPointers(),
+                                                                                                  getNumBytesForAudioSampleBuffer (buffer),
+                                                                                                  false), true));
+            expect (reader != nullptr);
+            
+            AudioSampleBuffer dest (2, 10000);
+            reader->read (&dest, 0, 10000, 0, true, true);
+            expectEquals (dest.getSample (1, 9000), 0.5f);
+        }
+        
+        {
+            const int numChannels = 3, numSamples = 20000;
+            AudioSampleBuffer source (numChannels, numSamples);
+            
+            for (int c = 0; c < numChannels; ++c)
+                for (int i = 0; i < numSamples; ++i)
+                    source.setSample (c, i, (float) (c * numSamples + i));
+            
+            MemoryBlock data;
+            AudioSampleBufferAudioFormat format;
+            
+            {
+                ScopedPointer<AudioFormatWriter> writer (format.createWriterFor (new MemoryOutputStream (data, false), 48000.0,
+                                                                                 numChannels, 32, StringPairArray(), 0));
+                expect (writer != nullptr);
+                expect (writer->writeFromAudioSampleBuffer (source, 0, 5000));
+                expect (writer->writeFromAudioSampleBuffer (source, 5000, numSamples - 5000));
+            }
+            
+            expect ((int64) data.getSize() == AudioSampleBufferAudioFormat::getFileSize (numChannels, numSamples));
+            
+            ScopedPointer<AudioFormatReader> reader (format.createReaderFor (new MemoryInputStream (data, false), true));
+            expect (reader != nullptr);
+            expectEquals ((int) reader->numChannels, numChannels);
+            expectEquals (reader->sampleRate, 48000.0);
+            expect (reader->lengthInSamples == numSamples);
+            
+            // read across a block boundary and into the last, partial block
+            AudioSampleBuffer dest (numChannels, 10000);
+            reader->read (&dest, 0, 10000, 8000, true, true);
+            expectEquals (dest.getSample (2, 0), source.getSample (2, 8000));
+            expectEquals (dest.getSample (0, 192), source.getSample (0, 8192));
+            expectEquals (dest.getSample (1, 9999), source.getSample (1, 17999));
+        }
     }
 };
 
 static AudioSampleBufferUnitTests audioSampleBufferUnitTests;
 
+//==============================================================================
+class FilteringAudioSourceUnitTests  : public UnitTest
+{
+public:
+    FilteringAudioSourceUnitTests() : UnitTest ("FilteringAudioSourceUnitTests") {}
+
+    void runTest()
+    {
+        beginTest ("Isolator bands at unity gain sum to an all pass");
+
+        const double frequencies[] = { 40.0, 300.0, 1000.0, 4000.0, 15000.0 };
+
+        for (int i = 0; i < numElementsInArray (frequencies); ++i)
+            expect (std::abs (getIsolatorGainInDecibels (frequencies[i], 1.0f, 1.0f, 1.0f)) < 0.1,
+                    String (frequencies[i]) + " Hz isn't passed at unity gain");
+
+        beginTest ("Isolator gain of 0 removes a band");
+
+        expect (getIsolatorGainInDecibels (40.0, 0.0f, 1.0f, 1.0f) < -30.0);
+        expect (getIsolatorGainInDecibels (1000.0, 1.0f, 0.0f, 1.0f) < -30.0);
+        expect (getIsolatorGainInDecibels (15000.0, 1.0f, 1.0f, 0.0f) < -30.0);
+    }
+
+private:
+    /** Returns the level of a sine wave once it has settled in the isolator. */
+    static double getIsolatorGainInDecibels (double frequency, float lowGain, float midGain, float highGain)
+    {
+        const float amplitude = 0.5f;
+        const int blockSize = 512;
+
+        ToneGeneratorAudioSource tone;
+        tone.setFrequency (frequency);
+        tone.setAmplitude (amplitude);
+
+        FilteringAudioSource filteringSource (&tone, false);
+        filteringSource.setMode (FilteringAudioSource::Isolator);
+        filteringSource.setGain (FilteringAudioSource::Low, lowGain);
+        filteringSource.setGain (FilteringAudioSource::Mid, midGain);
+        filteringSource.setGain (FilteringAudioSource::High, highGain);
+        filteringSource.prepareToPlay (blockSize, 44100.0);
+
+        AudioSampleBuffer buffer (2, blockSize);
+        float peak = 0.0f;
+
+        // the first second lets the filters settle
+        for (int i = 0; i < 200; ++i)
+        {
+            AudioSourceChannelInfo info (&buffer, 0, blockSize);
+            filteringSource.getNextAudioBlock (info);
+
+            if (i >= 100)
+                peak = jmax (peak, buffer.getMagnitude (0, blockSize));
+        }
+
+        filteringSource.releaseResources();
+
+        return Decibels::gainToDecibels (peak / amplitude);
+    }
+};
+
+static FilteringAudioSourceUnitTests filteringAudioSourceUnitTests;
+
+//==============================================================================
+class ResamplingPositionableSourceUnitTests  : public UnitTest
+{
+public:
+    ResamplingPositionableSourceUnitTests() : UnitTest ("ResamplingPositionableSourceUnitTests") {}
+
+    void runTest()
+    {
+        beginTest ("Position tracking and continuity while the speed ramps");
+
+        // the ramp stays below 1.0 so the positions keep plenty of precision
+        const int blockSize = 256;
+        const int numBlocks = 200;
+        const int64 startPosition = 1024;
+
+        RampSource input;
+        ResamplingPositionableSource resamplingSource (&input, false);
+        resamplingSource.setSpeed (0.5);
+        resamplingSource.prepareToPlay (blockSize, 44100.0);
+        resamplingSource.setNextReadPosition (startPosition);
+
+        AudioSampleBuffer buffer (2, blockSize);
+        AudioSourceChannelInfo info (buffer);
+
+        double expectedPosition = (double) startPosition;
+        double lastPosition = startPosition - 0.5;
+        double speed = 0.5;
+        int numDiscontinuities = 0;
+
+        // ramps from half speed up to double and back down again
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const double newSpeed = 0.5 + 1.5 * (1.0 - std::abs (2.0 * (i + 1) / numBlocks - 1.0));
+            resamplingSource.setSpeed (newSpeed);
+            resamplingSource.getNextAudioBlock (info);
+
+            const float* const samples = buffer.getReadPointer (0);
+
+            for (int j = 0; j < blockSize; ++j)
+            {
+                // the output of a ramp is the position each sample was read from
+                const double position = RampSource::getPositionForSample (samples[j]);
+                const double step = position - lastPosition;
+
+                if (step < 0.45 || step > 2.05)
+                    ++numDiscontinuities;
+
+                lastPosition = position;
+            }
+
+            expectedPosition += blockSize * (speed + newSpeed) / 2.0;
+            speed = newSpeed;
+
+            expect (std::abs (resamplingSource.getNextReadPosition() - (lastPosition + speed)) < 2.0,
+                    "Read position doesn't follow the output in block " + String (i));
+        }
+
+        expectEquals (numDiscontinuities, 0);
+        expect (std::abs (resamplingSource.getNextReadPosition() - expectedPosition) < 16.0,
+                "Read position " + String (resamplingSource.getNextReadPosition())
+                 + " should be around " + String (expectedPosition));
+
+        resamplingSource.releaseResources();
+    }
+
+private:
+    // Outputs a ramp rising by 1/65536 each sample so the output shows where it was read from
+    class RampSource  : public PositionableAudioSource
+    {
+    public:
+        RampSource() : position (0) {}
+
+        static double getPositionForSample (float sample)       { return sample * 65536.0; }
+
+        void prepareToPlay (int, double)                        {}
+        void releaseResources()                                 {}
+
+        void getNextAudioBlock (const AudioSourceChannelInfo& info)
+        {
+            for (int i = info.buffer->getNumChannels(); --i >= 0;)
+            {
+                float* samples = info.buffer->getWritePointer (i, info.startSample);
+
+                for (int j = 0; j < info.numSamples; ++j)
+                    samples[j] = (float) ((position + j) / 65536.0);
+            }
+
+            position += info.numSamples;
+        }
+
+        void setNextReadPosition (int64 newPosition)            { position = newPosition;   }
+        int64 getNextReadPosition() const                       { return position;          }
+        int64 getTotalLength() const                            { return 44100 * 60;        }
+        bool isLooping() const                                  { return false;             }
+
+    private:
+        int64 position;
+    };
+};
+
+static ResamplingPositionableSourceUnitTests resamplingPositionableSourceUnitTests;
+
+//==============================================================================
+#if DROWAUDIO_USE_SOUNDTOUCH
+
+class BidirectionalBufferingUnitTests  : public UnitTest
+{
+public:
+    BidirectionalBufferingUnitTests() : UnitTest ("BidirectionalBufferingUnitTests") {}
+
+    void runTest()
+    {
+        beginTest ("Reverse playback through a SoundTouchAudioSource");
+
+        TimeSliceThread thread ("Buffering Test Thread");
+        thread.startThread();
+
+        StallingSource input (44100 * 20);
+        BidirectionalBufferingAudioSource bufferingSource (&input, thread, false, 32768);
+        SoundTouchAudioSource soundTouchSource (&bufferingSource);
+        ReversibleAudioSource reversibleSource (&soundTouchSource, false);
+
+        // SoundTouch reads forwards after every reverse step so the direction has to be set
+        bufferingSource.setPlaybackDirection (true);
+        bufferingSource.setPlaybackSpeed (1.0);
+
+        reversibleSource.prepareToPlay (512, 44100.0);
+        bufferingSource.setNextReadPosition (44100 * 10);
+        soundTouchSource.setNextReadPosition (44100 * 10);
+        expect (bufferingSource.waitForBufferToFill (10000), "buffer didn't fill");
+
+        AudioSampleBuffer buffer (2, 512);
+        AudioSourceChannelInfo info (buffer);
+
+        reversibleSource.getNextAudioBlock (info);
+        reversibleSource.setPlayDirection (false);
+        bufferingSource.setPlaybackDirection (false);
+        expect (bufferingSource.waitForBufferToFill (10000), "buffer didn't fill behind the playhead");
+
+        // with the input stalled everything played has to come from what was
+        // buffered behind the playhead when the direction changed
+        input.setStalled (true);
+
+        int numSilentBlocks = 0;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            reversibleSource.getNextAudioBlock (info);
+
+            if (buffer.getMagnitude (0, 512) < 0.1f)
+                ++numSilentBlocks;
+        }
+
+        input.setStalled (false);
+
+        expect (! bufferingSource.isPlayingForwards());
+        expectEquals (numSilentBlocks, 0);
+
+        reversibleSource.releaseResources();
+    }
+
+private:
+    // Plays a constant level and can be made to hold up the thread reading it,
+    // like a network volume that has stopped responding
+    class StallingSource  : public PositionableAudioSource
+    {
+    public:
+        StallingSource (int64 length_) : length (length_), position (0) {}
+
+        void setStalled (bool shouldStall)                      { isStalled.set (shouldStall ? 1 : 0); }
+
+        void prepareToPlay (int, double)                        {}
+        void releaseResources()                                 {}
+
+        void getNextAudioBlock (const AudioSourceChannelInfo& info)
+        {
+            while (isStalled.get() != 0)
+                Thread::sleep (1);
+
+            for (int i = info.buffer->getNumChannels(); --i >= 0;)
+                FloatVectorOperations::fill (info.buffer->getWritePointer (i, info.startSample), 0.5f, info.numSamples);
+
+            position += info.numSamples;
+        }
+
+        void setNextReadPosition (int64 newPosition)            { position = newPosition;   }
+        int64 getNextReadPosition() const                       { return position;          }
+        int64 getTotalLength() const                            { return length;            }
+        bool isLooping() const                                  { return false;             }
+
+    private:
+        const int64 length;
+        int64 position;
+        Atomic<int> isStalled;
+    };
+};
+
+static BidirectionalBufferingUnitTests bidirectionalBufferingUnitTests;
+
+#endif
+
 //==============================================================================
 
 
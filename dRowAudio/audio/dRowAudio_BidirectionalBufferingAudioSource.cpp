@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    // The largest section that will be read in one go by the background thread
+    const int maxChunkSize = 2048;
+
+    // Gaps smaller than this are left until they've grown to avoid lots of tiny reads
+    const int minChunkSize = 512;
+}
+
+//==============================================================================
+BidirectionalBufferingAudioSource::BidirectionalBufferingAudioSource (PositionableAudioSource* source_,
+                                                                      TimeSliceThread& backgroundThread_,
+                                                                      bool deleteSourceWhenDeleted,
+                                                                      int numberOfSamplesToBuffer_,
+                                                                      int numberOfChannels_)
+    : source (source_, deleteSourceWhenDeleted),
+      backgroundThread (backgroundThread_),
+      numberOfSamplesToBuffer (jmax (1024, numberOfSamplesToBuffer_)),
+      numberOfChannels (numberOfChannels_),
+      bufferValidStart (0),
+      bufferValidEnd (0),
+      nextPlayPos (0),
+      sampleRate (0),
+      wasSourceLooping (false),
+      isPrepared (false),
+      isForwards (true),
+      isDirectionSet (false),
+      isSpeedSet (false),
+      isBufferFull (false),
+      playbackSpeed (1.0),
+      lastBlockStartPos (0),
+      speedMeasureStartPos (0),
+      speedMeasureStartTime (0.0)
+{
+    jassert (source_ != nullptr);
+
+    jassert (numberOfSamplesToBuffer_ > 1024); // not much point using this class if you're
+                                               // not using a larger buffer..
+}
+
+BidirectionalBufferingAudioSource::~BidirectionalBufferingAudioSource()
+{
+    releaseResources();
+}
+
+//==============================================================================
+void BidirectionalBufferingAudioSource::setPlaybackDirection (bool shouldPlayForwards)
+{
+    isDirectionSet = true;
+
+    if (isForwards != shouldPlayForwards)
+    {
+        {
+            const ScopedLock sl (bufferStartPosLock);
+            isForwards = shouldPlayForwards;
+            isBufferFull = false;
+        }
+
+        // the window needs to be moved over to the new direction of travel
+        backgroundThread.moveToFrontOfQueue (this);
+    }
+}
+
+void BidirectionalBufferingAudioSource::setPlaybackSpeed (double newSpeed)
+{
+    isSpeedSet = true;
+    playbackSpeed = std::abs (newSpeed);
+}
+
+bool BidirectionalBufferingAudioSource::waitForBufferToFill (int timeOutMilliseconds)
+{
+    const uint32 startTime = Time::getMillisecondCounter();
+
+    for (;;)
+    {
+        if (isBufferFull)
+            return true;
+
+        const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+
+        if (! isPrepared || elapsed >= timeOutMilliseconds)
+            return false;
+
+        backgroundThread.moveToFrontOfQueue (this);
+        bufferFilled.wait (timeOutMilliseconds - elapsed);
+    }
+}
+
+//==============================================================================
+void BidirectionalBufferingAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate_)
+{
+    const int bufferSizeNeeded = jmax (samplesPerBlockExpected * 2, numberOfSamplesToBuffer);
+
+    if (sampleRate_ != sampleRate
+         || bufferSizeNeeded != buffer.getNumSamples()
+         || ! isPrepared)
+    {
+        backgroundThread.removeTimeSliceClient (this);
+
+        isPrepared = true;
+        sampleRate = sampleRate_;
+
+        source->prepareToPlay (samplesPerBlockExpected, sampleRate_);
+
+        buffer.setSize (numberOfChannels, bufferSizeNeeded);
+        buffer.clear();
+
+        bufferValidStart = 0;
+        bufferValidEnd = 0;
+        isBufferFull = false;
+
+        backgroundThread.addTimeSliceClient (this);
+
+        // give the thread up to half a second to get some samples in
+        const int numSamplesToPrebuffer = jmin (((int) sampleRate_) / 4, buffer.getNumSamples() / 2);
+
+        for (int i = 0; i < 100 && bufferValidEnd - bufferValidStart < numSamplesToPrebuffer; ++i)
+        {
+            backgroundThread.moveToFrontOfQueue (this);
+            Thread::sleep (5);
+        }
+    }
+}
+
+void BidirectionalBufferingAudioSource::releaseResources()
+{
+    isPrepared = false;
+    backgroundThread.removeTimeSliceClient (this);
+
+    buffer.setSize (numberOfChannels, 0);
+    source->releaseResources();
+}
+
+void BidirectionalBufferingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    const ScopedLock sl (bufferStartPosLock);
+
+    updatePlaybackDirection();
+
+    const int64 validStart = jlimit (bufferValidStart, bufferValidEnd, nextPlayPos) - nextPlayPos;
+    const int64 validEnd   = jlimit (bufferValidStart, bufferValidEnd, nextPlayPos + info.numSamples) - nextPlayPos;
+
+    if (validStart == validEnd)
+    {
+        // total cache miss
+        info.clearActiveBufferRegion();
+    }
+    else
+    {
+        if (validStart > 0)
+            info.buffer->clear (info.startSample, (int) validStart);  // partial cache miss at start
+
+        if (validEnd < info.numSamples)
+            info.buffer->clear (info.startSample + (int) validEnd,
+                                info.numSamples - (int) validEnd);    // partial cache miss at end
+
+        for (int chan = jmin (numberOfChannels, info.buffer->getNumChannels()); --chan >= 0;)
+        {
+            jassert (buffer.getNumSamples() > 0);
+            const int startBufferIndex = (int) ((validStart + nextPlayPos) % buffer.getNumSamples());
+            const int endBufferIndex   = (int) ((validEnd + nextPlayPos) % buffer.getNumSamples());
+
+            if (startBufferIndex < endBufferIndex)
+            {
+                info.buffer->copyFrom (chan, info.startSample + (int) validStart,
+                                       buffer,
+                                       chan, startBufferIndex,
+                                       (int) (validEnd - validStart));
+            }
+            else
+            {
+                const int initialSize = buffer.getNumSamples() - startBufferIndex;
+
+                info.buffer->copyFrom (chan, info.startSample + (int) validStart,
+                                       buffer,
+                                       chan, startBufferIndex,
+                                       initialSize);
+
+                info.buffer->copyFrom (chan, info.startSample + (int) validStart + initialSize,
+                                       buffer,
+                                       chan, 0,
+                                       (int) (validEnd - validStart) - initialSize);
+            }
+        }
+    }
+
+    nextPlayPos += info.numSamples;
+    isBufferFull = false;
+}
+
+//==============================================================================
+void BidirectionalBufferingAudioSource::setNextReadPosition (int64 newPosition)
+{
+    const ScopedLock sl (bufferStartPosLock);
+
+    nextPlayPos = newPosition;
+    isBufferFull = false;
+
+    // only hurry the thread along if this is a real seek rather than a reverse step
+    if (newPosition < bufferValidStart || newPosition > bufferValidEnd)
+        backgroundThread.moveToFrontOfQueue (this);
+}
+
+int64 BidirectionalBufferingAudioSource::getNextReadPosition() const
+{
+    jassert (source->getTotalLength() > 0);
+
+    return (source->isLooping() && nextPlayPos > 0)
+                    ? nextPlayPos % source->getTotalLength()
+                    : nextPlayPos;
+}
+
+//==============================================================================
+void BidirectionalBufferingAudioSource::updatePlaybackDirection()
+{
+    // Called at the start of each block with the lock held. Unless they've been set
+    // by the owner, the direction is taken from where each block starts relative to
+    // the last one and the speed from how far the blocks have moved over a short
+    // period of time.
+    if (isDirectionSet && isSpeedSet)
+        return;
+
+    const double now = Time::getMillisecondCounterHiRes();
+    const int64 delta = nextPlayPos - lastBlockStartPos;
+    lastBlockStartPos = nextPlayPos;
+
+    if (std::abs (delta) > buffer.getNumSamples() / 2)
+    {
+        // a jump is a seek rather than playback so start measuring again
+        speedMeasureStartPos = nextPlayPos;
+        speedMeasureStartTime = now;
+        return;
+    }
+
+    if (delta != 0 && ! isDirectionSet)
+        isForwards = delta > 0;
+
+    const double elapsedMs = now - speedMeasureStartTime;
+
+    if (elapsedMs >= 50.0 && sampleRate > 0.0 && ! isSpeedSet)
+    {
+        const double numSamplesElapsed = elapsedMs * 0.001 * sampleRate;
+        playbackSpeed = std::abs (nextPlayPos - speedMeasureStartPos) / numSamplesElapsed;
+
+        speedMeasureStartPos = nextPlayPos;
+        speedMeasureStartTime = now;
+    }
+}
+
+bool BidirectionalBufferingAudioSource::readNextBufferChunk()
+{
+    int64 newBVS, newBVE, sectionToReadStart, sectionToReadEnd;
+
+    {
+        const ScopedLock sl (bufferStartPosLock);
+
+        if (wasSourceLooping != isLooping())
+        {
+            wasSourceLooping = isLooping();
+            bufferValidStart = 0;
+            bufferValidEnd = 0;
+            isBufferFull = false;
+        }
+
+        // Keep three quarters of the buffer in the direction of travel and the
+        // rest behind the playhead for when the direction changes.
+        const int bufferSize = buffer.getNumSamples();
+        const int numBehind = bufferSize / 4;
+        const int64 playPos = nextPlayPos;
+
+        const int64 windowStart = jmax ((int64) 0, isForwards ? playPos - numBehind
+                                                              : playPos - (bufferSize - numBehind));
+        int64 windowEnd = windowStart + bufferSize;
+
+        const bool windowEndIsSourceEnd = ! isLooping() && windowEnd >= getTotalLength();
+
+        if (windowEndIsSourceEnd)
+            windowEnd = getTotalLength();
+
+        if (windowEnd <= windowStart)
+        {
+            setBufferFull();
+            return false;
+        }
+
+        const int64 readPos = jlimit (windowStart, windowEnd, playPos);
+
+        if (readPos < bufferValidStart || readPos > bufferValidEnd)
+        {
+            // the playhead has moved away from what's buffered so start again from it
+            if (isForwards)
+            {
+                sectionToReadStart = readPos;
+                sectionToReadEnd = jmin (windowEnd, readPos + maxChunkSize);
+            }
+            else
+            {
+                sectionToReadStart = jmax (windowStart, readPos - maxChunkSize);
+                sectionToReadEnd = readPos;
+            }
+
+            newBVS = sectionToReadStart;
+            newBVE = sectionToReadEnd;
+
+            bufferValidStart = 0;
+            bufferValidEnd = 0;
+        }
+        else
+        {
+            // drop anything outside the window as that's what the new section will overwrite
+            const int64 validStart = jmax (bufferValidStart, windowStart);
+            const int64 validEnd = jmin (bufferValidEnd, windowEnd);
+
+            const int64 numMissingBefore = validStart - windowStart;
+            const int64 numMissingAfter = windowEnd - validEnd;
+            const bool shouldReadBefore = numMissingBefore >= minChunkSize || (numMissingBefore > 0 && windowStart == 0);
+            const bool shouldReadAfter = numMissingAfter >= minChunkSize || (numMissingAfter > 0 && windowEndIsSourceEnd);
+
+            // fill in the direction of travel first, then behind the playhead
+            const bool readAfter = isForwards ? shouldReadAfter
+                                              : (shouldReadAfter && ! shouldReadBefore);
+
+            if (! (readAfter || shouldReadBefore))
+            {
+                setBufferFull();
+                return false;
+            }
+
+            if (readAfter)
+            {
+                sectionToReadStart = validEnd;
+                sectionToReadEnd = jmin (windowEnd, validEnd + maxChunkSize);
+                newBVS = validStart;
+                newBVE = sectionToReadEnd;
+            }
+            else
+            {
+                sectionToReadStart = jmax (windowStart, validStart - maxChunkSize);
+                sectionToReadEnd = validStart;
+                newBVS = sectionToReadStart;
+                newBVE = validEnd;
+            }
+
+            bufferValidStart = validStart;
+            bufferValidEnd = validEnd;
+        }
+    }
+
+    if (sectionToReadStart >= sectionToReadEnd)
+        return false;
+
+    jassert (buffer.getNumSamples() > 0);
+    const int bufferIndexStart = (int) (sectionToReadStart % buffer.getNumSamples());
+    const int bufferIndexEnd = (int) (sectionToReadEnd % buffer.getNumSamples());
+
+    if (bufferIndexStart < bufferIndexEnd)
+    {
+        readBufferSection (sectionToReadStart,
+                           (int) (sectionToReadEnd - sectionToReadStart),
+                           bufferIndexStart);
+    }
+    else
+    {
+        const int initialSize = buffer.getNumSamples() - bufferIndexStart;
+
+        readBufferSection (sectionToReadStart,
+                           initialSize,
+                           bufferIndexStart);
+
+        readBufferSection (sectionToReadStart + initialSize,
+                           (int) (sectionToReadEnd - sectionToReadStart) - initialSize,
+                           0);
+    }
+
+    {
+        const ScopedLock sl2 (bufferStartPosLock);
+
+        bufferValidStart = newBVS;
+        bufferValidEnd = newBVE;
+    }
+
+    return true;
+}
+
+void BidirectionalBufferingAudioSource::setBufferFull()
+{
+    // called with the lock held once there's nothing left worth reading
+    isBufferFull = true;
+    bufferFilled.signal();
+}
+
+void BidirectionalBufferingAudioSource::readBufferSection (int64 start, int length, int bufferOffset)
+{
+    if (source->getNextReadPosition() != start)
+        source->setNextReadPosition (start);
+
+    AudioSourceChannelInfo info;
+    info.buffer = &buffer;
+    info.startSample = bufferOffset;
+    info.numSamples = length;
+
+    source->getNextAudioBlock (info);
+}
+
+int BidirectionalBufferingAudioSource::useTimeSlice()
+{
+    if (readNextBufferChunk())
+        return 1;
+
+    // nothing else can be read until the playhead has moved on by at least a small chunk
+    const double samplesPerMs = jmax (0.1, (double) playbackSpeed) * sampleRate * 0.001;
+
+    return samplesPerMs > 0.0 ? jlimit (1, 100, (int) (minChunkSize / samplesPerMs))
+                              : 100;
+}
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_BIDIRECTIONALBUFFERINGAUDIOSOURCE_H__
+#define __DROWAUDIO_BIDIRECTIONALBUFFERINGAUDIOSOURCE_H__
+
+#include "../utility/dRowAudio_Utility.h"
+
+//==============================================================================
+/** A PositionableAudioSource that buffers its input on a background thread
+    in whichever direction it is being played.
+
+    This works in a similar way to a BufferingAudioSource but rather than only
+    reading ahead of the play position it keeps a window of samples either side
+    of it. Most of the window lies in the direction of travel with the remainder
+    behind the playhead so that playback can change direction without having to
+    flush the buffer and wait for the input.
+
+    The owner should tell this source which way and how fast it is being played
+    with setPlaybackDirection() and setPlaybackSpeed(). The speed is used to
+    decide how soon the background thread needs to top the buffer up. If these
+    haven't been called the direction and speed are guessed from how the read
+    position moves between blocks. This only works when each block is read
+    straight after the previous one, so not underneath something like a
+    SoundTouchAudioSource that reads several chunks per audio callback.
+
+    @see BufferingAudioSource, ReversibleAudioSource
+*/
+class BidirectionalBufferingAudioSource  : public PositionableAudioSource,
+                                           private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates a BidirectionalBufferingAudioSource.
+
+        @param source                       the input source to read from
+        @param backgroundThread             a background thread that will be used for the
+                                            background read-ahead. This object must not be deleted
+                                            until after any BidirectionalBufferingAudioSources that
+                                            are using it have been deleted!
+        @param deleteSourceWhenDeleted      if true, then the input source object will
+                                            be deleted when this object is deleted
+        @param numberOfSamplesToBuffer      the size of the window of samples to keep
+                                            around the play position
+        @param numberOfChannels             the number of channels that will be played
+     */
+    BidirectionalBufferingAudioSource (PositionableAudioSource* source,
+                                       TimeSliceThread& backgroundThread,
+                                       bool deleteSourceWhenDeleted,
+                                       int numberOfSamplesToBuffer,
+                                       int numberOfChannels = 2);
+
+    /** Destructor.
+
+        The input source may be deleted depending on whether the deleteSourceWhenDeleted
+        flag was set in the constructor.
+     */
+    ~BidirectionalBufferingAudioSource();
+
+    //==============================================================================
+    /** Sets the direction the source is being played in.
+        Once this has been called the direction is no longer guessed from how
+        the read position moves.
+     */
+    void setPlaybackDirection (bool shouldPlayForwards);
+
+    /** Sets the speed the read position is moving at, relative to normal playback.
+        Once this has been called the speed is no longer measured from how far
+        the read position moves.
+     */
+    void setPlaybackSpeed (double newSpeed);
+
+    /** Returns true if the source is currently being played forwards.
+     */
+    bool isPlayingForwards() const              {   return isForwards;      }
+
+    /** Returns the current speed the read position is moving at, relative to
+        normal playback.
+     */
+    double getPlaybackSpeed() const             {   return playbackSpeed;   }
+
+    /** Blocks until the window around the play position has been filled from
+        the input, or the timeout runs out.
+        This is useful when rendering offline, where the background thread has
+        to be given the chance to keep up. It returns true if the window was
+        filled, or false if it timed out.
+     */
+    bool waitForBufferToFill (int timeOutMilliseconds);
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+    //==============================================================================
+    /** Implements the PositionableAudioSource method. */
+    void setNextReadPosition (int64 newPosition);
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getNextReadPosition() const;
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getTotalLength() const                {   return source->getTotalLength();    }
+
+    /** Implements the PositionableAudioSource method. */
+    bool isLooping() const                      {   return source->isLooping();         }
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<PositionableAudioSource> source;
+    TimeSliceThread& backgroundThread;
+    int numberOfSamplesToBuffer, numberOfChannels;
+    AudioSampleBuffer buffer;
+    CriticalSection bufferStartPosLock;
+    int64 volatile bufferValidStart, bufferValidEnd, nextPlayPos;
+    double volatile sampleRate;
+    bool wasSourceLooping, isPrepared;
+
+    bool volatile isForwards, isDirectionSet, isSpeedSet, isBufferFull;
+    WaitableEvent bufferFilled;
+    double volatile playbackSpeed;
+    int64 lastBlockStartPos, speedMeasureStartPos;
+    double speedMeasureStartTime;
+
+    void updatePlaybackDirection();
+    bool readNextBufferChunk();
+    void setBufferFull();
+    void readBufferSection (int64 start, int length, int bufferOffset);
+    int useTimeSlice();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BidirectionalBufferingAudioSource);
+};
+
+#endif   // __DROWAUDIO_BIDIRECTIONALBUFFERINGAUDIOSOURCE_H__
@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+CueSnippetAudioSource::CueSnippetAudioSource (PositionableAudioSource* inputSource,
+                                              PositionableAudioSource* snippetSource_,
+                                              TimeSliceThread& backgroundThread_,
+                                              int numSamplesPerSnippet_,
+                                              bool deleteInputWhenDeleted)
+    : input (inputSource, deleteInputWhenDeleted),
+      snippetSource (snippetSource_),
+      backgroundThread (backgroundThread_),
+      numSamplesPerSnippet (jmax (1, numSamplesPerSnippet_)),
+      currentSnippet (nullptr),
+      snippetReadPos (0),
+      nextPlayPos (0)
+{
+    jassert (inputSource != nullptr);
+    jassert (snippetSource_ != nullptr);
+
+    backgroundThread.addTimeSliceClient (this);
+}
+
+CueSnippetAudioSource::~CueSnippetAudioSource()
+{
+    backgroundThread.removeTimeSliceClient (this);
+}
+
+//==============================================================================
+void CueSnippetAudioSource::setCuePoints (const Array<int64>& cueSamplePositions)
+{
+    {
+        const ScopedLock sl (snippetLock);
+
+        for (int i = snippets.size(); --i >= 0;)
+        {
+            Snippet* const snippet = snippets.getUnchecked (i);
+
+            if (! cueSamplePositions.contains (snippet->startSample))
+            {
+                if (currentSnippet == snippet)
+                {
+                    // the input is ahead of us at the end of the snippet so bring it back
+                    currentSnippet = nullptr;
+                    input->setNextReadPosition (nextPlayPos);
+                }
+
+                snippets.remove (i);
+            }
+        }
+
+        for (int i = 0; i < cueSamplePositions.size(); ++i)
+        {
+            const int64 startSample = cueSamplePositions.getUnchecked (i);
+            bool alreadyExists = startSample < 0;
+
+            for (int s = 0; s < snippets.size() && ! alreadyExists; ++s)
+                alreadyExists = snippets.getUnchecked (s)->startSample == startSample;
+
+            if (! alreadyExists)
+                snippets.add (new Snippet (startSample));
+        }
+    }
+
+    backgroundThread.moveToFrontOfQueue (this);
+}
+
+int CueSnippetAudioSource::getNumSnippetsLoaded() const
+{
+    const ScopedLock sl (snippetLock);
+    int numLoaded = 0;
+
+    for (int i = 0; i < snippets.size(); ++i)
+        if (snippets.getUnchecked (i)->buffer != nullptr)
+            ++numLoaded;
+
+    return numLoaded;
+}
+
+//==============================================================================
+void CueSnippetAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    input->prepareToPlay (samplesPerBlockExpected, sampleRate);
+}
+
+void CueSnippetAudioSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void CueSnippetAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    if (currentSnippet != nullptr)
+    {
+        // The lock is only held briefly whilst the snippets are changed. If that's
+        // happening now just carry on from the input in case ours is removed.
+        const ScopedTryLock sl (snippetLock);
+
+        if (sl.isLocked() && currentSnippet != nullptr)
+        {
+            const AudioSampleBuffer& snippetBuffer = *currentSnippet->buffer;
+            const int numToCopy = jmin (info.numSamples, snippetBuffer.getNumSamples() - snippetReadPos);
+
+            for (int i = 0; i < info.buffer->getNumChannels(); ++i)
+            {
+                if (i < snippetBuffer.getNumChannels())
+                    info.buffer->copyFrom (i, info.startSample, snippetBuffer, i, snippetReadPos, numToCopy);
+                else
+                    info.buffer->clear (i, info.startSample, numToCopy);
+            }
+
+            snippetReadPos += numToCopy;
+            nextPlayPos += numToCopy;
+
+            // the input was moved to the end of the snippet when it started
+            if (snippetReadPos >= snippetBuffer.getNumSamples())
+                currentSnippet = nullptr;
+
+            if (numToCopy < info.numSamples)
+            {
+                AudioSourceChannelInfo remainder;
+                remainder.buffer = info.buffer;
+                remainder.startSample = info.startSample + numToCopy;
+                remainder.numSamples = info.numSamples - numToCopy;
+
+                input->getNextAudioBlock (remainder);
+            }
+
+            return;
+        }
+
+        currentSnippet = nullptr;
+        input->setNextReadPosition (nextPlayPos);
+    }
+
+    input->getNextAudioBlock (info);
+}
+
+//==============================================================================
+void CueSnippetAudioSource::setNextReadPosition (int64 newPosition)
+{
+    const int64 distance = std::abs (newPosition - getNextReadPosition());
+
+    currentSnippet = nullptr;
+    nextPlayPos = newPosition;
+
+    // small moves, such as the steps taken when playing backwards, will still be buffered
+    if (distance > numSamplesPerSnippet)
+    {
+        const ScopedTryLock sl (snippetLock);
+
+        if (sl.isLocked())
+        {
+            for (int i = 0; i < snippets.size(); ++i)
+            {
+                Snippet* const snippet = snippets.getUnchecked (i);
+                const int64 offset = newPosition - snippet->startSample;
+
+                if (snippet->buffer != nullptr
+                     && offset >= 0 && offset < snippet->buffer->getNumSamples())
+                {
+                    snippetReadPos = (int) offset;
+                    currentSnippet = snippet;
+
+                    input->setNextReadPosition (snippet->startSample + snippet->buffer->getNumSamples());
+                    return;
+                }
+            }
+        }
+    }
+
+    input->setNextReadPosition (newPosition);
+}
+
+int64 CueSnippetAudioSource::getNextReadPosition() const
+{
+    return currentSnippet != nullptr ? nextPlayPos
+                                     : input->getNextReadPosition();
+}
+
+//==============================================================================
+int CueSnippetAudioSource::useTimeSlice()
+{
+    int64 startSample = -1;
+
+    {
+        const ScopedLock sl (snippetLock);
+
+        for (int i = 0; i < snippets.size(); ++i)
+        {
+            if (snippets.getUnchecked (i)->buffer == nullptr)
+            {
+                startSample = snippets.getUnchecked (i)->startSample;
+                break;
+            }
+        }
+    }
+
+    if (startSample < 0)
+        return 500;
+
+    // read without holding the lock so the audio thread is never kept waiting
+    const int64 numSamples = jlimit ((int64) 0, (int64) numSamplesPerSnippet,
+                                     snippetSource->getTotalLength() - startSample);
+    ScopedPointer<AudioSampleBuffer> newBuffer (new AudioSampleBuffer (2, (int) numSamples));
+
+    if (numSamples > 0)
+    {
+        AudioSourceChannelInfo info;
+        info.buffer = newBuffer;
+        info.startSample = 0;
+        info.numSamples = (int) numSamples;
+
+        snippetSource->setNextReadPosition (startSample);
+        snippetSource->getNextAudioBlock (info);
+    }
+
+    {
+        const ScopedLock sl (snippetLock);
+
+        for (int i = 0; i < snippets.size(); ++i)
+        {
+            Snippet* const snippet = snippets.getUnchecked (i);
+
+            if (snippet->startSample == startSample && snippet->buffer == nullptr)
+            {
+                snippet->buffer = newBuffer.release();
+                break;
+            }
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_CUESNIPPETAUDIOSOURCE_H__
+#define __DROWAUDIO_CUESNIPPETAUDIOSOURCE_H__
+
+#include "../utility/dRowAudio_Utility.h"
+
+//==============================================================================
+/** A PositionableAudioSource that keeps a short snippet of audio in memory
+    from each of a set of cue points.
+
+    When the read position jumps to one of the cue points the audio is played
+    from the snippet straight away whilst the input is moved on to the end of
+    the snippet. This gives a buffering input the length of the snippet to
+    refill instead of playing silence until it has caught up.
+
+    The snippets are read on a background thread from a separate source,
+    normally the AudioFormatReaderSource underneath the BufferingAudioSource
+    this sits on top of. This source is only ever read from the background
+    thread, so it can safely be shared with a buffering source using the same
+    thread.
+
+    @see AudioFilePlayerExt, BidirectionalBufferingAudioSource
+*/
+class CueSnippetAudioSource  : public PositionableAudioSource,
+                               private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates a CueSnippetAudioSource.
+
+        @param inputSource              the source to play from when not playing a snippet
+        @param snippetSource            the source to read the snippets from
+        @param backgroundThread         the thread to read the snippets on. This must be
+                                        the thread any buffering of the input is done on
+                                        if the two sources share an underlying reader.
+        @param numSamplesPerSnippet     the length of each snippet
+        @param deleteInputWhenDeleted   if true the input source will be deleted when this is
+     */
+    CueSnippetAudioSource (PositionableAudioSource* inputSource,
+                           PositionableAudioSource* snippetSource,
+                           TimeSliceThread& backgroundThread,
+                           int numSamplesPerSnippet,
+                           bool deleteInputWhenDeleted);
+
+    /** Destructor. */
+    ~CueSnippetAudioSource();
+
+    //==============================================================================
+    /** Sets the positions in samples to keep snippets for.
+        Snippets already loaded for any of these positions are kept, any new ones
+        will be read on the background thread.
+     */
+    void setCuePoints (const Array<int64>& cueSamplePositions);
+
+    /** Returns the number of snippets that have been loaded.
+     */
+    int getNumSnippetsLoaded() const;
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+    //==============================================================================
+    /** Implements the PositionableAudioSource method. */
+    void setNextReadPosition (int64 newPosition);
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getNextReadPosition() const;
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getTotalLength() const                {   return input->getTotalLength(); }
+
+    /** Implements the PositionableAudioSource method. */
+    bool isLooping() const                      {   return input->isLooping();      }
+
+private:
+    //==============================================================================
+    struct Snippet
+    {
+        Snippet (int64 startSample_) : startSample (startSample_) {}
+
+        const int64 startSample;
+        ScopedPointer<AudioSampleBuffer> buffer;
+    };
+
+    OptionalScopedPointer<PositionableAudioSource> input;
+    PositionableAudioSource* snippetSource;
+    TimeSliceThread& backgroundThread;
+    const int numSamplesPerSnippet;
+
+    CriticalSection snippetLock;
+    OwnedArray<Snippet> snippets;
+    Snippet* volatile currentSnippet;
+    int snippetReadPos;
+    int64 volatile nextPlayPos;
+
+    int useTimeSlice();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CueSnippetAudioSource);
+};
+
+#endif   // __DROWAUDIO_CUESNIPPETAUDIOSOURCE_H__
@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+namespace
+{
+    const char* const cacheFileExtension = ".pcm";
+    const char* const keyFileExtension = ".key";
+    const int cacheWriteChunkSize = 65536;
+
+    // Identifies a particular version of a file without having to read it
+    String getFileIdentifier (const File& file)
+    {
+        const String fileId (file.getFullPathName()
+                              + "|" + String (file.getSize())
+                              + "|" + String (file.getLastModificationTime().toMilliseconds()));
+
+        return MD5 (fileId.toUTF8()).toHexString();
+    }
+
+    struct LeastRecentlyUsedComparator
+    {
+        static int compareElements (const File& first, const File& second)
+        {
+            const Time firstTime (first.getLastAccessTime());
+            const Time secondTime (second.getLastAccessTime());
+
+            return firstTime < secondTime ? -1 : (secondTime < firstTime ? 1 : 0);
+        }
+    };
+}
+
+//==============================================================================
+DecodedAudioCache::DecodedAudioCache (const File& cacheDirectory_,
+                                      int64 maximumSizeInBytes,
+                                      AudioFormatManager* formatManagerToUse)
+    : Thread ("Decoded audio cache"),
+      cacheDirectory (cacheDirectory_),
+      maximumSize (maximumSizeInBytes),
+      formatManager ((formatManagerToUse == nullptr ? new AudioFormatManager()
+                                                    : formatManagerToUse),
+                     formatManagerToUse == nullptr)
+{
+    if (formatManagerToUse == nullptr)
+        formatManager->registerBasicFormats();
+
+    cacheDirectory.createDirectory();
+    startThread (2);
+}
+
+DecodedAudioCache::~DecodedAudioCache()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread (10000);
+}
+
+//==============================================================================
+MemoryMappedAudioFormatReader* DecodedAudioCache::createReaderFor (const File& file)
+{
+    const File cacheFile (getCacheFileFor (file));
+
+    if (! cacheFile.existsAsFile())
+        return nullptr;
+
+    AudioSampleBufferAudioFormat format;
+    ScopedPointer<MemoryMappedAudioFormatReader> reader (format.createMemoryMappedReader (cacheFile));
+
+    if (reader == nullptr)
+    {
+        // written by an older version or corrupt, remove it so it gets decoded again
+        cacheFile.deleteFile();
+        return nullptr;
+    }
+
+    if (reader->mapEntireFile())
+    {
+        // this is what the least recently used files are worked out from
+        cacheFile.setLastAccessTime (Time::getCurrentTime());
+
+        return reader.release();
+    }
+
+    return nullptr;
+}
+
+bool DecodedAudioCache::isCached (const File& file)
+{
+    return getCacheFileFor (file).existsAsFile();
+}
+
+void DecodedAudioCache::addToCache (const File& file)
+{
+    if (! file.existsAsFile())
+        return;
+
+    {
+        const ScopedLock sl (lock);
+        filesToAdd.addIfNotAlreadyThere (file);
+    }
+
+    notify();
+}
+
+void DecodedAudioCache::clear()
+{
+    {
+        const ScopedLock sl (lock);
+        filesToAdd.clear();
+        keyCache.clear();
+    }
+
+    const Array<File> cacheFiles (getCacheFiles (cacheFileExtension));
+
+    for (int i = 0; i < cacheFiles.size(); ++i)
+        cacheFiles.getReference (i).deleteFile();
+
+    const Array<File> keyFiles (getCacheFiles (keyFileExtension));
+
+    for (int i = 0; i < keyFiles.size(); ++i)
+        keyFiles.getReference (i).deleteFile();
+}
+
+//==============================================================================
+void DecodedAudioCache::setMaximumSize (int64 newMaximumSizeInBytes)
+{
+    maximumSize = newMaximumSizeInBytes;
+    removeLeastRecentlyUsedFiles();
+}
+
+int64 DecodedAudioCache::getCurrentSize() const
+{
+    const Array<File> cacheFiles (getCacheFiles (cacheFileExtension));
+    int64 totalSize = 0;
+
+    for (int i = 0; i < cacheFiles.size(); ++i)
+        totalSize += cacheFiles.getReference (i).getSize();
+
+    return totalSize;
+}
+
+//==============================================================================
+void DecodedAudioCache::run()
+{
+    while (! threadShouldExit())
+    {
+        File file;
+
+        {
+            const ScopedLock sl (lock);
+
+            if (filesToAdd.size() > 0)
+            {
+                file = filesToAdd.getFirst();
+                filesToAdd.remove (0);
+            }
+        }
+
+        if (file == File::nonexistent)
+        {
+            wait (-1);
+            continue;
+        }
+
+        writeCacheFile (file);
+        removeLeastRecentlyUsedFiles();
+    }
+}
+
+File DecodedAudioCache::getCacheFileFor (const File& file)
+{
+    // the key file is only small so remember what it says until the file changes
+    const String fileId (getFileIdentifier (file));
+
+    {
+        const ScopedLock sl (lock);
+
+        if (keyCache.contains (fileId))
+            return getCacheFileForKey (keyCache[fileId]);
+    }
+
+    const String key (getKeyFileFor (fileId).loadFileAsString().trim());
+
+    if (key.isEmpty())
+        return File::nonexistent;
+
+    const ScopedLock sl (lock);
+    keyCache.set (fileId, key);
+
+    return getCacheFileForKey (key);
+}
+
+File DecodedAudioCache::getCacheFileForKey (const String& key) const
+{
+    return cacheDirectory.getChildFile (key + cacheFileExtension);
+}
+
+File DecodedAudioCache::getKeyFileFor (const String& fileId) const
+{
+    return cacheDirectory.getChildFile (fileId + keyFileExtension);
+}
+
+Array<File> DecodedAudioCache::getCacheFiles (const String& extension) const
+{
+    Array<File> cacheFiles;
+    cacheDirectory.findChildFiles (cacheFiles, File::findFiles, false, "*" + extension);
+
+    return cacheFiles;
+}
+
+void DecodedAudioCache::writeCacheFile (const File& sourceFile)
+{
+    if (getCacheFileFor (sourceFile).existsAsFile())
+        return;
+
+    // hashing the contents reads the whole file so is only done here on the background thread
+    const String fileId (getFileIdentifier (sourceFile));
+    const String key (MD5 (sourceFile).toHexString());
+    const File cacheFile (getCacheFileForKey (key));
+
+    if (! cacheFile.existsAsFile())
+    {
+        if (! decodeToCacheFile (sourceFile, cacheFile))
+            return;
+    }
+
+    if (getKeyFileFor (fileId).replaceWithText (key))
+    {
+        const ScopedLock sl (lock);
+        keyCache.set (fileId, key);
+    }
+}
+
+bool DecodedAudioCache::decodeToCacheFile (const File& sourceFile, const File& cacheFile)
+{
+    ScopedPointer<AudioFormatReader> reader (formatManager->createReaderFor (sourceFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+        return false;
+
+    const int numChannels = (int) reader->numChannels;
+    const int64 lengthInSamples = reader->lengthInSamples;
+
+    // write to a temporary file so a partly written entry can never be read
+    const File tempFile (cacheFile.withFileExtension ("tmp"));
+    tempFile.deleteFile();
+
+    bool succeeded = false;
+
+    {
+        FileOutputStream* const out = tempFile.createOutputStream();
+
+        if (out == nullptr)
+            return false;
+
+        AudioSampleBufferAudioFormat format;
+        ScopedPointer<AudioFormatWriter> writer (format.createWriterFor (out, reader->sampleRate, (unsigned int) numChannels,
+                                                                         32, StringPairArray(), 0));
+
+        if (writer == nullptr)
+        {
+            delete out;
+            return false;
+        }
+
+        AudioSampleBuffer chunk (numChannels, cacheWriteChunkSize);
+        int64 position = 0;
+
+        while (position < lengthInSamples && ! threadShouldExit())
+        {
+            const int numSamples = (int) jmin ((int64) cacheWriteChunkSize, lengthInSamples - position);
+            reader->read (&chunk, 0, numSamples, position, true, true);
+
+            if (! writer->writeFromAudioSampleBuffer (chunk, 0, numSamples))
+                break;
+
+            position += numSamples;
+        }
+
+        // deleting the writer fills in the header and closes the file
+        writer = nullptr;
+        succeeded = position >= lengthInSamples
+                     && tempFile.getSize() == AudioSampleBufferAudioFormat::getFileSize (numChannels, lengthInSamples);
+    }
+
+    if (succeeded && tempFile.moveFileTo (cacheFile))
+        return true;
+
+    tempFile.deleteFile();
+    return false;
+}
+
+void DecodedAudioCache::removeLeastRecentlyUsedFiles()
+{
+    Array<File> cacheFiles (getCacheFiles (cacheFileExtension));
+
+    LeastRecentlyUsedComparator comparator;
+    cacheFiles.sort (comparator);
+
+    int64 totalSize = 0;
+
+    for (int i = 0; i < cacheFiles.size(); ++i)
+        totalSize += cacheFiles.getReference (i).getSize();
+
+    // files still mapped by a player may fail to delete on some platforms, they'll go next time
+    for (int i = 0; i < cacheFiles.size() && totalSize > maximumSize; ++i)
+    {
+        const int64 fileSize = cacheFiles.getReference (i).getSize();
+
+        if (cacheFiles.getReference (i).deleteFile())
+            totalSize -= fileSize;
+    }
+
+    removeStaleKeys();
+}
+
+void DecodedAudioCache::removeStaleKeys()
+{
+    // keys go when the entry they point to does, which keeps them to the same
+    // least recently used policy as the cache files
+    const Array<File> keyFiles (getCacheFiles (keyFileExtension));
+
+    for (int i = 0; i < keyFiles.size(); ++i)
+    {
+        const File& keyFile = keyFiles.getReference (i);
+
+        if (! getCacheFileForKey (keyFile.loadFileAsString().trim()).existsAsFile())
+            keyFile.deleteFile();
+    }
+
+    StringArray fileIds;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (HashMap<String, String>::Iterator i (keyCache); i.next();)
+            fileIds.add (i.getKey());
+    }
+
+    for (int i = 0; i < fileIds.size(); ++i)
+    {
+        if (! getKeyFileFor (fileIds[i]).existsAsFile())
+        {
+            const ScopedLock sl (lock);
+            keyCache.remove (fileIds[i]);
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_DECODEDAUDIOCACHE_H__
+#define __DROWAUDIO_DECODEDAUDIOCACHE_H__
+
+//==============================================================================
+/**
+    An on-disk cache of decoded audio files.
+
+    Decoding compressed files such as MP3 and AAC takes a significant amount of
+    time and has to be done every time the file is loaded. This keeps a decoded
+    copy of files in a directory, stored using the AudioSampleBufferAudioFormat
+    so that they can be memory mapped. Once a file has been cached,
+    createReaderFor() returns a MemoryMappedAudioFormatReader for it rather
+    than having to decode it again.
+
+    Files are added by calling addToCache(), which decodes them on a background
+    thread. Entries are named after an MD5 hash of the source file's contents,
+    which is also worked out on the background thread. A small key file named
+    after the source file's path, size and modification time points to the
+    entry, so looking a file up never has to read it. A file that has been
+    moved or renamed isn't found by its new name until it has been passed to
+    addToCache() again, but this only links it to the existing entry rather
+    than decoding it again. Once the cache grows larger than its maximum size
+    the entries that were least recently used are deleted along with the keys
+    that point to them.
+
+    The cached data uses the machine's native byte order so cache directories
+    shouldn't be shared between different platforms.
+
+    @see AudioFilePlayer::setDecodedAudioCache
+ */
+class DecodedAudioCache :   private Thread
+{
+public:
+    //==============================================================================
+    /** Creates a cache that stores its files in the given directory.
+
+        @param cacheDirectory       the directory to store the decoded files in. This
+                                    will be created if it doesn't already exist.
+        @param maximumSizeInBytes   the size the cache will be kept under
+        @param formatManagerToUse   the format manager to decode files with. If this is
+                                    nullptr then one with the basic formats will be
+                                    created.
+     */
+    DecodedAudioCache (const File& cacheDirectory,
+                       int64 maximumSizeInBytes,
+                       AudioFormatManager* formatManagerToUse = nullptr);
+
+    /** Destructor.
+        This will stop any file that is currently being added.
+     */
+    ~DecodedAudioCache();
+
+    //==============================================================================
+    /** Returns a reader for a file if it is in the cache.
+
+        The reader will already have been mapped into memory so can be read from on
+        the audio thread. This will return nullptr if the file hasn't been cached.
+        The caller is responsible for deleting the reader. This doesn't read the
+        source file so is quick to call when opening it.
+     */
+    MemoryMappedAudioFormatReader* createReaderFor (const File& file);
+
+    /** Returns true if the file has been added to the cache.
+     */
+    bool isCached (const File& file);
+
+    /** Decodes a file into the cache on the background thread.
+        If the file is already cached this does nothing.
+     */
+    void addToCache (const File& file);
+
+    /** Removes all the files from the cache.
+     */
+    void clear();
+
+    //==============================================================================
+    /** Sets the size in bytes that the cache will be kept under.
+     */
+    void setMaximumSize (int64 newMaximumSizeInBytes);
+
+    /** Returns the size in bytes that the cache will be kept under.
+     */
+    int64 getMaximumSize() const noexcept           {   return maximumSize;     }
+
+    /** Returns the number of bytes currently used by the cache.
+     */
+    int64 getCurrentSize() const;
+
+    /** Returns the directory the cache is stored in.
+     */
+    const File& getCacheDirectory() const noexcept  {   return cacheDirectory;  }
+
+private:
+    //==============================================================================
+    const File cacheDirectory;
+    int64 volatile maximumSize;
+    OptionalScopedPointer<AudioFormatManager> formatManager;
+
+    CriticalSection lock;
+    Array<File> filesToAdd;
+    HashMap<String, String> keyCache;
+
+    //==============================================================================
+    void run();
+
+    File getCacheFileFor (const File& file);
+    File getCacheFileForKey (const String& key) const;
+    File getKeyFileFor (const String& fileId) const;
+    Array<File> getCacheFiles (const String& extension) const;
+    void writeCacheFile (const File& sourceFile);
+    bool decodeToCacheFile (const File& sourceFile, const File& cacheFile);
+    void removeLeastRecentlyUsedFiles();
+    void removeStaleKeys();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedAudioCache);
+};
+
+#endif // __DROWAUDIO_DECODEDAUDIOCACHE_H__
@@ -64,3 +64,20 @@ void EnvelopeFollower::setCoefficients (float attack, float release) noexcept
     envRelease = release;
 }
 
+void EnvelopeFollower::setTimes (double attackSeconds, double releaseSeconds, double sampleRate) noexcept
+{
+    setCoefficients (timeToCoefficient (attackSeconds, sampleRate),
+                     timeToCoefficient (releaseSeconds, sampleRate));
+}
+
+//==============================================================================
+float EnvelopeFollower::timeToCoefficient (double timeInSeconds, double sampleRate) noexcept
+{
+    const double timeInSamples = timeInSeconds * sampleRate;
+
+    if (timeInSamples <= 1.0)
+        return 1.0f;
+
+    return (float) (1.0 - exp (-1.0 / timeInSamples));
+}
+
@@ -61,6 +61,17 @@ public:
         1 is an instant attack/release, 0 ill never change the value.
      */
 	void setCoefficients (float attack, float release) noexcept;
+
+	/** Sets the attack and release times in seconds.
+        These are the times taken to move 63% of the way to a new level.
+     */
+	void setTimes (double attackSeconds, double releaseSeconds, double sampleRate) noexcept;
+
+    //==============================================================================
+    /** Returns the coefficient that will move an envelope 63% of the way to a new
+        level in a given time.
+     */
+    static float timeToCoefficient (double timeInSeconds, double sampleRate) noexcept;
 	
 private:
     //==============================================================================
@@ -39,14 +39,34 @@ namespace
         {1000,  0.25f},
         {13000,  0.25f}
     };
+
+    // gains are smoothed and the coefficients recalculated every this many samples
+    const int gainSmoothingBlockSize = 32;
+    const double gainSmoothingTime = 0.01;
+
+    // band edges for the isolator, typical of a rotary DJ mixer
+    const double isolatorLowCrossover = 300.0;
+    const double isolatorHighCrossover = 4000.0;
+    const double butterworthQ = 0.70710678;
+    const int isolatorBlockSize = 512;
 }
 
 //========================================================================
 FilteringAudioSource::FilteringAudioSource (AudioSource* inputSource,
                                             bool deleteInputWhenDeleted)
     : input         (inputSource, deleteInputWhenDeleted),
+      filters       (numFilters),
+      lowBandFilter (2),
+      lowCrossoverAllpass (1),
+      lowBandCompensation (1),
+      midBandFilter (2),
+      highCrossoverAllpass (1),
+      lowBuffer     (2, isolatorBlockSize),
+      midBuffer     (2, isolatorBlockSize),
 	  sampleRate    (44100.0),
-	  filterSource  (true)
+	  filterSource  (true),
+      mode          (Shelving),
+      currentMode   (Shelving)
 {
     jassert (input != nullptr);
     
@@ -66,35 +86,9 @@ FilteringAudioSource::~FilteringAudioSource()
 //==============================================================================
 void FilteringAudioSource::setGain (FilterType setting, float newGain)
 {
-    switch (setting)
-    {
-        case Low:
-        {
-            gains[Low] = newGain;
-            const IIRCoefficients lowCoeff (IIRCoefficients::makeLowShelf       (sampleRate, defaultSettings[Low][CF], defaultSettings[Low][Q], gains[Low]));
-            filter[0][Low].setCoefficients (lowCoeff);
-            filter[1][Low].setCoefficients (lowCoeff);
-            break;
-        }
-        case Mid:
-        {
-            gains[Mid] = newGain;
-            const IIRCoefficients midCoeff (IIRCoefficients::makePeakFilter     (sampleRate, defaultSettings[Mid][CF], defaultSettings[Mid][Q], gains[Mid]));
-            filter[0][Mid].setCoefficients (midCoeff);
-            filter[1][Mid].setCoefficients (midCoeff);
-            break;
-        }
-        case High:
-        {
-            gains[High] = newGain;
-            const IIRCoefficients highCoeff (IIRCoefficients::makeHighShelf     (sampleRate, defaultSettings[High][CF], defaultSettings[High][Q], gains[High]));
-            filter[0][High].setCoefficients (highCoeff);
-            filter[1][High].setCoefficients (highCoeff);
-            break;
-        }
-        default:
-            break;
-    }
+    // the coefficients are updated from the audio thread as the gain is smoothed
+    if (isPositiveAndBelow ((int) setting, (int) numFilters))
+        gains[setting] = newGain;
 }
 
 void FilteringAudioSource::setFilterSource (bool shouldFilter)
@@ -102,6 +96,12 @@ void FilteringAudioSource::setFilterSource (bool shouldFilter)
     filterSource = shouldFilter;
 }
 
+void FilteringAudioSource::setMode (Mode newMode)
+{
+    // the audio thread will pick this up and clear the filters
+    mode = newMode;
+}
+
 //==============================================================================
 void FilteringAudioSource::prepareToPlay (int samplesPerBlockExpected,
                                           double sampleRate_)
@@ -124,37 +124,188 @@ void FilteringAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info
 {
     input->getNextAudioBlock (info);
 
-    if (filterSource && info.buffer->getNumChannels() > 0)
+    if (! filterSource || info.buffer->getNumChannels() == 0)
+        return;
+
+    if (mode != currentMode)
+    {
+        currentMode = mode;
+        filters.reset();
+        resetIsolator();
+        isBypassed = false;
+
+        // the shelving coefficients aren't kept up to date in isolator mode
+        updateCoefficients();
+        filters.snapToTargetCoefficients();
+    }
+
+    if (currentMode == Isolator)
+        processIsolator (info);
+    else
+        processShelving (info);
+}
+
+void FilteringAudioSource::resetFilters()
+{
+    gainSmoothingCoefficient = (float) (1.0 - exp (-gainSmoothingBlockSize / (gainSmoothingTime * sampleRate)));
+
+    for (int i = 0; i < numFilters; ++i)
+        currentGains[i] = gains[i];
+
+    updateCoefficients();
+    filters.snapToTargetCoefficients();
+    filters.reset();
+    isBypassed = false;
+
+    resetIsolator();
+}
+
+void FilteringAudioSource::resetIsolator()
+{
+    const IIRCoefficients lowCrossoverLowPass (BiquadFilter::makeLowPass (sampleRate, isolatorLowCrossover, butterworthQ));
+    const IIRCoefficients lowAllpass (BiquadFilter::makeAllpass (sampleRate, isolatorLowCrossover, butterworthQ));
+    const IIRCoefficients highCrossoverLowPass (BiquadFilter::makeLowPass (sampleRate, isolatorHighCrossover, butterworthQ));
+    const IIRCoefficients highAllpass (BiquadFilter::makeAllpass (sampleRate, isolatorHighCrossover, butterworthQ));
+
+    // a Linkwitz-Riley low pass is two Butterworth stages
+    lowBandFilter.setCoefficients (0, lowCrossoverLowPass);
+    lowBandFilter.setCoefficients (1, lowCrossoverLowPass);
+    lowCrossoverAllpass.setCoefficients (0, lowAllpass);
+    lowBandCompensation.setCoefficients (0, highAllpass);
+    midBandFilter.setCoefficients (0, highCrossoverLowPass);
+    midBandFilter.setCoefficients (1, highCrossoverLowPass);
+    highCrossoverAllpass.setCoefficients (0, highAllpass);
+
+    StereoBiquadCascade* const cascades[] = { &lowBandFilter, &lowCrossoverAllpass, &lowBandCompensation,
+                                              &midBandFilter, &highCrossoverAllpass };
+
+    for (int i = 0; i < numElementsInArray (cascades); ++i)
+    {
+        cascades[i]->snapToTargetCoefficients();
+        cascades[i]->reset();
+    }
+}
+
+bool FilteringAudioSource::updateCurrentGains (float smoothingCoefficient) noexcept
+{
+    bool gainsChanged = false;
+
+    for (int i = 0; i < numFilters; ++i)
     {
-        const int bufferNumSamples = info.numSamples;
-        float* sampleDataL = info.buffer->getWritePointer (0, info.startSample);
-        
-        filter[0][Low].processSamples   (sampleDataL, bufferNumSamples);
-        filter[0][Mid].processSamples   (sampleDataL, bufferNumSamples);
-        filter[0][High].processSamples  (sampleDataL, bufferNumSamples);
-
-        if (info.buffer->getNumChannels() > 1)
+        const float target = gains[i];
+
+        if (currentGains[i] != target)
         {
-            float* sampleDataR = info.buffer->getWritePointer (1, info.startSample);
+            currentGains[i] += (target - currentGains[i]) * smoothingCoefficient;
 
-            filter[1][Low].processSamples   (sampleDataR, bufferNumSamples);
-            filter[1][Mid].processSamples   (sampleDataR, bufferNumSamples);
-            filter[1][High].processSamples  (sampleDataR, bufferNumSamples);
+            if (std::abs (target - currentGains[i]) < 1.0e-4f)
+                currentGains[i] = target;
+
+            gainsChanged = true;
         }
     }
+
+    return gainsChanged;
 }
 
-void FilteringAudioSource::resetFilters()
+void FilteringAudioSource::updateCoefficients() noexcept
+{
+    filters.setCoefficients (Low,   IIRCoefficients::makeLowShelf   (sampleRate, defaultSettings[Low][CF], defaultSettings[Low][Q], currentGains[Low]));
+    filters.setCoefficients (Mid,   IIRCoefficients::makePeakFilter (sampleRate, defaultSettings[Mid][CF], defaultSettings[Mid][Q], currentGains[Mid]));
+    filters.setCoefficients (High,  IIRCoefficients::makeHighShelf  (sampleRate, defaultSettings[High][CF], defaultSettings[High][Q], currentGains[High]));
+}
+
+//==============================================================================
+void FilteringAudioSource::processShelving (const AudioSourceChannelInfo& info)
 {
-    const IIRCoefficients lowCoeff (IIRCoefficients::makeLowShelf       (sampleRate, defaultSettings[Low][CF], defaultSettings[Low][Q], gains[Low]));
-    const IIRCoefficients midCoeff (IIRCoefficients::makePeakFilter     (sampleRate, defaultSettings[Mid][CF], defaultSettings[Mid][Q], gains[Mid]));
-    const IIRCoefficients highCoeff (IIRCoefficients::makeHighShelf     (sampleRate, defaultSettings[High][CF], defaultSettings[High][Q], gains[High]));
-
-    filter[0][Low].setCoefficients (lowCoeff);
-    filter[1][Low].setCoefficients (lowCoeff);
-    filter[0][Mid].setCoefficients (midCoeff);
-    filter[1][Mid].setCoefficients (midCoeff);
-    filter[0][High].setCoefficients (highCoeff);
-    filter[1][High].setCoefficients (highCoeff);
+    const bool gainsChanged = updateCurrentGains (gainSmoothingCoefficient);
+
+    if (gainsChanged)
+        updateCoefficients();
+
+    if (! gainsChanged && currentGains[Low] == 1.0f && currentGains[Mid] == 1.0f && currentGains[High] == 1.0f)
+    {
+        // at unity gain the filters pass the signal unchanged and with their
+        // state cleared will continue to do so when they're next used
+        if (! isBypassed)
+        {
+            filters.reset();
+            isBypassed = true;
+        }
+
+        return;
+    }
+
+    isBypassed = false;
+
+    float* sampleDataL = info.buffer->getWritePointer (0, info.startSample);
+    float* sampleDataR = info.buffer->getNumChannels() > 1 ? info.buffer->getWritePointer (1, info.startSample)
+                                                           : nullptr;
+
+    for (int pos = 0; pos < info.numSamples;)
+    {
+        if (pos > 0 && updateCurrentGains (gainSmoothingCoefficient))
+            updateCoefficients();
+
+        const int numThisTime = jmin (gainSmoothingBlockSize, info.numSamples - pos);
+
+        filters.processSamples (sampleDataL + pos,
+                                sampleDataR != nullptr ? sampleDataR + pos : nullptr,
+                                numThisTime);
+        pos += numThisTime;
+    }
 }
 
+void FilteringAudioSource::processIsolator (const AudioSourceChannelInfo& info)
+{
+    const int numChannels = jmin (2, info.buffer->getNumChannels());
+
+    for (int pos = 0; pos < info.numSamples;)
+    {
+        const int numThisTime = jmin (isolatorBlockSize, info.numSamples - pos);
+        const int startSample = info.startSample + pos;
+
+        float* band[2] = { info.buffer->getWritePointer (0, startSample),
+                           numChannels > 1 ? info.buffer->getWritePointer (1, startSample) : nullptr };
+        float* low[2] = { lowBuffer.getWritePointer (0), numChannels > 1 ? lowBuffer.getWritePointer (1) : nullptr };
+        float* mid[2] = { midBuffer.getWritePointer (0), numChannels > 1 ? midBuffer.getWritePointer (1) : nullptr };
+
+        for (int c = 0; c < numChannels; ++c)
+            lowBuffer.copyFrom (c, 0, band[c], numThisTime);
+
+        // each Linkwitz-Riley high pass is the matching all pass minus the low pass,
+        // so the band buffer becomes everything above the low and then the high band
+        lowBandFilter.processSamples (low[0], low[1], numThisTime);
+        lowCrossoverAllpass.processSamples (band[0], band[1], numThisTime);
+
+        for (int c = 0; c < numChannels; ++c)
+            info.buffer->addFrom (c, startSample, lowBuffer, c, 0, numThisTime, -1.0f);
+
+        // keeps the low band in phase with the upper two
+        lowBandCompensation.processSamples (low[0], low[1], numThisTime);
+
+        for (int c = 0; c < numChannels; ++c)
+            midBuffer.copyFrom (c, 0, band[c], numThisTime);
+
+        midBandFilter.processSamples (mid[0], mid[1], numThisTime);
+        highCrossoverAllpass.processSamples (band[0], band[1], numThisTime);
+
+        float startGains[numFilters];
+
+        for (int i = 0; i < numFilters; ++i)
+            startGains[i] = currentGains[i];
+
+        updateCurrentGains ((float) (1.0 - exp (-numThisTime / (gainSmoothingTime * sampleRate))));
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            info.buffer->addFrom (c, startSample, midBuffer, c, 0, numThisTime, -1.0f);
+
+            info.buffer->applyGainRamp (c, startSample, numThisTime, startGains[High], currentGains[High]);
+            info.buffer->addFromWithRamp (c, startSample, low[c], numThisTime, startGains[Low], currentGains[Low]);
+            info.buffer->addFromWithRamp (c, startSample, mid[c], numThisTime, startGains[Mid], currentGains[Mid]);
+        }
+
+        pos += numThisTime;
+    }
+}
@@ -32,10 +32,23 @@
 #ifndef __DROWAUDIO_FILTERINGAUDIOSOURCE_H__
 #define __DROWAUDIO_FILTERINGAUDIOSOURCE_H__
 
+#include "filters/dRowAudio_StereoBiquadCascade.h"
+#include "dRowAudio_AudioSourceWithLatency.h"
+
 //==============================================================================
 /**	An AudioSource that contains three settable filters to EQ the audio stream.
+
+    The first two channels are filtered together in a single pass. Gain changes
+    are smoothed so moving the EQ doesn't cause zipper noise, and when all the
+    gains are at unity the filtering is skipped altogether.
+
+    In Isolator mode the signal is instead split into three bands by a pair of
+    Linkwitz-Riley crossovers and the gains applied to each band. This means a
+    gain of 0 will completely remove a band and changing a gain doesn't need any
+    new filter coefficients.
  */
-class FilteringAudioSource : public AudioSource
+class FilteringAudioSource : public AudioSource,
+                             public AudioSourceWithLatency
 {
 
 public:
@@ -54,6 +67,12 @@ public:
         Q,
         numFilterSettings
     };
+
+    enum Mode
+    {
+        Shelving = 0,
+        Isolator
+    };
     
 	//==============================================================================
     /** Creates an FilteringAudioTransportSource.
@@ -69,6 +88,10 @@ public:
      */
     void setGain (FilterType setting, float newGain);
 
+    /** Returns one of the filter gains.
+     */
+    float getGain (FilterType setting) const    { return gains[setting]; }
+
 	/** Toggles the filtering of the transport source.
 	 */
 	void setFilterSource (bool shouldFilter);
@@ -77,6 +100,15 @@ public:
 	 */
 	bool getFilterSource()				{ return filterSource; }
 
+    /** Sets whether the gains are applied by shelving and peak filters or by
+        splitting the signal into bands.
+     */
+    void setMode (Mode newMode);
+
+    /** Returns the current filtering mode.
+     */
+    Mode getMode() const noexcept       { return mode; }
+
     //==============================================================================
     /** Implementation of the AudioSource method. */
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
@@ -86,18 +118,34 @@ public:
 	
     /** Implementation of the AudioSource method. */
     void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+    //==============================================================================
+    /** Implements the AudioSourceWithLatency method.
+        The filters are minimum phase so only the latency of the input is reported.
+     */
+    int getLatencySamples() const       { return getLatencySamplesOf (input); }
 		
 private:
     //==============================================================================
     OptionalScopedPointer<AudioSource> input;
-    float gains[numFilters];
-	IIRFilter filter[2][numFilters];
+    float gains[numFilters], currentGains[numFilters];
+    StereoBiquadCascade filters;
+    StereoBiquadCascade lowBandFilter, lowCrossoverAllpass, lowBandCompensation, midBandFilter, highCrossoverAllpass;
+    AudioSampleBuffer lowBuffer, midBuffer;
 	
     double sampleRate;
-	bool filterSource;
+    float gainSmoothingCoefficient;
+	bool filterSource, isBypassed;
+    Mode volatile mode;
+    Mode currentMode;
 
     //==============================================================================
     void resetFilters();
+    void resetIsolator();
+    bool updateCurrentGains (float smoothingCoefficient) noexcept;
+    void updateCoefficients() noexcept;
+    void processShelving (const AudioSourceChannelInfo& info);
+    void processIsolator (const AudioSourceChannelInfo& info);
 
     //==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilteringAudioSource);
@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+GaplessAudioFilePlayer::GaplessAudioFilePlayer (TimeSliceThread* threadToUse,
+                                                AudioFormatManager* formatManagerToUse)
+    : bufferingTimeSliceThread ((threadToUse == nullptr ? new TimeSliceThread ("Shared Buffering Thread")
+                                                        : threadToUse),
+                                threadToUse == nullptr),
+      formatManager ((formatManagerToUse == nullptr ? new AudioFormatManager()
+                                                    : formatManagerToUse),
+                     formatManagerToUse == nullptr),
+      currentPlayer (nullptr),
+      nextPlayer (nullptr),
+      nextIsReady (false),
+      shouldBePlaying (false),
+      nextStarted (false),
+      nextStartOffset (0),
+      fadeLength (0),
+      fadePosition (0),
+      currentSampleRate (44100.0),
+      crossfadeLength (0.0),
+      crossfadeSamples (0),
+      tempBuffer (2, 512)
+{
+    if (threadToUse == nullptr)
+        bufferingTimeSliceThread->startThread (3);
+
+    if (formatManagerToUse == nullptr)
+        formatManager->registerBasicFormats();
+
+    playerA = new AudioFilePlayer (bufferingTimeSliceThread, formatManager);
+    playerB = new AudioFilePlayer (bufferingTimeSliceThread, formatManager);
+    playerA->addListener (this);
+    playerB->addListener (this);
+
+    currentPlayer = playerA;
+    nextPlayer = playerB;
+}
+
+GaplessAudioFilePlayer::~GaplessAudioFilePlayer()
+{
+    playerA->removeListener (this);
+    playerB->removeListener (this);
+}
+
+//==============================================================================
+bool GaplessAudioFilePlayer::setFile (const File& newFile)
+{
+    clearNextFile();
+
+    const bool loadedOk = currentPlayer->setFile (newFile);
+
+    if (loadedOk && shouldBePlaying)
+        currentPlayer->start();
+
+    return loadedOk;
+}
+
+void GaplessAudioFilePlayer::queueNextFile (const File& fileToQueue)
+{
+    {
+        const ScopedLock sl (lock);
+
+        // the next player is already playing so wait until it becomes the current one
+        if (nextStarted)
+        {
+            fileToQueueAfterHandoff = fileToQueue;
+            return;
+        }
+
+        nextIsReady = false;
+    }
+
+    nextFile = fileToQueue;
+    nextPlayer->stop();
+    nextPlayer->setFileAsync (fileToQueue);
+}
+
+void GaplessAudioFilePlayer::clearNextFile()
+{
+    {
+        const ScopedLock sl (lock);
+        nextIsReady = false;
+        nextStarted = false;
+    }
+
+    nextPlayer->cancelAsyncLoad();
+    nextPlayer->stop();
+
+    nextFile = File::nonexistent;
+    fileToQueueAfterHandoff = File::nonexistent;
+}
+
+void GaplessAudioFilePlayer::setCrossfadeLength (double newLengthInSeconds)
+{
+    const ScopedLock sl (lock);
+
+    crossfadeLength = jmax (0.0, newLengthInSeconds);
+    crossfadeSamples = roundToInt (crossfadeLength * currentSampleRate);
+}
+
+//==============================================================================
+void GaplessAudioFilePlayer::start()
+{
+    // the audio thread swaps the players over under the lock, so holding it
+    // makes sure both are started even if the handoff happens at the same time
+    const ScopedLock sl (lock);
+
+    shouldBePlaying = true;
+    currentPlayer->start();
+
+    if (nextStarted)
+        nextPlayer->start();
+}
+
+void GaplessAudioFilePlayer::stop()
+{
+    const ScopedLock sl (lock);
+
+    shouldBePlaying = false;
+    currentPlayer->stop();
+
+    if (nextStarted)
+        nextPlayer->stop();
+}
+
+//==============================================================================
+void GaplessAudioFilePlayer::addListener (GaplessAudioFilePlayer::Listener* const listener)
+{
+    listeners.add (listener);
+}
+
+void GaplessAudioFilePlayer::removeListener (GaplessAudioFilePlayer::Listener* const listener)
+{
+    listeners.remove (listener);
+}
+
+//==============================================================================
+void GaplessAudioFilePlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    {
+        const ScopedLock sl (lock);
+
+        currentSampleRate = sampleRate;
+        crossfadeSamples = roundToInt (crossfadeLength * currentSampleRate);
+        tempBuffer.setSize (2, samplesPerBlockExpected);
+    }
+
+    playerA->prepareToPlay (samplesPerBlockExpected, sampleRate);
+    playerB->prepareToPlay (samplesPerBlockExpected, sampleRate);
+}
+
+void GaplessAudioFilePlayer::releaseResources()
+{
+    playerA->releaseResources();
+    playerB->releaseResources();
+}
+
+void GaplessAudioFilePlayer::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    AudioFilePlayer* const current = currentPlayer;
+
+    // the lock is only held briefly whilst the queue is changed
+    // so just carry on with the current file if that's happening
+    const ScopedTryLock sl (lock);
+
+    if (sl.isLocked() && nextIsReady)
+    {
+        if (! nextStarted
+             && shouldBePlaying
+             && ! current->isLooping()
+             && (current->isPlaying() || current->hasStreamFinished()))
+        {
+            const int64 numRemaining = jmax ((int64) 0, current->getTotalLength() - current->getNextReadPosition());
+            const int64 startOffset = jmax ((int64) 0, numRemaining - crossfadeSamples);
+
+            if (startOffset < info.numSamples)
+            {
+                nextStarted = true;
+                nextStartOffset = (int) startOffset;
+                fadeLength = (int) jmin ((int64) crossfadeSamples, numRemaining);
+                fadePosition = 0;
+
+                // AudioFilePlayer::start() would call its listeners on this thread
+                nextPlayer->getAudioTransportSource()->start();
+            }
+        }
+
+        if (nextStarted)
+        {
+            mixInNextPlayer (info);
+            return;
+        }
+    }
+
+    current->getNextAudioBlock (info);
+}
+
+//==============================================================================
+void GaplessAudioFilePlayer::mixInNextPlayer (const AudioSourceChannelInfo& info)
+{
+    AudioFilePlayer* const current = currentPlayer;
+    AudioFilePlayer* const next = nextPlayer;
+
+    current->getNextAudioBlock (info);
+
+    const int offset = nextStartOffset;
+    const int numSamples = info.numSamples - offset;
+    const int numChannels = info.buffer->getNumChannels();
+    nextStartOffset = 0;
+
+    if (tempBuffer.getNumChannels() < numChannels || tempBuffer.getNumSamples() < numSamples)
+        tempBuffer.setSize (jmax (numChannels, tempBuffer.getNumChannels()),
+                            jmax (numSamples, tempBuffer.getNumSamples()),
+                            false, false, true);
+
+    AudioSourceChannelInfo nextInfo;
+    nextInfo.buffer = &tempBuffer;
+    nextInfo.startSample = 0;
+    nextInfo.numSamples = numSamples;
+    next->getNextAudioBlock (nextInfo);
+
+    // equal power fade over the end of the current file, after which it will be silent
+    const int numToFade = jmin (numSamples, fadeLength - fadePosition);
+    const float angleDelta = fadeLength > 0 ? float_Pi * 0.5f / fadeLength : 0.0f;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        float* dest = info.buffer->getWritePointer (i, info.startSample + offset);
+        const float* src = tempBuffer.getReadPointer (i);
+
+        for (int s = 0; s < numToFade; ++s)
+        {
+            const float angle = (fadePosition + s + 0.5f) * angleDelta;
+            dest[s] = dest[s] * std::cos (angle) + src[s] * std::sin (angle);
+        }
+
+        info.buffer->addFrom (i, info.startSample + offset + numToFade,
+                              tempBuffer, i, numToFade, numSamples - numToFade);
+    }
+
+    fadePosition += numToFade;
+
+    if (fadePosition >= fadeLength
+         && current->getNextReadPosition() >= current->getTotalLength())
+    {
+        currentPlayer = next;
+        nextPlayer = current;
+        nextIsReady = false;
+        nextStarted = false;
+
+        triggerAsyncUpdate();
+    }
+}
+
+void GaplessAudioFilePlayer::fileChanged (AudioFilePlayer* /*player*/)
+{
+}
+
+void GaplessAudioFilePlayer::asyncFileLoadFinished (AudioFilePlayer* player, const File& /*file*/, bool loadedOk)
+{
+    if (player == nextPlayer && loadedOk)
+    {
+        const ScopedLock sl (lock);
+        nextIsReady = true;
+    }
+}
+
+void GaplessAudioFilePlayer::handleAsyncUpdate()
+{
+    nextFile = File::nonexistent;
+
+    listeners.call (&Listener::currentFileChanged, this);
+
+    if (fileToQueueAfterHandoff != File::nonexistent)
+    {
+        const File fileToQueue (fileToQueueAfterHandoff);
+        fileToQueueAfterHandoff = File::nonexistent;
+
+        queueNextFile (fileToQueue);
+    }
+}
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_GAPLESSAUDIOFILEPLAYER_H__
+#define __DROWAUDIO_GAPLESSAUDIOFILEPLAYER_H__
+
+#include "dRowAudio_AudioFilePlayer.h"
+
+//==============================================================================
+/**
+    Plays a sequence of audio files back to back without any gaps.
+
+    This holds two AudioFilePlayers. One plays the current file whilst the next
+    file is opened and buffered in the other in the background. When the current
+    file reaches its end the next one is started at exactly the following sample,
+    or optionally crossfaded into, from within getNextAudioBlock(). The players
+    then swap roles so another file can be queued.
+
+    @see AudioFilePlayer
+ */
+class GaplessAudioFilePlayer  : public AudioSource,
+                                private AudioFilePlayer::Listener,
+                                private AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Creates an empty GaplessAudioFilePlayer.
+        If either of the parameters is nullptr the player will create its own. If
+        you supply your own thread remember to start it!
+     */
+    GaplessAudioFilePlayer (TimeSliceThread* threadToUse = nullptr,
+                            AudioFormatManager* formatManagerToUse = nullptr);
+
+    /** Destructor. */
+    ~GaplessAudioFilePlayer();
+
+    //==============================================================================
+    /** Loads a file to play straight away, replacing the current one.
+        Any file that has been queued is cancelled.
+
+        @returns true if the file loaded correctly
+     */
+    bool setFile (const File& newFile);
+
+    /** Queues a file to be played when the current one finishes.
+
+        The file is opened and buffered in the background. If it isn't ready by the
+        time the current file finishes there will be a gap until it is. Queuing
+        another file replaces this one. If the handoff to the previously queued file
+        has already started this will be queued once it has finished.
+     */
+    void queueNextFile (const File& nextFile);
+
+    /** Removes any queued file. */
+    void clearNextFile();
+
+    /** Returns the file that has been queued, if any. */
+    const File& getNextFile() const noexcept                    {   return nextFile;    }
+
+    /** Returns true if the queued file has been opened and is ready to play. */
+    bool isNextFileReady() const noexcept                       {   return nextIsReady; }
+
+    /** Sets the length of the crossfade between files in seconds.
+        The default of 0 starts the next file on the sample after the current one ends.
+     */
+    void setCrossfadeLength (double newLengthInSeconds);
+
+    /** Returns the length of the crossfade between files in seconds. */
+    double getCrossfadeLength() const noexcept                  {   return crossfadeLength; }
+
+    //==============================================================================
+    /** Starts playing the current file. */
+    void start();
+
+    /** Stops playing. */
+    void stop();
+
+    /** Returns true if it's currently playing. */
+    bool isPlaying() const noexcept                             {   return shouldBePlaying; }
+
+    /** Returns the player of the current file.
+        Use this to change the position, find the file that is playing etc.
+     */
+    AudioFilePlayer& getCurrentPlayer() const noexcept          {   return *currentPlayer;  }
+
+    //==============================================================================
+    /** A class for receiving callbacks from a GaplessAudioFilePlayer.
+     */
+    class Listener
+    {
+    public:
+        //==============================================================================
+        /** Destructor. */
+        virtual ~Listener() {}
+
+        /** Called on the message thread after playback has moved on to the queued file.
+            You can find the new file from getCurrentPlayer().
+         */
+        virtual void currentFileChanged (GaplessAudioFilePlayer* player) = 0;
+    };
+
+    /** Adds a listener to be told when the current file changes. */
+    void addListener (Listener* listener);
+
+    /** Removes a previously-registered listener. */
+    void removeListener (Listener* listener);
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<TimeSliceThread> bufferingTimeSliceThread;
+    OptionalScopedPointer<AudioFormatManager> formatManager;
+    ScopedPointer<AudioFilePlayer> playerA, playerB;
+    AudioFilePlayer* volatile currentPlayer;
+    AudioFilePlayer* volatile nextPlayer;
+
+    CriticalSection lock;
+    File nextFile, fileToQueueAfterHandoff;
+    bool volatile nextIsReady, shouldBePlaying;
+    bool nextStarted;
+    int nextStartOffset, fadeLength, fadePosition;
+
+    double currentSampleRate, crossfadeLength;
+    int crossfadeSamples;
+    AudioSampleBuffer tempBuffer;
+
+    ListenerList<Listener> listeners;
+
+    //==============================================================================
+    void mixInNextPlayer (const AudioSourceChannelInfo& bufferToFill);
+    void fileChanged (AudioFilePlayer* player);
+    void asyncFileLoadFinished (AudioFilePlayer* player, const File& file, bool loadedOk);
+    void handleAsyncUpdate();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GaplessAudioFilePlayer);
+};
+
+#endif // __DROWAUDIO_GAPLESSAUDIOFILEPLAYER_H__
@@ -29,22 +29,43 @@
   ==============================================================================
 */
 
-
+namespace
+{
+    // The longest crossfade that can be applied at the loop seam
+    const double maxLoopCrossfadeLength = 0.1;
+}
 
 //==============================================================================
 LoopingAudioSource::LoopingAudioSource (PositionableAudioSource* const inputSource,
-                                        const bool deleteInputWhenDeleted)
+                                        const bool deleteInputWhenDeleted,
+                                        int numberOfChannels_)
     : input (inputSource, deleteInputWhenDeleted),
+      numberOfChannels (numberOfChannels_),
       isLoopingBetweenTimes (false),
-      loopStartSample (0),
-      loopEndSample (0),
-      tempBuffer (2, 512)
+      loopStartTime (0.0),
+      loopEndTime (0.0),
+      currentSampleRate (44100.0),
+      pendingReadPosition (-1),
+      loopCacheLength (0.5),
+      crossfadeLength (0.0),
+      loopCacheStartSample (-1),
+      loopCacheResumeSample (0),
+      loopCacheNumSamples (0),
+      loopCacheReadPos (0),
+      loopCacheWritePos (0),
+      isLoopCacheValid (false),
+      isCapturingLoopCache (false),
+      isPlayingFromLoopCache (false),
+      loopCachePlayPosition (-1),
+      crossfadeSamples (0),
+      fadeLength (0),
+      fadePosition (0),
+      playbackRatio (1.0)
 {
     jassert (inputSource != nullptr);
-    
-    tempInfo.numSamples = tempBuffer.getNumSamples();
-    tempInfo.startSample = 0;
-    tempInfo.buffer = &tempBuffer;
+
+    loopRegion.startSample = loopRegion.endSample = 0;
+    audioThreadLoopRegion = loopRegion;
 }
 
 LoopingAudioSource::~LoopingAudioSource()
@@ -56,24 +77,43 @@ void LoopingAudioSource::setLoopTimes (double startTime, double endTime)
 {
     jassert (endTime > startTime); // end time has to be after start!
     
+    int64 wrappedPosition = -1;
+
     {
-        const ScopedLock sl (loopPosLock);
+        const ScopedLock sl (loopWriteLock);
         
+        const LoopRegion oldRegion (loopRegion);
+
         loopStartTime = startTime;
         loopEndTime = endTime;
-        
-        loopStartSample = (int64) (startTime * currentSampleRate);
-        loopEndSample = (int64) (endTime * currentSampleRate);
+
+        publishLoopRegion();
+
+        // if the loop has been shortened past the current position wrap it
+        // back round, otherwise leave the input alone so playback isn't disturbed
+        const int64 position = getNextReadPosition();
+
+        if (isLoopingBetweenTimes
+            && loopRegion.endSample > loopRegion.startSample
+            && position >= loopRegion.startSample
+            && position >= loopRegion.endSample
+            && position < oldRegion.endSample)
+        {
+            wrappedPosition = loopRegion.startSample
+                                + ((position - loopRegion.startSample) % (loopRegion.endSample - loopRegion.startSample));
+        }
     }
 
-    // need to update read position based on new limits
-    setNextReadPosition (getNextReadPosition());
+    if (wrappedPosition >= 0)
+        setNextReadPositionIgnoringLoop (wrappedPosition);
 }
 
 void LoopingAudioSource::getLoopTimes (double& startTime, double& endTime)
 {
+    const ScopedLock sl (loopWriteLock);
+
     startTime = loopStartTime;
-    endTime =loopEndTime;
+    endTime = loopEndTime;
 }
 
 void LoopingAudioSource::setLoopBetweenTimes (bool shouldLoop)
@@ -86,18 +126,43 @@ bool LoopingAudioSource::getLoopBetweenTimes()
     return isLoopingBetweenTimes;
 }
 
+//==============================================================================
+void LoopingAudioSource::setLoopCacheLength (double seconds)
+{
+    loopCacheLength = jmax (0.0, seconds);
+}
+
+void LoopingAudioSource::invalidateLoopCache()
+{
+    loopCacheInvalidated.set (1);
+}
+
+void LoopingAudioSource::setLoopCrossfadeLength (double seconds)
+{
+    crossfadeLength = jlimit (0.0, maxLoopCrossfadeLength, seconds);
+    crossfadeSamples = (int) (crossfadeLength * currentSampleRate);
+}
+
 //==============================================================================
 void LoopingAudioSource::prepareToPlay (int samplesPerBlockExpected,
                                         double sampleRate)
 {
     currentSampleRate = sampleRate;
     input->prepareToPlay (samplesPerBlockExpected, sampleRate);
-    
-    if (tempBuffer.getNumSamples() < samplesPerBlockExpected)
-    {
-        tempBuffer.setSize (2, samplesPerBlockExpected);
-        tempInfo.numSamples = tempBuffer.getNumSamples();
-    }
+
+    loopCache.setSize (numberOfChannels, (int) (loopCacheLength * sampleRate));
+    fadeBuffer.setSize (numberOfChannels, (int) (maxLoopCrossfadeLength * sampleRate));
+    setLoopCrossfadeLength (crossfadeLength);
+
+    const ScopedLock csl (callbackLock);
+    isLoopCacheValid = isCapturingLoopCache = isPlayingFromLoopCache = false;
+    loopCachePlayPosition.set (-1);
+    fadeLength = fadePosition = 0;
+    playbackRatio = 1.0;
+
+    // the loop region is stored in samples so needs updating for the new rate
+    const ScopedLock sl (loopWriteLock);
+    publishLoopRegion();
 }
 
 void LoopingAudioSource::releaseResources()
@@ -107,77 +172,115 @@ void LoopingAudioSource::releaseResources()
 
 void LoopingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
 {
-    if (info.numSamples > 0)
+    if (info.numSamples <= 0)
+        return;
+
+    const ScopedLock sl (callbackLock);
+    applyPendingReadPosition();
+
+    if (loopCacheInvalidated.compareAndSetBool (0, 1))
+        isLoopCacheValid = isCapturingLoopCache = false;
+
+    if (! (isLoopingBetweenTimes || isPlayingFromLoopCache || fadePosition < fadeLength))
+    {
+        input->getNextAudioBlock (info);
+        return;
+    }
+
+    const LoopRegion loop (getLoopRegion());
+
+    if (loop.startSample != loopCacheStartSample)
+        isLoopCacheValid = isCapturingLoopCache = false;
+
+    AudioSourceChannelInfo subInfo;
+    subInfo.buffer = info.buffer;
+    subInfo.startSample = info.startSample;
+
+    const int endSample = info.startSample + info.numSamples;
+
+    while (subInfo.startSample < endSample)
     {
-        if (isLoopingBetweenTimes)
+        subInfo.numSamples = endSample - subInfo.startSample;
+
+        if (isPlayingFromLoopCache)
         {
-            const ScopedLock sl (loopPosLock);
-
-            const int64 newStart = getNextReadPosition();
-            int64 newEnd = loopStartSample + ((newStart + info.numSamples) % loopEndSample);
-            
-            if (newStart > loopEndSample)
-                newEnd = newStart + info.numSamples;
-            
-            if (newEnd > newStart)
-            {
-                input->getNextAudioBlock (info);
-            }
-            else
-            {
-                const int64 numEndSamps = loopEndSample - newStart;
-                const int64 numStartSamps = newEnd - loopStartSample;
-                
-                tempInfo.startSample = 0;
-                tempInfo.numSamples = (int) numEndSamps;
-                input->getNextAudioBlock (tempInfo);
-                
-                tempInfo.startSample = (int) numEndSamps;
-                tempInfo.numSamples = (int) numStartSamps;
-                input->setNextReadPosition (loopStartSample);
-                input->getNextAudioBlock (tempInfo);
-
-                for (int i = 0; i < info.buffer->getNumChannels(); ++i)
-                    info.buffer->copyFrom (i, info.startSample, 
-                                           tempBuffer,
-                                           i, 0, info.numSamples);
-            }
+            subInfo.numSamples = jmin (subInfo.numSamples, loopCacheNumSamples - loopCacheReadPos);
+            readFromLoopCache (subInfo, loop);
         }
         else
         {
-            input->getNextAudioBlock (info);
+            const int64 position = input->getNextReadPosition();
+            bool reachesLoopEnd = false;
+
+            if (isLoopingBetweenTimes
+                && loop.endSample > loop.startSample
+                && position < loop.endSample)
+            {
+                const double numToLoopEnd = std::ceil ((loop.endSample - position) / playbackRatio);
+
+                if (numToLoopEnd <= subInfo.numSamples)
+                {
+                    subInfo.numSamples = jmax (1, (int) numToLoopEnd);
+                    reachesLoopEnd = true;
+                }
+            }
+
+            readFromInput (subInfo, loop, reachesLoopEnd);
         }
-    }    
+
+        subInfo.startSample += subInfo.numSamples;
+    }
 }
 
 //==============================================================================
 void LoopingAudioSource::setNextReadPosition (int64 newPosition)
 {
-    const ScopedLock sl (loopPosLock);
-    
-    if (isLoopingBetweenTimes 
-        && getNextReadPosition() > loopStartSample
-        && getNextReadPosition() < loopEndSample)
     {
-        const int64 numLoopSamples = loopEndSample - loopStartSample;
-        
-        if (newPosition > loopEndSample)
-            newPosition = loopStartSample + ((newPosition - loopEndSample) % numLoopSamples);
-        else if (newPosition < loopStartSample)
-            newPosition = loopEndSample - ((loopStartSample - newPosition) % numLoopSamples);
+        const ScopedLock sl (loopWriteLock);
+
+        const int64 currentPosition = getNextReadPosition();
+
+        if (isLoopingBetweenTimes
+            && currentPosition > loopRegion.startSample
+            && currentPosition < loopRegion.endSample)
+        {
+            const int64 numLoopSamples = loopRegion.endSample - loopRegion.startSample;
+
+            if (newPosition > loopRegion.endSample)
+                newPosition = loopRegion.startSample + ((newPosition - loopRegion.endSample) % numLoopSamples);
+            else if (newPosition < loopRegion.startSample)
+                newPosition = loopRegion.endSample - ((loopRegion.startSample - newPosition) % numLoopSamples);
+        }
     }
-    
-    input->setNextReadPosition (newPosition);
+
+    setNextReadPositionIgnoringLoop (newPosition);
 }
 
 void LoopingAudioSource::setNextReadPositionIgnoringLoop (int64 newPosition)
 {
-    input->setNextReadPosition (newPosition);
+    pendingReadPosition.set (jmax ((int64) 0, newPosition));
+
+    // if a block is being rendered the input may be being moved to wrap the loop
+    // so leave the new position for the start of the next block. Otherwise apply
+    // it now, as a stopped transport won't pull any blocks and the input needs
+    // to start buffering from the new position before playback starts.
+    const ScopedTryLock stl (callbackLock);
+
+    if (stl.isLocked())
+        applyPendingReadPosition();
 }
 
 int64 LoopingAudioSource::getNextReadPosition() const
 {
-    return input->getNextReadPosition();
+    const int64 pendingPosition = pendingReadPosition.get();
+
+    if (pendingPosition >= 0)
+        return pendingPosition;
+
+    const int64 cachePosition = loopCachePlayPosition.get();
+
+    return cachePosition >= 0 ? cachePosition
+                              : input->getNextReadPosition();
 }
 
 int64 LoopingAudioSource::getTotalLength() const
@@ -190,3 +293,213 @@ bool LoopingAudioSource::isLooping() const
     return input->isLooping();
 }
 
+//==============================================================================
+void LoopingAudioSource::publishLoopRegion()
+{
+    // Only called with the loopWriteLock held. The version is odd whilst the
+    // region is being changed so the audio thread can tell if it has read a
+    // partially updated region.
+    loopRegion.startSample = (int64) (loopStartTime * currentSampleRate);
+    loopRegion.endSample = (int64) (loopEndTime * currentSampleRate);
+
+    ++loopRegionVersion;
+
+    publishedLoopStart.set (loopRegion.startSample);
+    publishedLoopEnd.set (loopRegion.endSample);
+
+    ++loopRegionVersion;
+}
+
+LoopingAudioSource::LoopRegion LoopingAudioSource::getLoopRegion()
+{
+    const int version = loopRegionVersion.get();
+
+    if ((version & 1) == 0)
+    {
+        LoopRegion region;
+        region.startSample = publishedLoopStart.get();
+        region.endSample = publishedLoopEnd.get();
+
+        // if it changed part way through just use the last one until the next block
+        if (loopRegionVersion.get() == version)
+            audioThreadLoopRegion = region;
+    }
+
+    return audioThreadLoopRegion;
+}
+
+void LoopingAudioSource::applyPendingReadPosition()
+{
+    const int64 newPosition = pendingReadPosition.get();
+
+    if (newPosition < 0)
+        return;
+
+    input->setNextReadPosition (newPosition);
+
+    // the cache and any fade no longer follow on from the new position
+    isPlayingFromLoopCache = isCapturingLoopCache = false;
+    loopCachePlayPosition.set (-1);
+    fadePosition = fadeLength;
+
+    // if another position has been set in the meantime leave it for the next block
+    pendingReadPosition.compareAndSetBool (-1, newPosition);
+}
+
+void LoopingAudioSource::readFromLoopCache (const AudioSourceChannelInfo& info, const LoopRegion& loop)
+{
+    const int numChannels = jmin (info.buffer->getNumChannels(), loopCache.getNumChannels());
+
+    for (int i = 0; i < numChannels; ++i)
+        info.buffer->copyFrom (i, info.startSample,
+                               loopCache, i, loopCacheReadPos,
+                               info.numSamples);
+
+    for (int i = numChannels; i < info.buffer->getNumChannels(); ++i)
+        info.buffer->clear (i, info.startSample, info.numSamples);
+
+    applySeamCrossfade (*info.buffer, info.startSample, info.numSamples);
+    loopCacheReadPos += info.numSamples;
+
+    if (loopCacheReadPos < loopCacheNumSamples)
+    {
+        const double proportion = loopCacheReadPos / (double) loopCacheNumSamples;
+        loopCachePlayPosition.set (loopCacheStartSample
+                                   + (int64) (proportion * (loopCacheResumeSample - loopCacheStartSample)));
+    }
+    else
+    {
+        // the input was moved to the end of the cached section when this started
+        isPlayingFromLoopCache = false;
+        loopCachePlayPosition.set (-1);
+
+        if (isLoopingBetweenTimes && input->getNextReadPosition() >= loop.endSample)
+            wrapToLoopStart (loop);
+    }
+}
+
+void LoopingAudioSource::readFromInput (const AudioSourceChannelInfo& info, const LoopRegion& loop, bool reachesLoopEnd)
+{
+    const int64 startPosition = input->getNextReadPosition();
+    input->getNextAudioBlock (info);
+    const int64 endPosition = input->getNextReadPosition();
+
+    // the input may be changing the speed so keep track of how far each output sample moves it
+    if (info.numSamples >= 64 && endPosition > startPosition)
+        playbackRatio = (endPosition - startPosition) / (double) info.numSamples;
+
+    captureIntoLoopCache (*info.buffer, info.startSample, info.numSamples,
+                          startPosition, endPosition, loop);
+    applySeamCrossfade (*info.buffer, info.startSample, info.numSamples);
+
+    if (reachesLoopEnd)
+        wrapToLoopStart (loop);
+}
+
+void LoopingAudioSource::wrapToLoopStart (const LoopRegion& loop)
+{
+    if (isCapturingLoopCache)
+        finishCapturingLoopCache (input->getNextReadPosition());
+
+    // read on past the loop end so it can be faded out over the loop start
+    fadeLength = jmin ((int) crossfadeSamples, fadeBuffer.getNumSamples());
+    fadePosition = 0;
+
+    if (fadeLength > 0)
+    {
+        AudioSourceChannelInfo fadeInfo;
+        fadeInfo.buffer = &fadeBuffer;
+        fadeInfo.startSample = 0;
+        fadeInfo.numSamples = fadeLength;
+
+        input->getNextAudioBlock (fadeInfo);
+    }
+
+    if (isLoopCacheValid
+        && loopCacheStartSample == loop.startSample
+        && loopCacheResumeSample <= loop.endSample)
+    {
+        isPlayingFromLoopCache = true;
+        loopCacheReadPos = 0;
+        loopCachePlayPosition.set (loop.startSample);
+
+        input->setNextReadPosition (loopCacheResumeSample);
+    }
+    else
+    {
+        input->setNextReadPosition (loop.startSample);
+        startCapturingLoopCache (loop);
+    }
+}
+
+void LoopingAudioSource::startCapturingLoopCache (const LoopRegion& loop)
+{
+    isLoopCacheValid = false;
+    isCapturingLoopCache = loopCache.getNumSamples() > 0;
+    loopCacheStartSample = loop.startSample;
+    loopCacheWritePos = 0;
+}
+
+void LoopingAudioSource::captureIntoLoopCache (const AudioSampleBuffer& source, int startSample, int numSamples,
+                                               int64 startPosition, int64 endPosition, const LoopRegion& loop)
+{
+    if (! isCapturingLoopCache)
+    {
+        // also start capturing if playback runs into the loop start
+        if (isLoopCacheValid || ! isLoopingBetweenTimes
+            || loop.startSample < startPosition || loop.startSample >= endPosition)
+            return;
+
+        const int offset = jlimit (0, numSamples - 1, roundToInt ((loop.startSample - startPosition) / playbackRatio));
+        startSample += offset;
+        numSamples -= offset;
+
+        startCapturingLoopCache (loop);
+
+        if (! isCapturingLoopCache)
+            return;
+    }
+
+    const int numToCopy = jmin (numSamples, loopCache.getNumSamples() - loopCacheWritePos);
+    const int numChannels = jmin (source.getNumChannels(), loopCache.getNumChannels());
+
+    for (int i = 0; i < numChannels; ++i)
+        loopCache.copyFrom (i, loopCacheWritePos, source, i, startSample, numToCopy);
+
+    loopCacheWritePos += numToCopy;
+
+    if (loopCacheWritePos >= loopCache.getNumSamples())
+        finishCapturingLoopCache (endPosition - (int64) ((numSamples - numToCopy) * playbackRatio));
+}
+
+void LoopingAudioSource::finishCapturingLoopCache (int64 resumePosition)
+{
+    isCapturingLoopCache = false;
+    isLoopCacheValid = loopCacheWritePos > 0;
+    loopCacheNumSamples = loopCacheWritePos;
+    loopCacheResumeSample = resumePosition;
+}
+
+void LoopingAudioSource::applySeamCrossfade (AudioSampleBuffer& buffer, int startSample, int numSamples)
+{
+    if (fadePosition >= fadeLength)
+        return;
+
+    const int numToFade = jmin (numSamples, fadeLength - fadePosition);
+    const int numChannels = jmin (buffer.getNumChannels(), fadeBuffer.getNumChannels());
+    const float angleDelta = float_Pi * 0.5f / fadeLength;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        float* dest = buffer.getWritePointer (i, startSample);
+        const float* tail = fadeBuffer.getReadPointer (i, fadePosition);
+
+        for (int s = 0; s < numToFade; ++s)
+        {
+            const float angle = (fadePosition + s + 0.5f) * angleDelta;
+            dest[s] = dest[s] * std::sin (angle) + tail[s] * std::cos (angle);
+        }
+    }
+
+    fadePosition += numToFade;
+}
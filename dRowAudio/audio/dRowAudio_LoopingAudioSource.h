@@ -33,14 +33,28 @@
 #define __DROWAUDIO_LOOPINGAUDIOSOURCE_H__
 
 #include "../utility/dRowAudio_Utility.h"
+#include "dRowAudio_AudioSourceWithLatency.h"
 
 //==============================================================================
 /** A type of PositionalAudioSource that will read from a PositionableAudioSource
     and can loop between to set times.
 
+    The loop bounds are published to the audio thread without locking so they
+    can be changed freely whilst playing. A new read position is passed on to
+    the input straight away unless a block is being rendered, in which case it
+    is applied at the start of the next block so it can't be overwritten by a
+    loop wrap that is happening at the same time. To avoid waiting on the input when
+    the loop wraps, the first part of the loop region is kept in a RAM cache.
+    This is filled the first time the loop start is played through and from
+    then on is played back whilst the input is moved to the end of the cached
+    section, giving any upstream buffering time to catch up. An optional short
+    crossfade can also be applied at the loop seam to smooth over any
+    discontinuity.
+
     @see PositionableAudioSource, AudioTransportSource, BufferingAudioSource
 */
-class LoopingAudioSource  : public PositionableAudioSource
+class LoopingAudioSource  : public PositionableAudioSource,
+                            public AudioSourceWithLatency
 {
 public:
     //==============================================================================
@@ -50,9 +64,12 @@ public:
         @param deleteReaderWhenThisIsDeleted    if true, the reader passed-in will be deleted
                                                 when this object is deleted; if false it will be
                                                 left up to the caller to manage its lifetime
+        @param numberOfChannels                 the number of channels to keep in the loop
+                                                cache and seam crossfade
     */
     LoopingAudioSource (PositionableAudioSource* const inputSource,
-                        const bool deleteInputWhenDeleted);
+                        const bool deleteInputWhenDeleted,
+                        int numberOfChannels = 2);
 
     /** Destructor. */
     ~LoopingAudioSource();
@@ -75,6 +92,34 @@ public:
      */
     bool getLoopBetweenTimes();
     
+    //==============================================================================
+    /** Sets the length of the start of the loop region to keep in memory.
+        Whilst this section is played back from the cache the input is given time
+        to re-buffer from the end of it. Set this to 0 to disable the cache.
+        This will take effect the next time prepareToPlay() is called.
+     */
+    void setLoopCacheLength (double seconds);
+
+    /** Returns the length of the loop cache in seconds.
+     */
+    double getLoopCacheLength() const           { return loopCacheLength;  }
+
+    /** Discards the cached loop start so that it is captured again.
+        Call this if the input's output changes for the same positions, for
+        example when its tempo is changed.
+     */
+    void invalidateLoopCache();
+
+    /** Sets the length of an equal-power crossfade to apply at the loop seam.
+        The audio following the loop end is faded out whilst the loop start is
+        faded in. This is limited to 100ms, set it to 0 to disable the crossfade.
+     */
+    void setLoopCrossfadeLength (double seconds);
+
+    /** Returns the length of the loop seam crossfade in seconds.
+     */
+    double getLoopCrossfadeLength() const       { return crossfadeLength;  }
+
     //==============================================================================
     /** Implementation of the AudioSource method. */
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
@@ -89,7 +134,10 @@ public:
     /** Implements the PositionableAudioSource method. */
     void setNextReadPosition (int64 newPosition);
 
-    /** Sets the next read position ignoring the loop bounds. */
+    /** Sets the next read position ignoring the loop bounds.
+        If a block is being rendered when this is called the new position is
+        applied at the start of the next one.
+     */
     void setNextReadPositionIgnoringLoop (int64 newPosition);
 
     /** Implements the PositionableAudioSource method. */
@@ -101,21 +149,59 @@ public:
     /** Implements the PositionableAudioSource method. */
     bool isLooping() const;
     
+    //==============================================================================
+    /** Implements the AudioSourceWithLatency method.
+        Looping doesn't delay the audio so this is the latency of the input.
+     */
+    int getLatencySamples() const               { return getLatencySamplesOf (input);    }
+
 private:
     //==============================================================================
+    struct LoopRegion
+    {
+        int64 startSample, endSample;
+    };
+
     OptionalScopedPointer<PositionableAudioSource> input;
-    CriticalSection loopPosLock;
+    CriticalSection loopWriteLock, callbackLock;
+    int numberOfChannels;
 
     bool volatile isLoopingBetweenTimes;
     double loopStartTime, loopEndTime;
-    int64 loopStartSample, loopEndSample;
     double currentSampleRate;
 
-    AudioSourceChannelInfo tempInfo;
-    AudioSampleBuffer tempBuffer;
-        
+    LoopRegion loopRegion, audioThreadLoopRegion;
+    Atomic<int64> publishedLoopStart, publishedLoopEnd;
+    Atomic<int> loopRegionVersion;
+    Atomic<int64> pendingReadPosition;
+
+    double loopCacheLength, crossfadeLength;
+    AudioSampleBuffer loopCache, fadeBuffer;
+    int64 loopCacheStartSample, loopCacheResumeSample;
+    int loopCacheNumSamples, loopCacheReadPos, loopCacheWritePos;
+    bool isLoopCacheValid, isCapturingLoopCache, isPlayingFromLoopCache;
+    Atomic<int> loopCacheInvalidated;
+    Atomic<int64> loopCachePlayPosition;
+
+    int volatile crossfadeSamples;
+    int fadeLength, fadePosition;
+    double playbackRatio;
+
+    //==============================================================================
+    void publishLoopRegion();
+    LoopRegion getLoopRegion();
+    void applyPendingReadPosition();
+    void readFromLoopCache (const AudioSourceChannelInfo& info, const LoopRegion& loop);
+    void readFromInput (const AudioSourceChannelInfo& info, const LoopRegion& loop, bool reachesLoopEnd);
+    void wrapToLoopStart (const LoopRegion& loop);
+    void startCapturingLoopCache (const LoopRegion& loop);
+    void captureIntoLoopCache (const AudioSampleBuffer& source, int startSample, int numSamples,
+                               int64 startPosition, int64 endPosition, const LoopRegion& loop);
+    void finishCapturingLoopCache (int64 resumePosition);
+    void applySeamCrossfade (AudioSampleBuffer& buffer, int startSample, int numSamples);
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoopingAudioSource);
 };
 
-#endif   // __DROWAUDIO_LOOPINGAUDIOSOURCE_H__
\ No newline at end of file
+#endif   // __DROWAUDIO_LOOPINGAUDIOSOURCE_H__
\ No newline at end of file
@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    // the number of interpolated samples between each input sample when looking for true peaks
+    const int truePeakNumPhases = 4;
+
+    // Blackman window, x is in the range -1 to 1
+    double truePeakWindow (double x) noexcept
+    {
+        return 0.42 + 0.5 * cos (double_Pi * x) + 0.08 * cos (2.0 * double_Pi * x);
+    }
+
+    /*  The functions below work on blocks of frames of four interleaved channels,
+        one for each SIMD lane. numValues is the number of frames * 4.
+     */
+    void rectifyEnvelopeInput (float* data, int numValues) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int i = 0; i < numValues; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps (data + i);
+            _mm_storeu_ps (data + i, _mm_max_ps (x, _mm_sub_ps (zero, x)));
+        }
+       #else
+        for (int i = 0; i < numValues; ++i)
+            data[i] = fabsf (data[i]);
+       #endif
+    }
+
+    void squareEnvelopeInput (float* data, int numValues) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        for (int i = 0; i < numValues; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps (data + i);
+            _mm_storeu_ps (data + i, _mm_mul_ps (x, x));
+        }
+       #else
+        for (int i = 0; i < numValues; ++i)
+            data[i] *= data[i];
+       #endif
+    }
+
+    void squareRootEnvelopes (float* data, int numValues) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        for (int i = 0; i < numValues; i += 4)
+            _mm_storeu_ps (data + i, _mm_sqrt_ps (_mm_loadu_ps (data + i)));
+       #else
+        for (int i = 0; i < numValues; ++i)
+            data[i] = sqrtf (data[i]);
+       #endif
+    }
+
+    /*  Replaces each frame with the largest absolute value of the signal at the
+        frame and the three points interpolated after it. The frames are delayed
+        by half the kernel length so history holds two copies of the last
+        numTaps frames, one after the other, so the kernel can always be run over
+        a contiguous section of it.
+     */
+    void detectTruePeaks (float* data, int numFrames, float* history, int& position,
+                          const float* kernels, int numTaps) noexcept
+    {
+        const int delay = numTaps / 2 - 1;
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float* const frame = data + 4 * i;
+
+           #if DROWAUDIO_USE_SSE
+            const __m128 x = _mm_loadu_ps (frame);
+            _mm_storeu_ps (history + 4 * position, x);
+            _mm_storeu_ps (history + 4 * (position + numTaps), x);
+           #else
+            for (int lane = 0; lane < 4; ++lane)
+                history[4 * position + lane] = history[4 * (position + numTaps) + lane] = frame[lane];
+           #endif
+
+            if (++position >= numTaps)
+                position = 0;
+
+            // oldest frame first
+            const float* const window = history + 4 * position;
+
+           #if DROWAUDIO_USE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 delayed = _mm_loadu_ps (window + 4 * delay);
+            __m128 peak = _mm_max_ps (delayed, _mm_sub_ps (zero, delayed));
+
+            for (int phase = 0; phase < truePeakNumPhases - 1; ++phase)
+            {
+                const float* const kernel = kernels + phase * numTaps;
+                __m128 sum = zero;
+
+                for (int k = 0; k < numTaps; ++k)
+                    sum = _mm_add_ps (sum, _mm_mul_ps (_mm_set1_ps (kernel[k]), _mm_loadu_ps (window + 4 * k)));
+
+                peak = _mm_max_ps (peak, _mm_max_ps (sum, _mm_sub_ps (zero, sum)));
+            }
+
+            _mm_storeu_ps (frame, peak);
+           #else
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                float peak = fabsf (window[4 * delay + lane]);
+
+                for (int phase = 0; phase < truePeakNumPhases - 1; ++phase)
+                {
+                    const float* const kernel = kernels + phase * numTaps;
+                    float sum = 0.0f;
+
+                    for (int k = 0; k < numTaps; ++k)
+                        sum += kernel[k] * window[4 * k + lane];
+
+                    peak = jmax (peak, fabsf (sum));
+                }
+
+                frame[lane] = peak;
+            }
+           #endif
+        }
+    }
+
+    /*  Moves each envelope towards the level in each frame using the attack
+        coefficient when the level is above the envelope and the release one
+        when it's below, then replaces the frame with the new envelope.
+     */
+    void followEnvelopes (float* data, int numFrames, float* envelopes, float attack, float release) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        const __m128 a = _mm_set1_ps (attack);
+        const __m128 r = _mm_set1_ps (release);
+        __m128 envelope = _mm_loadu_ps (envelopes);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const __m128 level = _mm_loadu_ps (data + 4 * i);
+            const __m128 isRising = _mm_cmpgt_ps (level, envelope);
+            const __m128 coefficient = _mm_or_ps (_mm_and_ps (isRising, a), _mm_andnot_ps (isRising, r));
+
+            envelope = _mm_add_ps (envelope, _mm_mul_ps (coefficient, _mm_sub_ps (level, envelope)));
+            _mm_storeu_ps (data + 4 * i, envelope);
+        }
+
+        _mm_storeu_ps (envelopes, envelope);
+       #else
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            float envelope = envelopes[lane];
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                float& value = data[4 * i + lane];
+                envelope += (value > envelope ? attack : release) * (value - envelope);
+                value = envelope;
+            }
+
+            envelopes[lane] = envelope;
+        }
+       #endif
+
+        // stop the envelopes decaying into denormals
+        for (int lane = 0; lane < 4; ++lane)
+            if (envelopes[lane] < 1.0e-15f)
+                envelopes[lane] = 0.0f;
+    }
+}
+
+//==============================================================================
+MultichannelEnvelopeFollower::MultichannelEnvelopeFollower (int numChannels_)
+    : numChannels (0), numGroups (0),
+      sampleRate (44100.0), attackTime (0.0), releaseTime (0.0),
+      attack (1.0f), release (1.0f),
+      mode (peakDetection)
+{
+    // Windowed sinc kernels for the fractional positions 1/4, 2/4 and 3/4 of the
+    // way between the frame half the kernel length ago and the one after it
+    const int delay = truePeakTaps / 2 - 1;
+
+    for (int phase = 1; phase < truePeakNumPhases; ++phase)
+    {
+        float* const kernel = truePeakKernels[phase - 1];
+        const double fraction = phase / (double) truePeakNumPhases;
+        double sum = 0.0;
+
+        for (int k = 0; k < truePeakTaps; ++k)
+        {
+            const double x = k - delay - fraction;
+            const double sinc = sin (double_Pi * x) / (double_Pi * x);
+            const double value = sinc * truePeakWindow (x / (0.5 * truePeakTaps));
+
+            kernel[k] = (float) value;
+            sum += value;
+        }
+
+        // unity gain at DC
+        for (int k = 0; k < truePeakTaps; ++k)
+            kernel[k] = (float) (kernel[k] / sum);
+    }
+
+    zeromem (block, sizeof (block));
+    setNumChannels (numChannels_);
+}
+
+MultichannelEnvelopeFollower::~MultichannelEnvelopeFollower()
+{
+}
+
+//==============================================================================
+void MultichannelEnvelopeFollower::setNumChannels (int newNumChannels)
+{
+    numChannels = jmax (1, newNumChannels);
+    numGroups = (numChannels + 3) / 4;
+
+    envelopes.allocate ((size_t) numGroups * 4, true);
+    history.allocate ((size_t) numGroups * 4 * 2 * truePeakTaps, true);
+    historyPositions.allocate ((size_t) numGroups, true);
+}
+
+void MultichannelEnvelopeFollower::setSampleRate (double newSampleRate) noexcept
+{
+    jassert (newSampleRate > 0.0);
+
+    sampleRate = newSampleRate;
+    updateCoefficients();
+}
+
+void MultichannelEnvelopeFollower::setTimes (double attackSeconds, double releaseSeconds) noexcept
+{
+    attackTime = attackSeconds;
+    releaseTime = releaseSeconds;
+    updateCoefficients();
+}
+
+void MultichannelEnvelopeFollower::setDetectionMode (DetectionMode newMode) noexcept
+{
+    if (newMode != mode)
+    {
+        mode = newMode;
+        reset();
+    }
+}
+
+int MultichannelEnvelopeFollower::getLatencySamples() const noexcept
+{
+    // the newest frame is at the end of the window, so the one detectTruePeaks()
+    // centres the kernels on, at index truePeakTaps / 2 - 1, is half the kernel
+    // length old
+    return mode == truePeakDetection ? truePeakTaps / 2 : 0;
+}
+
+void MultichannelEnvelopeFollower::reset() noexcept
+{
+    zeromem (envelopes, sizeof (float) * (size_t) numGroups * 4);
+    zeromem (history, sizeof (float) * (size_t) numGroups * 4 * 2 * truePeakTaps);
+    zeromem (historyPositions, sizeof (int) * (size_t) numGroups);
+}
+
+//==============================================================================
+void MultichannelEnvelopeFollower::processEnvelopes (const float* const* inputs, float* const* outputs,
+                                                     int numChannelsToProcess, int numSamples) noexcept
+{
+    jassert (numChannelsToProcess <= numChannels);
+    numChannelsToProcess = jmin (numChannelsToProcess, numChannels);
+
+    for (int group = 0; group * 4 < numChannelsToProcess; ++group)
+    {
+        const int firstChannel = group * 4;
+        const int numLanes = jmin (4, numChannelsToProcess - firstChannel);
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            const int numFrames = jmin ((int) blockSize, numSamples - start);
+
+            // unused lanes are fed silence
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (lane < numLanes)
+                {
+                    const float* const input = inputs[firstChannel + lane] + start;
+
+                    for (int i = 0; i < numFrames; ++i)
+                        block[4 * i + lane] = input[i];
+                }
+                else
+                {
+                    for (int i = 0; i < numFrames; ++i)
+                        block[4 * i + lane] = 0.0f;
+                }
+            }
+
+            processGroup (group, numFrames);
+
+            if (outputs != nullptr)
+            {
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    float* const output = outputs[firstChannel + lane] + start;
+
+                    for (int i = 0; i < numFrames; ++i)
+                        output[i] = block[4 * i + lane];
+                }
+            }
+        }
+    }
+}
+
+float MultichannelEnvelopeFollower::getEnvelope (int channel) const noexcept
+{
+    if (! isPositiveAndBelow (channel, numChannels))
+        return 0.0f;
+
+    return mode == rmsDetection ? sqrtf (envelopes[channel]) : envelopes[channel];
+}
+
+//==============================================================================
+void MultichannelEnvelopeFollower::updateCoefficients() noexcept
+{
+    attack = EnvelopeFollower::timeToCoefficient (attackTime, sampleRate);
+    release = EnvelopeFollower::timeToCoefficient (releaseTime, sampleRate);
+}
+
+void MultichannelEnvelopeFollower::processGroup (int group, int numFrames) noexcept
+{
+    const int numValues = numFrames * 4;
+
+    switch (mode)
+    {
+        case rmsDetection:
+            squareEnvelopeInput (block, numValues);
+            break;
+
+        case truePeakDetection:
+            detectTruePeaks (block, numFrames, history + group * 4 * 2 * truePeakTaps, historyPositions[group],
+                             truePeakKernels[0], truePeakTaps);
+            break;
+
+        default:
+            rectifyEnvelopeInput (block, numValues);
+            break;
+    }
+
+    followEnvelopes (block, numFrames, envelopes + group * 4, attack, release);
+
+    if (mode == rmsDetection)
+        squareRootEnvelopes (block, numValues);
+}
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_MULTICHANNELENVELOPEFOLLOWER_H__
+#define __DROWAUDIO_MULTICHANNELENVELOPEFOLLOWER_H__
+
+#include "dRowAudio_EnvelopeFollower.h"
+
+//==============================================================================
+/**
+    An envelope follower for lots of channels at once.
+
+    Channels are processed in groups of four, one per SIMD lane where the
+    platform has them, and the choice between the attack and release
+    coefficients is made without branching. This makes it suitable for metering
+    and side-chaining large numbers of channels.
+
+    As well as following the peak level the envelope can follow the RMS level
+    or the true-peak level, which is the peak of the signal oversampled by 4 as
+    described in ITU-R BS.1770. The true-peak detector has a few samples of
+    latency, see getLatencySamples().
+
+    All the memory is allocated by setNumChannels() so processing doesn't
+    allocate. This isn't thread safe so change the settings from the same
+    thread that processes the samples.
+
+    @see EnvelopeFollower
+ */
+class MultichannelEnvelopeFollower
+{
+public:
+    //==============================================================================
+    /** The detectors that can be used. */
+    enum DetectionMode
+    {
+        peakDetection,      /**< Follows the absolute sample values. */
+        rmsDetection,       /**< Follows the mean of the squared sample values and returns the root. */
+        truePeakDetection   /**< Follows the absolute value of the signal oversampled by 4. */
+    };
+
+    //==============================================================================
+	/** Creates a follower for a number of channels. */
+	explicit MultichannelEnvelopeFollower (int numChannels = 2);
+
+	/** Destructor. */
+	~MultichannelEnvelopeFollower();
+
+    //==============================================================================
+    /** Sets the number of channels to follow.
+        This allocates memory and resets the envelopes so shouldn't be called
+        whilst processing.
+     */
+    void setNumChannels (int newNumChannels);
+
+    /** Returns the number of channels being followed. */
+    int getNumChannels() const noexcept                 {   return numChannels;     }
+
+    /** Sets the sample rate the attack and release times are relative to. */
+    void setSampleRate (double newSampleRate) noexcept;
+
+    /** Sets the attack and release times in seconds.
+        These are the times taken to move 63% of the way to a new level.
+     */
+    void setTimes (double attackSeconds, double releaseSeconds) noexcept;
+
+    /** Sets the detector to use.
+        Changing this resets the envelopes.
+     */
+    void setDetectionMode (DetectionMode newMode) noexcept;
+
+    /** Returns the detector being used. */
+    DetectionMode getDetectionMode() const noexcept     {   return mode;            }
+
+    /** Returns the number of samples the envelope lags the input by.
+        This is only non-zero for true-peak detection.
+     */
+    int getLatencySamples() const noexcept;
+
+    /** Clears the envelopes of all of the channels. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Follows the envelopes of a number of channels.
+
+        The number of channels must not be more than getNumChannels(). If outputs
+        is not nullptr the envelope of each channel is written to the corresponding
+        output, which can be the same as the input. Otherwise just the final
+        levels are updated, use getEnvelope() to find these out.
+     */
+    void processEnvelopes (const float* const* inputs, float* const* outputs,
+                           int numChannelsToProcess, int numSamples) noexcept;
+
+    /** Returns the current level of a channel's envelope. */
+    float getEnvelope (int channel) const noexcept;
+
+private:
+    //==============================================================================
+    enum
+    {
+        blockSize = 64,
+        truePeakTaps = 12
+    };
+
+    int numChannels, numGroups;
+    double sampleRate, attackTime, releaseTime;
+    float attack, release;
+    DetectionMode mode;
+
+    HeapBlock<float> envelopes, history;
+    HeapBlock<int> historyPositions;
+    float truePeakKernels[3][truePeakTaps];
+    float block[blockSize * 4];
+
+    //==============================================================================
+    void updateCoefficients() noexcept;
+    void processGroup (int group, int numFrames) noexcept;
+
+    //==============================================================================
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultichannelEnvelopeFollower);
+};
+
+#endif // __DROWAUDIO_MULTICHANNELENVELOPEFOLLOWER_H__
@@ -0,0 +1,271 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_USE_SOUNDTOUCH
+
+//==============================================================================
+/** Plays a section of a reader forwards or backwards, starting at position 0.
+    Reading past the end of the section returns silence.
+ */
+class OfflinePlayerRenderer::RegionSource  : public PositionableAudioSource
+{
+public:
+    RegionSource (AudioFormatReader& reader_, int64 startSample_, int64 endSample_, bool isForwards_)
+        : reader (reader_),
+          startSample (startSample_),
+          endSample (endSample_),
+          isForwards (isForwards_),
+          nextReadPosition (0)
+    {
+    }
+
+    void prepareToPlay (int /*samplesPerBlockExpected*/, double /*sampleRate*/) {}
+    void releaseResources() {}
+
+    void getNextAudioBlock (const AudioSourceChannelInfo& info)
+    {
+        const int64 numLeft = jmax ((int64) 0, getTotalLength() - nextReadPosition);
+        const int numToRead = (int) jmin ((int64) info.numSamples, numLeft);
+
+        if (numToRead > 0)
+        {
+            const int64 readerStart = isForwards ? startSample + nextReadPosition
+                                                 : endSample - nextReadPosition - numToRead;
+
+            reader.read (info.buffer, info.startSample, numToRead, readerStart, true, true);
+
+            if (! isForwards)
+                for (int c = 0; c < info.buffer->getNumChannels(); ++c)
+                    reverseArray (info.buffer->getWritePointer (c) + info.startSample, numToRead);
+        }
+
+        if (numToRead < info.numSamples)
+            info.buffer->clear (info.startSample + numToRead, info.numSamples - numToRead);
+
+        nextReadPosition += info.numSamples;
+    }
+
+    void setNextReadPosition (int64 newPosition)    { nextReadPosition = newPosition;    }
+    int64 getNextReadPosition() const               { return nextReadPosition;           }
+    int64 getTotalLength() const                    { return endSample - startSample;    }
+    bool isLooping() const                          { return false;                      }
+
+private:
+    AudioFormatReader& reader;
+    const int64 startSample, endSample;
+    const bool isForwards;
+    int64 nextReadPosition;
+
+    JUCE_DECLARE_NON_COPYABLE (RegionSource);
+};
+
+//==============================================================================
+OfflinePlayerRenderer::OfflinePlayerRenderer (AudioFilePlayerExt& player,
+                                              AudioFormatWriter* writerToUse,
+                                              int samplesPerBlock_)
+    : Thread ("OfflinePlayerRenderer"),
+      formatManager (*player.getAudioFormatManager()),
+      writer (writerToUse),
+      samplesPerBlock (jmax (1024, samplesPerBlock_)),
+      file (player.getFile()),
+      playbackSettings (player.getPlaybackSettings()),
+      playForwards (player.getPlayDirection()),
+      shouldFilter (player.getFilteringAudioSource()->getFilterSource()),
+      filterMode (player.getFilteringAudioSource()->getMode()),
+      startTime (0.0),
+      endTime (player.getLengthInSeconds()),
+      progress (0.0),
+      finished (false),
+      cancelled (false),
+      completedOk (false)
+{
+    jassert (writerToUse != nullptr);
+
+    for (int i = 0; i < FilteringAudioSource::numFilters; ++i)
+        filterGains[i] = player.getFilteringAudioSource()->getGain ((FilteringAudioSource::FilterType) i);
+
+    if (player.getLoopBetweenTimes())
+        player.getLoopTimes (startTime, endTime);
+}
+
+OfflinePlayerRenderer::~OfflinePlayerRenderer()
+{
+    cancel();
+    stopThread (10000);
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void OfflinePlayerRenderer::setSourceRange (double newStartTime, double newEndTime)
+{
+    jassert (! isThreadRunning());
+    jassert (newStartTime <= newEndTime);
+
+    startTime = newStartTime;
+    endTime = newEndTime;
+}
+
+bool OfflinePlayerRenderer::render()
+{
+    bool ok = false;
+
+    if (writer != nullptr)
+    {
+        ScopedPointer<AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader != nullptr)
+            ok = renderChain (*reader);
+
+        // deleting the writer finishes off the file
+        writer = nullptr;
+    }
+
+    completedOk = ok;
+    finished = true;
+    triggerAsyncUpdate();
+
+    return ok;
+}
+
+void OfflinePlayerRenderer::cancel()
+{
+    cancelled = ! finished;
+    signalThreadShouldExit();
+}
+
+//==============================================================================
+void OfflinePlayerRenderer::addListener (Listener* const listener)
+{
+    listeners.add (listener);
+}
+
+void OfflinePlayerRenderer::removeListener (Listener* const listener)
+{
+    listeners.remove (listener);
+}
+
+//==============================================================================
+void OfflinePlayerRenderer::run()
+{
+    render();
+}
+
+//==============================================================================
+bool OfflinePlayerRenderer::renderChain (AudioFormatReader& reader)
+{
+    const double sampleRate = writer->getSampleRate();
+
+    if (sampleRate <= 0.0 || reader.sampleRate <= 0.0)
+        return false;
+
+    const int numChannels = jlimit (1, 2, (int) writer->getNumChannels());
+    const int64 startSample = jlimit ((int64) 0, reader.lengthInSamples, secondsToSamples (startTime, reader.sampleRate));
+    const int64 endSample = jlimit (startSample, reader.lengthInSamples, secondsToSamples (endTime, reader.sampleRate));
+
+    // SoundTouch's rate resamples, so scaling it converts the file to the writer's sample rate
+    SoundTouchProcessor::PlaybackSettings settings (playbackSettings);
+    settings.rate = (float) (settings.rate * reader.sampleRate / sampleRate);
+
+    // the same order as the player's chain but with the file being read directly
+    // and reversed before the time stretching so SoundTouch sees a continuous signal
+    RegionSource regionSource (reader, startSample, endSample, playForwards);
+
+    SoundTouchAudioSource soundTouchAudioSource (&regionSource, false, samplesPerBlock, numChannels);
+    soundTouchAudioSource.setPlaybackSettings (settings);
+
+    FilteringAudioSource filteringAudioSource (&soundTouchAudioSource, false);
+    filteringAudioSource.setFilterSource (shouldFilter);
+    filteringAudioSource.setMode (filterMode);
+
+    for (int i = 0; i < FilteringAudioSource::numFilters; ++i)
+        filteringAudioSource.setGain ((FilteringAudioSource::FilterType) i, filterGains[i]);
+
+    filteringAudioSource.prepareToPlay (samplesPerBlock, sampleRate);
+
+    const double playbackRatio = soundTouchAudioSource.getSoundTouchProcessor().getEffectivePlaybackRatio();
+    const int64 numSamplesToRender = (int64) ((endSample - startSample) / playbackRatio);
+
+    AudioSampleBuffer buffer (numChannels, samplesPerBlock);
+    int64 numSamplesRendered = 0;
+    bool ok = true;
+
+    while (numSamplesRendered < numSamplesToRender)
+    {
+        if (threadShouldExit())
+        {
+            ok = false;
+            break;
+        }
+
+        const int numThisTime = (int) jmin ((int64) samplesPerBlock, numSamplesToRender - numSamplesRendered);
+        AudioSourceChannelInfo info (&buffer, 0, numThisTime);
+        filteringAudioSource.getNextAudioBlock (info);
+
+        if (! writer->writeFromAudioSampleBuffer (buffer, 0, numThisTime))
+        {
+            ok = false;
+            break;
+        }
+
+        numSamplesRendered += numThisTime;
+        progress = numSamplesRendered / (double) numSamplesToRender;
+    }
+
+    // SoundTouch holds back up to around 100ms so carry on until the silence read
+    // after the end of the region has pushed the rest of it out
+    const int tailBlockSize = 1024;
+    const int maxNumTailBlocks = (int) (sampleRate * 0.2) / tailBlockSize + 1;
+
+    for (int i = 0; ok && i < maxNumTailBlocks && ! threadShouldExit(); ++i)
+    {
+        AudioSourceChannelInfo info (&buffer, 0, tailBlockSize);
+        filteringAudioSource.getNextAudioBlock (info);
+
+        if (buffer.getMagnitude (0, tailBlockSize) < 1.0e-5f)
+            break;
+
+        ok = writer->writeFromAudioSampleBuffer (buffer, 0, tailBlockSize);
+    }
+
+    if (threadShouldExit())
+        ok = false;
+
+    filteringAudioSource.releaseResources();
+
+    return ok;
+}
+
+void OfflinePlayerRenderer::handleAsyncUpdate()
+{
+    listeners.call (&Listener::offlineRenderFinished, this, completedOk);
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_OFFLINEPLAYERRENDERER_H__
+#define __DROWAUDIO_OFFLINEPLAYERRENDERER_H__
+
+#if DROWAUDIO_USE_SOUNDTOUCH
+
+#include "dRowAudio_AudioFilePlayerExt.h"
+
+//==============================================================================
+/**
+    Renders the output of an AudioFilePlayerExt to an AudioFormatWriter faster
+    than real-time.
+
+    When created this takes a snapshot of the player's file, playback settings,
+    play direction, loop and filter mode and gains. Rendering then builds its
+    own copy of the processing chain on a new reader of the file so the player
+    can carry on being used whilst the bounce happens. The file is read directly without any
+    buffering and processed in large blocks so the render runs as fast as the
+    disk and CPU allow.
+
+    If the player is looping the loop region is rendered, otherwise the whole file
+    is. Use setSourceRange() to render a different section.
+
+    Call startThread() to render in the background or render() to do it on the
+    calling thread. Either can be stopped with cancel().
+
+    @see AudioFilePlayerExt
+ */
+class OfflinePlayerRenderer :   public Thread,
+                                private AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Creates a renderer for the current settings of a player.
+
+        The writer will be deleted once rendering has finished, which completes the
+        file it is writing to. If its sample rate is different to the player's file
+        the audio is resampled to match. The player's AudioFormatManager must stay
+        valid whilst this exists.
+     */
+    OfflinePlayerRenderer (AudioFilePlayerExt& playerToRender,
+                           AudioFormatWriter* writerToUse,
+                           int samplesPerBlock = 32768);
+
+    /** Destructor.
+        If the render thread is running this will cancel it and wait for it to stop.
+     */
+    ~OfflinePlayerRenderer();
+
+    //==============================================================================
+    /** Sets the section of the file to render in seconds.
+        This must be called before rendering starts.
+     */
+    void setSourceRange (double startTime, double endTime);
+
+    /** Renders the whole source range on the calling thread.
+        @returns true if the render completed, false if it failed or was cancelled
+     */
+    bool render();
+
+    /** Stops a render that is in progress.
+        The output will contain everything rendered up to that point.
+     */
+    void cancel();
+
+    /** Returns the proportion of the render that has been completed, from 0 to 1. */
+    double getProgress() const noexcept         {   return progress;        }
+
+    /** Returns true once the render has finished, for whatever reason. */
+    bool hasFinished() const noexcept           {   return finished;        }
+
+    /** Returns true if the render was cancelled before it could finish. */
+    bool wasCancelled() const noexcept          {   return cancelled;       }
+
+    //==============================================================================
+    /** A class for receiving callbacks from an OfflinePlayerRenderer.
+     */
+    class Listener
+    {
+    public:
+        //==============================================================================
+        /** Destructor. */
+        virtual ~Listener() {}
+
+        /** Called on the message thread when a render has finished.
+            completedOk will be false if the render failed or was cancelled.
+         */
+        virtual void offlineRenderFinished (OfflinePlayerRenderer* renderer, bool completedOk) = 0;
+    };
+
+    /** Adds a listener to be told when rendering has finished. */
+    void addListener (Listener* listener);
+
+    /** Removes a previously-registered listener. */
+    void removeListener (Listener* listener);
+
+    //==============================================================================
+    /** @internal */
+    void run();
+
+private:
+    //==============================================================================
+    class RegionSource;
+
+    AudioFormatManager& formatManager;
+    ScopedPointer<AudioFormatWriter> writer;
+    const int samplesPerBlock;
+
+    File file;
+    SoundTouchProcessor::PlaybackSettings playbackSettings;
+    bool playForwards, shouldFilter;
+    FilteringAudioSource::Mode filterMode;
+    float filterGains[FilteringAudioSource::numFilters];
+    double startTime, endTime;
+
+    double volatile progress;
+    bool volatile finished, cancelled;
+    bool completedOk;
+
+    ListenerList<Listener> listeners;
+
+    //==============================================================================
+    bool renderChain (AudioFormatReader& reader);
+    void handleAsyncUpdate();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflinePlayerRenderer);
+};
+
+#endif
+#endif // __DROWAUDIO_OFFLINEPLAYERRENDERER_H__
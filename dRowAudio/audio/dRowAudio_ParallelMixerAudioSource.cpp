@@ -0,0 +1,312 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+class ParallelMixerAudioSource::Worker  : public Thread
+{
+public:
+    Worker (ParallelMixerAudioSource& owner_, int index)
+        : Thread ("Parallel Mixer Worker " + String (index)),
+          owner (owner_)
+    {
+        // the audio thread will be waiting on these so they mustn't be pre-empted
+        startThread (10);
+    }
+
+    ~Worker()
+    {
+        signalThreadShouldExit();
+        startRendering.signal();
+        stopThread (4000);
+    }
+
+    void run()
+    {
+        for (;;)
+        {
+            startRendering.wait();
+
+            if (threadShouldExit())
+                return;
+
+            // read this first as the next callback can change it as soon as the last worker finishes
+            const int numWorkersRendering = owner.numWorkersRendering;
+            owner.renderInputs();
+
+            if (++owner.numWorkersFinished == numWorkersRendering)
+                owner.renderFinished.signal();
+        }
+    }
+
+    WaitableEvent startRendering;
+
+private:
+    ParallelMixerAudioSource& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker);
+};
+
+//==============================================================================
+ParallelMixerAudioSource::ParallelMixerAudioSource (int numWorkerThreads, int numChannels)
+    : numChannelsToMix (jmax (1, numChannels)),
+      activeInputList (nullptr),
+      renderCount (0),
+      currentSampleRate (0.0),
+      bufferSizeExpected (0),
+      renderingInputs (nullptr),
+      numInputsToRender (0),
+      numWorkersRendering (0),
+      numSamplesToRender (0)
+{
+    for (int i = 0; i < numWorkerThreads; ++i)
+        workers.add (new Worker (*this, i));
+}
+
+ParallelMixerAudioSource::~ParallelMixerAudioSource()
+{
+    workers.clear();
+    removeAllInputs();
+}
+
+//==============================================================================
+void ParallelMixerAudioSource::addInputSource (AudioSource* newInput, bool deleteWhenRemoved)
+{
+    if (newInput == nullptr)
+        return;
+
+    // the audio thread doesn't use this lock so the input can be prepared whilst holding it
+    const ScopedLock sl (lock);
+
+    for (int i = 0; i < inputs.size(); ++i)
+        if (inputs.getUnchecked (i)->source == newInput)
+            return;
+
+    Input* const input = new Input (newInput, deleteWhenRemoved);
+    inputs.add (input);
+
+    if (currentSampleRate > 0.0)
+        newInput->prepareToPlay (bufferSizeExpected, currentSampleRate);
+
+    input->buffer.setSize (numChannelsToMix, jmax (1, bufferSizeExpected));
+    publishInputs();
+}
+
+void ParallelMixerAudioSource::removeInputSource (AudioSource* inputToRemove)
+{
+    if (inputToRemove == nullptr)
+        return;
+
+    ScopedPointer<Input> input;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = 0; i < inputs.size(); ++i)
+        {
+            if (inputs.getUnchecked (i)->source == inputToRemove)
+            {
+                input = inputs.removeAndReturn (i);
+                publishInputs();
+                break;
+            }
+        }
+    }
+
+    // the source is deleted along with this if it was added with deleteWhenRemoved
+    if (input != nullptr)
+        input->source->releaseResources();
+}
+
+void ParallelMixerAudioSource::removeAllInputs()
+{
+    OwnedArray<Input> oldInputs;
+
+    {
+        const ScopedLock sl (lock);
+        oldInputs.swapWith (inputs);
+        publishInputs();
+    }
+
+    for (int i = 0; i < oldInputs.size(); ++i)
+        oldInputs.getUnchecked (i)->source->releaseResources();
+}
+
+int ParallelMixerAudioSource::getNumInputs() const
+{
+    const ScopedLock sl (lock);
+    return inputs.size();
+}
+
+double ParallelMixerAudioSource::getInputCpuUsage (int inputIndex) const
+{
+    // this only guards the list against other threads adding or removing inputs
+    const ScopedLock sl (lock);
+
+    if (const Input* const input = inputs[inputIndex])
+        return input->cpuUsage;
+
+    return 0.0;
+}
+
+//==============================================================================
+void ParallelMixerAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    const ScopedLock sl (lock);
+
+    currentSampleRate = sampleRate;
+    bufferSizeExpected = samplesPerBlockExpected;
+
+    for (int i = inputs.size(); --i >= 0;)
+    {
+        Input* const input = inputs.getUnchecked (i);
+        input->source->prepareToPlay (samplesPerBlockExpected, sampleRate);
+        input->buffer.setSize (numChannelsToMix, samplesPerBlockExpected);
+    }
+}
+
+void ParallelMixerAudioSource::releaseResources()
+{
+    const ScopedLock sl (lock);
+
+    for (int i = inputs.size(); --i >= 0;)
+    {
+        Input* const input = inputs.getUnchecked (i);
+        input->source->releaseResources();
+        input->buffer.setSize (numChannelsToMix, 0);
+    }
+
+    currentSampleRate = 0.0;
+    bufferSizeExpected = 0;
+}
+
+void ParallelMixerAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    // this is odd whilst a callback is running so inputs being removed can wait for it
+    ++renderCount;
+
+    const InputList* const list = activeInputList.get();
+    const int blockSize = bufferSizeExpected;
+
+    if (list == nullptr || list->size() == 0 || blockSize <= 0 || info.numSamples <= 0)
+    {
+        info.clearActiveBufferRegion();
+        ++renderCount;
+        return;
+    }
+
+    const int numChannels = jmin (info.buffer->getNumChannels(), numChannelsToMix);
+
+    for (int i = numChannels; i < info.buffer->getNumChannels(); ++i)
+        info.buffer->clear (i, info.startSample, info.numSamples);
+
+    renderingInputs = list;
+
+    // the input buffers are only resized when prepared so longer blocks are rendered in sections
+    for (int offset = 0; offset < info.numSamples; offset += blockSize)
+    {
+        const int numThisTime = jmin (blockSize, info.numSamples - offset);
+
+        // hand out the inputs to the workers, joining in on this thread too
+        numSamplesToRender = numThisTime;
+        numInputsToRender = list->size();
+        numWorkersRendering = jmin (workers.size(), list->size() - 1);
+        numWorkersFinished.set (0);
+        nextInputToRender.set (0);
+
+        for (int i = 0; i < numWorkersRendering; ++i)
+            workers.getUnchecked (i)->startRendering.signal();
+
+        renderInputs();
+
+        // wait for all the workers to finish so none of them are still running next time
+        if (numWorkersRendering > 0)
+            renderFinished.wait();
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            info.buffer->copyFrom (i, info.startSample + offset, list->getUnchecked (0)->buffer, i, 0, numThisTime);
+
+            for (int j = 1; j < list->size(); ++j)
+                info.buffer->addFrom (i, info.startSample + offset, list->getUnchecked (j)->buffer, i, 0, numThisTime);
+        }
+    }
+
+    ++renderCount;
+}
+
+//==============================================================================
+void ParallelMixerAudioSource::publishInputs()
+{
+    // called with the lock held
+    ScopedPointer<InputList> oldList (inputList.release());
+    inputList = new InputList();
+
+    for (int i = 0; i < inputs.size(); ++i)
+        inputList->add (inputs.getUnchecked (i));
+
+    activeInputList.set (inputList);
+
+    // a callback that started before the swap could still be using the old list
+    const int count = renderCount.get();
+
+    if ((count & 1) != 0)
+        while (renderCount.get() == count)
+            Thread::yield();
+}
+
+void ParallelMixerAudioSource::renderInputs()
+{
+    for (;;)
+    {
+        const int index = (++nextInputToRender) - 1;
+
+        if (index >= numInputsToRender)
+            break;
+
+        renderInput (*renderingInputs->getUnchecked (index));
+    }
+}
+
+void ParallelMixerAudioSource::renderInput (Input& input)
+{
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    AudioSourceChannelInfo info;
+    info.buffer = &input.buffer;
+    info.startSample = 0;
+    info.numSamples = numSamplesToRender;
+    input.source->getNextAudioBlock (info);
+
+    const double renderTime = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    const double cpuUsage = renderTime * currentSampleRate / numSamplesToRender;
+
+    input.cpuUsage = input.cpuUsage + 0.1 * (cpuUsage - input.cpuUsage);
+}
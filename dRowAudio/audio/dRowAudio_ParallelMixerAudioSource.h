@@ -0,0 +1,175 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_PARALLELMIXERAUDIOSOURCE_H__
+#define __DROWAUDIO_PARALLELMIXERAUDIOSOURCE_H__
+
+#include "../utility/dRowAudio_Utility.h"
+
+//==============================================================================
+/** An AudioSource that mixes together the output of a set of other AudioSources,
+    rendering them in parallel.
+
+    This works in the same way as a MixerAudioSource but each input is rendered
+    into its own buffer by a pool of high priority worker threads, with the
+    audio thread joining in. The callback waits until every input has been
+    rendered before summing them into the output. This is useful when each input
+    is expensive, such as several AudioFilePlayerExt decks, as the total time
+    taken is closer to that of the slowest input than the sum of them all.
+
+    The time taken to render each input is measured so you can find out which
+    inputs are the most expensive with getInputCpuUsage().
+
+    The audio thread never waits on a lock. Adding or removing an input publishes
+    a new list of inputs, and removing one waits for any callback still using the
+    old list to finish before releasing it.
+
+    @see MixerAudioSource
+*/
+class ParallelMixerAudioSource  : public AudioSource
+{
+public:
+    //==============================================================================
+    /** Creates a ParallelMixerAudioSource.
+
+        @param numWorkerThreads the number of threads to render with as well as the
+                                audio thread. This is normally one less than the
+                                number of CPU cores.
+        @param numChannels      the number of channels each input is rendered and
+                                mixed in. Any other output channels are cleared.
+     */
+    explicit ParallelMixerAudioSource (int numWorkerThreads, int numChannels = 2);
+
+    /** Destructor. */
+    ~ParallelMixerAudioSource();
+
+    //==============================================================================
+    /** Adds an input source to the mixer.
+
+        If the mixer is running you'll need to make sure that the input source
+        is ready to play by calling its prepareToPlay() method before adding it.
+        If the mixer is stopped, then its input sources will be automatically
+        prepared when the mixer's prepareToPlay() method is called.
+
+        @param newInput             the source to add to the mixer
+        @param deleteWhenRemoved    if true, then this source will be deleted when
+                                    no longer needed by the mixer.
+     */
+    void addInputSource (AudioSource* newInput, bool deleteWhenRemoved);
+
+    /** Removes an input source.
+        If the source was added by calling addInputSource() with the deleteWhenRemoved
+        flag set, it will be deleted by this method.
+     */
+    void removeInputSource (AudioSource* input);
+
+    /** Removes all the input sources.
+        Any sources which were added by calling addInputSource() with the deleteWhenRemoved
+        flag set will be deleted by this method.
+     */
+    void removeAllInputs();
+
+    /** Returns the number of input sources. */
+    int getNumInputs() const;
+
+    //==============================================================================
+    /** Returns the proportion of each callback's time that was spent rendering an input.
+
+        This is the time the input's getNextAudioBlock() took divided by the duration of
+        the audio rendered, smoothed over a few callbacks. A value of 0.5 means the
+        input on its own takes up half of the available time. This doesn't wait for
+        the audio thread.
+     */
+    double getInputCpuUsage (int inputIndex) const;
+
+    /** Returns the number of worker threads rendering alongside the audio thread. */
+    int getNumWorkerThreads() const noexcept                    {   return workers.size();  }
+
+    //==============================================================================
+    /** Implementation of the AudioSource method.
+        This will call prepareToPlay() on all its input sources.
+     */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method.
+        This will call releaseResources() on all its input sources.
+     */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+private:
+    //==============================================================================
+    struct Input
+    {
+        Input (AudioSource* source_, bool deleteWhenRemoved)
+            : source (source_, deleteWhenRemoved), cpuUsage (0.0)
+        {}
+
+        OptionalScopedPointer<AudioSource> source;
+        AudioSampleBuffer buffer;
+        double volatile cpuUsage;
+    };
+
+    typedef Array<Input*> InputList;
+
+    class Worker;
+    friend class Worker;
+
+    OwnedArray<Input> inputs;
+    OwnedArray<Worker> workers;
+    CriticalSection lock;
+    const int numChannelsToMix;
+
+    // inputs is only used by the other threads, the audio thread renders from this copy
+    ScopedPointer<InputList> inputList;
+    Atomic<InputList*> activeInputList;
+    Atomic<int> renderCount;
+
+    double currentSampleRate;
+    int bufferSizeExpected;
+
+    const InputList* renderingInputs;
+    Atomic<int> nextInputToRender, numWorkersFinished;
+    int numInputsToRender, numWorkersRendering, numSamplesToRender;
+    WaitableEvent renderFinished;
+
+    //==============================================================================
+    void publishInputs();
+    void renderInputs();
+    void renderInput (Input& input);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelMixerAudioSource);
+};
+
+#endif   // __DROWAUDIO_PARALLELMIXERAUDIOSOURCE_H__
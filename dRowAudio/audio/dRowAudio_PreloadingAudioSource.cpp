@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    // The number of samples loaded each time the background thread calls back
+    const int preloadChunkSize = 16384;
+}
+
+//==============================================================================
+PreloadingAudioSource::PreloadingAudioSource (PositionableAudioSource* source_,
+                                              TimeSliceThread& backgroundThread_,
+                                              bool deleteSourceWhenDeleted,
+                                              int numberOfChannels)
+    : source (source_, deleteSourceWhenDeleted),
+      backgroundThread (backgroundThread_),
+      totalLength (jmax ((int64) 0, source_->getTotalLength())),
+      buffer (numberOfChannels, canPreload (totalLength) ? (int) totalLength : 0),
+      numSamplesLoaded (0),
+      nextPlayPos (0),
+      isPrepared (false)
+{
+    jassert (source_ != nullptr);
+    jassert (canPreload (totalLength)); // too long to fit in an AudioSampleBuffer!
+
+    if (buffer.getNumSamples() > 0)
+    {
+        source->setNextReadPosition (0);
+        backgroundThread.addTimeSliceClient (this);
+    }
+}
+
+PreloadingAudioSource::~PreloadingAudioSource()
+{
+    backgroundThread.removeTimeSliceClient (this);
+}
+
+//==============================================================================
+bool PreloadingAudioSource::canPreload (int64 numSamples) noexcept
+{
+    return numSamples > 0 && numSamples <= std::numeric_limits<int>::max();
+}
+
+double PreloadingAudioSource::getProportionLoaded() const noexcept
+{
+    return totalLength > 0 ? numSamplesLoaded.get() / (double) totalLength
+                           : 0.0;
+}
+
+//==============================================================================
+void PreloadingAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRate)
+{
+    // the loaded data doesn't depend on the sample rate so only the first prepare needs to wait
+    if (isPrepared)
+        return;
+
+    isPrepared = true;
+
+    // give the thread a moment to load the first second so playback can start cleanly
+    const int64 numSamplesToWaitFor = jmin (totalLength, (int64) sampleRate);
+
+    for (int i = 0; i < 100 && numSamplesLoaded.get() < numSamplesToWaitFor; ++i)
+    {
+        backgroundThread.moveToFrontOfQueue (this);
+        Thread::sleep (5);
+    }
+}
+
+void PreloadingAudioSource::releaseResources()
+{
+    isPrepared = false;
+}
+
+void PreloadingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    const int64 numLoaded = numSamplesLoaded.get();
+    const bool looping = isLooping() && totalLength > 0;
+
+    int startSample = info.startSample;
+    int numSamplesLeft = info.numSamples;
+
+    while (numSamplesLeft > 0)
+    {
+        const int64 position = looping ? nextPlayPos % totalLength : nextPlayPos;
+        const int numThisTime = looping ? (int) jmin ((int64) numSamplesLeft, totalLength - position)
+                                        : numSamplesLeft;
+        const int numAvailable = position < 0 ? 0
+                                              : (int) jlimit ((int64) 0, (int64) numThisTime, numLoaded - position);
+
+        if (numAvailable > 0)
+        {
+            for (int i = 0; i < info.buffer->getNumChannels(); ++i)
+            {
+                if (i < buffer.getNumChannels())
+                    info.buffer->copyFrom (i, startSample, buffer, i, (int) position, numAvailable);
+                else
+                    info.buffer->clear (i, startSample, numAvailable);
+            }
+        }
+
+        if (numAvailable < numThisTime)
+            info.buffer->clear (startSample + numAvailable, numThisTime - numAvailable);
+
+        nextPlayPos = position + numThisTime;
+        startSample += numThisTime;
+        numSamplesLeft -= numThisTime;
+    }
+}
+
+int64 PreloadingAudioSource::getNextReadPosition() const
+{
+    return (isLooping() && totalLength > 0) ? nextPlayPos % totalLength
+                                            : nextPlayPos;
+}
+
+//==============================================================================
+int PreloadingAudioSource::useTimeSlice()
+{
+    const int64 startSample = numSamplesLoaded.get();
+
+    if (startSample >= totalLength)
+        return -1;
+
+    AudioSourceChannelInfo info;
+    info.buffer = &buffer;
+    info.startSample = (int) startSample;
+    info.numSamples = (int) jmin ((int64) preloadChunkSize, totalLength - startSample);
+
+    source->getNextAudioBlock (info);
+
+    // only publish the new samples once they've been written
+    numSamplesLoaded.set (startSample + info.numSamples);
+
+    return 1;
+}
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_PRELOADINGAUDIOSOURCE_H__
+#define __DROWAUDIO_PRELOADINGAUDIOSOURCE_H__
+
+#include "../utility/dRowAudio_Utility.h"
+
+//==============================================================================
+/** A PositionableAudioSource that reads the whole of its input into memory on
+    a background thread.
+
+    This is useful for compressed files where seeking means decoding again from
+    the nearest frame. Once a section has been loaded, reading from any
+    position in it is just a copy from memory. The input is read from start to
+    end, and anything that has been loaded can be played straight away. Any
+    part that hasn't been loaded yet plays as silence.
+
+    Note that the input is read from the background thread without being
+    prepared, so it should be something like an AudioFormatReaderSource that
+    doesn't need to be. It also shouldn't be read from anywhere else whilst
+    loading.
+
+    @see BufferingAudioSource, AudioFilePlayer::setPreloadsIntoMemory
+*/
+class PreloadingAudioSource  : public PositionableAudioSource,
+                               private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates a PreloadingAudioSource and starts loading the input.
+
+        @param source                       the input source to load
+        @param backgroundThread             the thread to load the input on. This must
+                                            not be deleted before this source is.
+        @param deleteSourceWhenDeleted      if true, then the input source object will
+                                            be deleted when this object is deleted
+        @param numberOfChannels             the number of channels to load
+     */
+    PreloadingAudioSource (PositionableAudioSource* source,
+                           TimeSliceThread& backgroundThread,
+                           bool deleteSourceWhenDeleted,
+                           int numberOfChannels = 2);
+
+    /** Destructor. */
+    ~PreloadingAudioSource();
+
+    //==============================================================================
+    /** Returns true if a source of this many samples can be loaded into memory.
+     */
+    static bool canPreload (int64 numSamples) noexcept;
+
+    /** Returns the number of samples from the start of the input that have been loaded.
+     */
+    int64 getNumSamplesLoaded() const noexcept      {   return numSamplesLoaded.get();  }
+
+    /** Returns the proportion of the input that has been loaded, from 0 to 1.
+     */
+    double getProportionLoaded() const noexcept;
+
+    /** Returns true once the whole of the input has been loaded.
+     */
+    bool isFullyLoaded() const noexcept             {   return numSamplesLoaded.get() >= totalLength;   }
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+    //==============================================================================
+    /** Implements the PositionableAudioSource method. */
+    void setNextReadPosition (int64 newPosition)    {   nextPlayPos = newPosition;  }
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getNextReadPosition() const;
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getTotalLength() const                    {   return totalLength;         }
+
+    /** Implements the PositionableAudioSource method. */
+    bool isLooping() const                          {   return source->isLooping(); }
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<PositionableAudioSource> source;
+    TimeSliceThread& backgroundThread;
+    const int64 totalLength;
+    AudioSampleBuffer buffer;
+    Atomic<int64> numSamplesLoaded;
+    int64 volatile nextPlayPos;
+    bool isPrepared;
+
+    int useTimeSlice();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PreloadingAudioSource);
+};
+
+#endif   // __DROWAUDIO_PRELOADINGAUDIOSOURCE_H__
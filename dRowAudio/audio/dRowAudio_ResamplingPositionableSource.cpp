@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    // the speed is ramped in steps of this many samples
+    const int speedRampBlockSize = 32;
+    const int inputBlockSize = 512;
+}
+
+//==============================================================================
+ResamplingPositionableSource::ResamplingPositionableSource (PositionableAudioSource* inputSource,
+                                                            bool deleteInputWhenDeleted,
+                                                            int numChannels_,
+                                                            SampleRateConverter::Quality quality)
+    : input (inputSource, deleteInputWhenDeleted),
+      numChannels (jmax (1, numChannels_)),
+      converter (numChannels, quality),
+      speed (1.0),
+      currentSpeed (1.0),
+      sourcePosition (0.0),
+      inputBuffer (numChannels, inputBlockSize),
+      spareOutputBuffer (numChannels, speedRampBlockSize),
+      inputBufferStart (0),
+      numInputSamplesBuffered (0)
+{
+    jassert (inputSource != nullptr);
+
+    inputChannels.calloc (numChannels);
+    outputChannels.calloc (numChannels);
+
+    resetConverter();
+}
+
+ResamplingPositionableSource::~ResamplingPositionableSource()
+{
+}
+
+//==============================================================================
+void ResamplingPositionableSource::setSpeed (double newSpeed)
+{
+    jassert (newSpeed > 0.0);
+    speed = jlimit (0.01, 256.0, newSpeed);
+}
+
+//==============================================================================
+void ResamplingPositionableSource::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRate)
+{
+    input->prepareToPlay (inputBlockSize, sampleRate);
+
+    const ScopedLock sl (lock);
+    currentSpeed = speed;
+    resetConverter();
+}
+
+void ResamplingPositionableSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void ResamplingPositionableSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    const ScopedLock sl (lock);
+
+    const int numBufferChannels = info.buffer->getNumChannels();
+    const double startSpeed = currentSpeed;
+    const double targetSpeed = speed;
+
+    for (int pos = 0; pos < info.numSamples;)
+    {
+        const int numThisTime = jmin (speedRampBlockSize, info.numSamples - pos);
+
+        currentSpeed = startSpeed + (targetSpeed - startSpeed) * (pos + numThisTime) / info.numSamples;
+        converter.setRatio (currentSpeed);
+
+        for (int numDone = 0; numDone < numThisTime;)
+        {
+            if (numInputSamplesBuffered == 0)
+                readInputBlock();
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                inputChannels[i] = inputBuffer.getReadPointer (i, inputBufferStart);
+                outputChannels[i] = i < numBufferChannels ? info.buffer->getWritePointer (i, info.startSample + pos + numDone)
+                                                          : spareOutputBuffer.getWritePointer (i);
+            }
+
+            int numUsed = 0;
+            const int numCreated = converter.process (inputChannels, numInputSamplesBuffered,
+                                                      outputChannels, numThisTime - numDone,
+                                                      numUsed);
+
+            inputBufferStart += numUsed;
+            numInputSamplesBuffered -= numUsed;
+            numDone += numCreated;
+            sourcePosition += numCreated * currentSpeed;
+        }
+
+        pos += numThisTime;
+    }
+
+    for (int i = numChannels; i < numBufferChannels; ++i)
+        info.buffer->clear (i, info.startSample, info.numSamples);
+}
+
+//==============================================================================
+void ResamplingPositionableSource::setNextReadPosition (int64 newPosition)
+{
+    const ScopedLock sl (lock);
+
+    sourcePosition = (double) newPosition;
+    resetConverter();
+}
+
+int64 ResamplingPositionableSource::getNextReadPosition() const
+{
+    const int64 position = (int64) sourcePosition;
+
+    return input->isLooping() && input->getTotalLength() > 0 ? position % input->getTotalLength()
+                                                             : position;
+}
+
+//==============================================================================
+void ResamplingPositionableSource::resetConverter()
+{
+    // prime the converter with the samples leading up to the position so the
+    // first output sample lines up with it exactly
+    const int64 position = (int64) sourcePosition;
+    sourcePosition = (double) position;
+
+    converter.reset (false);
+    input->setNextReadPosition (position - converter.getNumLeadInSamples());
+
+    inputBufferStart = 0;
+    numInputSamplesBuffered = 0;
+}
+
+void ResamplingPositionableSource::readInputBlock()
+{
+    AudioSourceChannelInfo info;
+    info.buffer = &inputBuffer;
+    info.startSample = 0;
+    info.numSamples = inputBuffer.getNumSamples();
+
+    input->getNextAudioBlock (info);
+
+    inputBufferStart = 0;
+    numInputSamplesBuffered = info.numSamples;
+}
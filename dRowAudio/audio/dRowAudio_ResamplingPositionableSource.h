@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_RESAMPLINGPOSITIONABLESOURCE_H__
+#define __DROWAUDIO_RESAMPLINGPOSITIONABLESOURCE_H__
+
+#include "dRowAudio_SampleRateConverter.h"
+
+//==============================================================================
+/** A PositionableAudioSource that plays its input back at a variable speed,
+    changing the pitch with it like a record deck or tape machine would.
+
+    This is a much cheaper alternative to a SoundTouchAudioSource when you don't
+    need to change the tempo and pitch independently. The speed can be changed
+    every block and is ramped across it so pitch fader movements are smooth.
+
+    Positions are all in samples of the input so you can use this in place of
+    the input in an AudioTransportSource and the reported position will still
+    follow the input.
+
+    @see SampleRateConverter, SoundTouchAudioSource
+ */
+class ResamplingPositionableSource  : public PositionableAudioSource
+{
+public:
+    //==============================================================================
+    /** Creates a ResamplingPositionableSource for a given input source.
+
+        @param inputSource              the source to read from
+        @param deleteInputWhenDeleted   whether to delete the input when this is deleted
+        @param numChannels              the number of channels to process
+        @param quality                  the quality of the resampling
+     */
+    ResamplingPositionableSource (PositionableAudioSource* inputSource,
+                                  bool deleteInputWhenDeleted,
+                                  int numChannels = 2,
+                                  SampleRateConverter::Quality quality = SampleRateConverter::mediumQuality);
+
+    /** Destructor. */
+    ~ResamplingPositionableSource();
+
+    //==============================================================================
+    /** Sets the playback speed.
+        1.0 plays at the normal speed, 2.0 twice as fast and an octave higher etc.
+        The change will be ramped to over the next block. This is limited to the
+        range the SampleRateConverter supports, 0.01 to 256.
+     */
+    void setSpeed (double newSpeed);
+
+    /** Returns the playback speed that has been set. */
+    double getSpeed() const noexcept                    {   return speed;   }
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& info);
+
+    //==============================================================================
+    /** Implements the PositionableAudioSource method. */
+    void setNextReadPosition (int64 newPosition);
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getNextReadPosition() const;
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getTotalLength() const                        {   return input->getTotalLength();     }
+
+    /** Implements the PositionableAudioSource method. */
+    bool isLooping() const                              {   return input->isLooping();          }
+
+    /** Implements the PositionableAudioSource method. */
+    void setLooping (bool shouldLoop)                   {   input->setLooping (shouldLoop);     }
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<PositionableAudioSource> input;
+    const int numChannels;
+    SampleRateConverter converter;
+    CriticalSection lock;
+
+    double volatile speed;
+    double currentSpeed, sourcePosition;
+
+    AudioSampleBuffer inputBuffer, spareOutputBuffer;
+    int inputBufferStart, numInputSamplesBuffered;
+    HeapBlock<const float*> inputChannels;
+    HeapBlock<float*> outputChannels;
+
+    //==============================================================================
+    void resetConverter();
+    void readInputBlock();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplingPositionableSource);
+};
+
+#endif // __DROWAUDIO_RESAMPLINGPOSITIONABLESOURCE_H__
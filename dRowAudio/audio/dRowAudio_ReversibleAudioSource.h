@@ -33,14 +33,20 @@
 #define __DROWAUDIO_REVERSIBLEAUDIOSOURCE_H__
 
 #include "../utility/dRowAudio_Utility.h"
+#include "dRowAudio_AudioSourceWithLatency.h"
 
 //==============================================================================
 /** A type of AudioSource that can reverse the stream of samples that
     flows through it.
 
-    @see PositionableAudioSource, AudioTransportSource, BufferingAudioSource
+    This plays backwards by repositioning its input every block so if the input
+    needs buffering use a BidirectionalBufferingAudioSource, which will read
+    ahead behind the playhead, rather than a BufferingAudioSource.
+
+    @see PositionableAudioSource, AudioTransportSource, BidirectionalBufferingAudioSource
 */
-class ReversibleAudioSource :   public AudioSource
+class ReversibleAudioSource :   public AudioSource,
+                                public AudioSourceWithLatency
 {
 public:
     //==============================================================================
@@ -76,6 +82,12 @@ public:
     /** Implementation of the AudioSource method. */
     void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
     
+    //==============================================================================
+    /** Implements the AudioSourceWithLatency method.
+        Reversing doesn't delay the audio so this is the latency of the input.
+     */
+    int getLatencySamples() const               { return getLatencySamplesOf (input);    }
+
 private:
     //==============================================================================
     OptionalScopedPointer<PositionableAudioSource> input;
@@ -86,4 +98,4 @@ private:
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReversibleAudioSource);
 };
 
-#endif   // __DROWAUDIO_REVERSIBLEAUDIOSOURCE_H__
\ No newline at end of file
+#endif   // __DROWAUDIO_REVERSIBLEAUDIOSOURCE_H__
\ No newline at end of file
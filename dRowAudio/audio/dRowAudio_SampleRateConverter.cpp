@@ -31,15 +31,100 @@
 
 
 
-//==============================================================================
-SampleRateConverter::SampleRateConverter (const int numChannels_)
-    : ratio (1.0),
-      numChannels (numChannels_)
+namespace
 {
-    filterStates.calloc (numChannels);
+    // intermediate phases are linearly interpolated between these
+    const int sincNumPhases = 128;
+
+    // Kaiser window shape, ~80 dB side lobe attenuation
+    const double sincKaiserBeta = 8.0;
+
+    // the number of input samples the history holds on top of the kernel length
+    const int sincHistoryBlockSize = 1024;
+
+    // kernels are built for cut-offs spaced a quarter of an octave apart up to the
+    // maximum ratio, with the two either side of the current ratio blended together
+    const int sincTablesPerOctave = 4;
+    const int sincNumCutoffTables = 8 * sincTablesPerOctave + 1;
+    const int sincMaxRatio = 1 << ((sincNumCutoffTables - 1) / sincTablesPerOctave);
+
+    double kaiserBesselI0 (double x)
+    {
+        double sum = 1.0, term = 1.0;
+        const double halfX = 0.5 * x;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    float* alignTo16Bytes (float* data) noexcept
+    {
+        return (float*) ((((pointer_sized_int) data) + 15) & ~(pointer_sized_int) 15);
+    }
+
+    // kernel must be 16 byte aligned and numTaps a multiple of 8
+    void blendKernels (float* dest, const float* kernel1, const float* kernel2, float proportion, int numTaps) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        const __m128 p = _mm_set1_ps (proportion);
+
+        for (int i = 0; i < numTaps; i += 4)
+        {
+            const __m128 k1 = _mm_load_ps (kernel1 + i);
+            _mm_store_ps (dest + i, _mm_add_ps (k1, _mm_mul_ps (p, _mm_sub_ps (_mm_load_ps (kernel2 + i), k1))));
+        }
+       #else
+        for (int i = 0; i < numTaps; ++i)
+            dest[i] = kernel1[i] + proportion * (kernel2[i] - kernel1[i]);
+       #endif
+    }
+
+    float convolve (const float* kernel, const float* samples, int numTaps) noexcept
+    {
+       #if DROWAUDIO_USE_SSE
+        __m128 sum = _mm_setzero_ps();
+
+        for (int i = 0; i < numTaps; i += 4)
+            sum = _mm_add_ps (sum, _mm_mul_ps (_mm_load_ps (kernel + i), _mm_loadu_ps (samples + i)));
+
+        float sums[4];
+        _mm_storeu_ps (sums, sum);
+
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+       #else
+        float sum = 0.0f;
+
+        for (int i = 0; i < numTaps; ++i)
+            sum += kernel[i] * samples[i];
+
+        return sum;
+       #endif
+    }
+}
 
-    createLowPass (ratio);
-    resetFilters();    
+//==============================================================================
+SampleRateConverter::SampleRateConverter (const int numChannels_, Quality quality_)
+    : numChannels (jmax (1, numChannels_)),
+      quality (quality_),
+      ratio (1.0),
+      kernels (nullptr),
+      window (nullptr),
+      blendedKernel (nullptr),
+      tableBlendKernel (nullptr),
+      currentKernels (nullptr),
+      tableProportion (0.0f),
+      numHistorySamples (0),
+      position (0.0)
+{
+    setQuality (quality_);
 }
 
 SampleRateConverter::~SampleRateConverter()
@@ -47,134 +132,238 @@ SampleRateConverter::~SampleRateConverter()
 }
 
 //==============================================================================
-void SampleRateConverter::process (float** inputChannelData, int numInputChannels, int numInputSamples,
-                                   float** outputChannelData, int numOutputChannels, int numOutputSamples)
+void SampleRateConverter::setQuality (Quality newQuality)
 {
-    // take a copy of the outpur channel pointers so they can be re-used afterwards
-    float* outputChannels[256];
-    for (int i = 0; i < numOutputChannels; ++i)
-        outputChannels[i] = outputChannelData[i];
-    
-    outputChannels[numOutputChannels] = nullptr;
-    
-    const int channelsToProcess = jmin (numInputChannels, numOutputChannels);
-    const double localRatio = numInputSamples / (double) numOutputSamples;
-        
-    if (localRatio != ratio)
-    {
-        createLowPass (localRatio);
-        ratio = localRatio;
-    }
-    
-    if (localRatio > 1.0001)
-    {
-        // for down-sampling, pre-apply the filter..
-        for (int i = channelsToProcess; --i >= 0;)
-            applyFilter (inputChannelData[i], numInputSamples, filterStates[i]);
-    }
-    
-    float nextSample = 0.0f;
-    for (int s = 0; s < numOutputSamples; ++s)
+    quality = newQuality;
+
+    const int tableSize = (sincNumPhases + 1) * quality;
+    kernelData.malloc (sincNumCutoffTables * tableSize + 4);
+    windowData.malloc (tableSize + 4);
+    blendedKernelData.malloc (2 * (quality + 4));
+
+    kernels = alignTo16Bytes (kernelData);
+    window = alignTo16Bytes (windowData);
+    blendedKernel = alignTo16Bytes (blendedKernelData);
+    tableBlendKernel = alignTo16Bytes (blendedKernelData + quality + 4);
+
+    // a single step at the maximum ratio can never take the read position past the end of the history
+    static_jassert (sincHistoryBlockSize > sincMaxRatio);
+    history.setSize (numChannels, quality + sincHistoryBlockSize);
+
+    createWindow();
+
+    for (int i = 0; i < sincNumCutoffTables; ++i)
+        createKernels (i);
+
+    setRatio (ratio);
+    reset();
+}
+
+void SampleRateConverter::setRatio (double inputSamplesPerOutputSample)
+{
+    jassert (inputSamplesPerOutputSample > 0.0);
+    ratio = jlimit (1.0e-6, (double) sincMaxRatio, inputSamplesPerOutputSample);
+
+    // this is called on the audio thread so only picks which of the kernels to use
+    const double tablePosition = ratio > 1.0 ? std::log (ratio) * (sincTablesPerOctave / std::log (2.0)) : 0.0;
+    const int tableIndex = jmin ((int) tablePosition, sincNumCutoffTables - 2);
+
+    currentKernels = kernels + tableIndex * (sincNumPhases + 1) * quality;
+    tableProportion = (float) (tablePosition - tableIndex);
+}
+
+void SampleRateConverter::reset (bool startWithSilence)
+{
+    // a kernel's worth of silence means output can be created straight away
+    history.clear();
+    numHistorySamples = startWithSilence ? quality : 0;
+    position = 0.0;
+}
+
+//==============================================================================
+int SampleRateConverter::process (const float* const* inputChannelData, int numInputSamples,
+                                  float* const* outputChannelData, int maxNumOutputSamples,
+                                  int& numInputSamplesUsed)
+{
+    numInputSamplesUsed = 0;
+    int numOutputSamples = 0;
+
+    for (;;)
     {
-        for (int channel = 0; channel < channelsToProcess; ++channel)
-            *outputChannels[channel]++ = linearInterpolate (inputChannelData[channel], numInputSamples, nextSample);
-        
-        nextSample += (float) localRatio;
+        const int numAppended = appendToHistory (inputChannelData, numChannels, numInputSamplesUsed,
+                                                 numInputSamples - numInputSamplesUsed);
+        numInputSamplesUsed += numAppended;
+
+        const int numCreated = createOutput (outputChannelData, numChannels, numOutputSamples,
+                                             maxNumOutputSamples - numOutputSamples);
+        numOutputSamples += numCreated;
+
+        if (numAppended == 0 && numCreated == 0)
+            break;
     }
-    
-    if (localRatio < 0.9999)
+
+    return numOutputSamples;
+}
+
+void SampleRateConverter::process (float** inputChannelData, int numInputChannels, int numInputSamples,
+                                   float** outputChannelData, int numOutputChannels, int numOutputSamples)
+{
+    if (numOutputSamples <= 0)
+        return;
+
+    const int channelsToProcess = jmin (numInputChannels, numOutputChannels, numChannels);
+    setRatio (numInputSamples / (double) numOutputSamples);
+
+    int numInputSamplesUsed = 0, numCreated = 0;
+
+    for (;;)
     {
-        // for up-sampling, apply the filter after transposing..
-        for (int i = channelsToProcess; --i >= 0;)
-            applyFilter (inputChannelData[i], numInputSamples, filterStates[i]);
+        const int numAppended = appendToHistory (inputChannelData, channelsToProcess, numInputSamplesUsed,
+                                                 numInputSamples - numInputSamplesUsed);
+        numInputSamplesUsed += numAppended;
+
+        const int numThisTime = createOutput (outputChannelData, channelsToProcess, numCreated,
+                                              numOutputSamples - numCreated);
+        numCreated += numThisTime;
+
+        if (numAppended == 0 && numThisTime == 0)
+            break;
     }
-    else if (localRatio <= 1.0001 && numInputSamples > 0)
+
+    // starting with a full kernel of history means the buffer sizes should always match up
+    jassert (numInputSamplesUsed == numInputSamples);
+    jassert (numCreated == numOutputSamples);
+
+    for (int i = 0; i < channelsToProcess; ++i)
+        zeromem (outputChannelData[i] + numCreated, sizeof (float) * (size_t) (numOutputSamples - numCreated));
+}
+
+//==============================================================================
+void SampleRateConverter::createWindow()
+{
+    const double halfLength = quality / 2;
+    const double windowNorm = 1.0 / kaiserBesselI0 (sincKaiserBeta);
+
+    for (int phase = 0; phase <= sincNumPhases; ++phase)
     {
-        // if the filter's not currently being applied, keep it stoked with the last couple of samples to avoid discontinuities
-        for (int i = channelsToProcess; --i >= 0;)
+        float* const row = window + phase * quality;
+        const double fraction = phase / (double) sincNumPhases;
+
+        for (int i = 0; i < quality; ++i)
         {
-            const float* const endOfBuffer = &inputChannelData[i][numInputSamples - 1];
-            FilterState& fs = filterStates[i];
-            
-            if (numInputSamples > 1)
-            {
-                fs.y2 = fs.x2 = *(endOfBuffer - 1);
-            }
-            else
-            {
-                fs.y2 = fs.y1;
-                fs.x2 = fs.x1;
-            }
-            
-            fs.y1 = fs.x1 = *endOfBuffer;
+            const double x = (i - (halfLength - 1.0) - fraction) / halfLength;
+            const double t = x * x < 1.0 ? 1.0 - x * x : 0.0;
+
+            row[i] = (float) (kaiserBesselI0 (sincKaiserBeta * std::sqrt (t)) * windowNorm);
         }
     }
 }
 
-//==============================================================================
-void SampleRateConverter::setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6)
+void SampleRateConverter::createKernels (int tableIndex)
 {
-    const double a = 1.0 / c4;
-    
-    c1 *= a;
-    c2 *= a;
-    c3 *= a;
-    c5 *= a;
-    c6 *= a;
-    
-    coefficients[0] = c1;
-    coefficients[1] = c2;
-    coefficients[2] = c3;
-    coefficients[3] = c4;
-    coefficients[4] = c5;
-    coefficients[5] = c6;
-}
+    // shorter kernels need a wider transition band to keep the aliasing down, and
+    // when down-sampling the cut-off has to come down with the output's nyquist
+    const double rolloff = 1.0 - 1.6 / quality;
+    const double cutoff = 0.5 * rolloff / std::pow (2.0, tableIndex / (double) sincTablesPerOctave);
 
-void SampleRateConverter::createLowPass (const double frequencyRatio)
-{
-    const double proportionalRate = (frequencyRatio > 1.0) ? 0.5 / frequencyRatio
-                                                           : 0.5 * frequencyRatio;
-    
-    const double n = 1.0 / std::tan (double_Pi * jmax (0.001, proportionalRate));
-    const double nSquared = n * n;
-    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
-    
-    setFilterCoefficients (c1,
-                           c1 * 2.0f,
-                           c1,
-                           1.0,
-                           c1 * 2.0 * (1.0 - nSquared),
-                           c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
+    const double halfLength = quality / 2;
+    const double fc2 = 2.0 * cutoff;
+    const double wc = double_Pi * fc2;
+    float* const table = kernels + tableIndex * (sincNumPhases + 1) * quality;
+
+    for (int phase = 0; phase <= sincNumPhases; ++phase)
+    {
+        float* const row = table + phase * quality;
+        const float* const windowRow = window + phase * quality;
+        const double fraction = phase / (double) sincNumPhases;
+        double sum = 0.0;
+
+        for (int i = 0; i < quality; ++i)
+        {
+            const double t = (i - (halfLength - 1.0) - fraction) * wc;
+            const double h = (t != 0.0) ? fc2 * std::sin (t) / t : fc2;
+            const double value = h * windowRow[i];
+
+            row[i] = (float) value;
+            sum += value;
+        }
+
+        // unity gain at DC for every phase so the level isn't modulated
+        const float scale = (float) (1.0 / sum);
+
+        for (int i = 0; i < quality; ++i)
+            row[i] *= scale;
+    }
 }
 
-void SampleRateConverter::resetFilters()
+int SampleRateConverter::appendToHistory (const float* const* inputChannelData, int numChannelsToUse,
+                                          int startSample, int numSamples)
 {
-    filterStates.clear (numChannels);
+    const int numToCopy = jmin (numSamples, history.getNumSamples() - numHistorySamples);
+
+    if (numToCopy <= 0)
+        return 0;
+
+    for (int i = 0; i < numChannelsToUse; ++i)
+        history.copyFrom (i, numHistorySamples, inputChannelData[i] + startSample, numToCopy);
+
+    numHistorySamples += numToCopy;
+
+    return numToCopy;
 }
 
-void SampleRateConverter::applyFilter (float* samples, int num, FilterState& fs)
+int SampleRateConverter::createOutput (float* const* outputChannelData, int numChannelsToUse,
+                                       int startSample, int maxNumSamples)
 {
-    while (--num >= 0)
+    int numCreated = 0;
+
+    while (numCreated < maxNumSamples)
+    {
+        const int readStart = (int) position;
+
+        if (readStart + quality > numHistorySamples)
+            break;
+
+        const double phase = (position - readStart) * sincNumPhases;
+        const int phaseIndex = (int) phase;
+        const float phaseProportion = (float) (phase - phaseIndex);
+        const float* const kernel = currentKernels + phaseIndex * quality;
+
+        blendKernels (blendedKernel, kernel, kernel + quality, phaseProportion, quality);
+
+        if (tableProportion > 0.0f)
+        {
+            const float* const nextTableKernel = kernel + (sincNumPhases + 1) * quality;
+
+            blendKernels (tableBlendKernel, nextTableKernel, nextTableKernel + quality, phaseProportion, quality);
+            blendKernels (blendedKernel, blendedKernel, tableBlendKernel, tableProportion, quality);
+        }
+
+        for (int i = 0; i < numChannelsToUse; ++i)
+            outputChannelData[i][startSample + numCreated] = convolve (blendedKernel,
+                                                                       history.getReadPointer (i, readStart),
+                                                                       quality);
+
+        position += ratio;
+        ++numCreated;
+    }
+
+    // drop the samples before the next kernel start
+    const int numUsed = jmin ((int) position, numHistorySamples);
+
+    if (numUsed > 0)
     {
-        const double in = *samples;
-        
-        double out = coefficients[0] * in
-        + coefficients[1] * fs.x1
-        + coefficients[2] * fs.x2
-        - coefficients[4] * fs.y1
-        - coefficients[5] * fs.y2;
-        
-#if JUCE_INTEL
-        if (! (out < -1.0e-8 || out > 1.0e-8))
-            out = 0;
-#endif
-        
-        fs.x2 = fs.x1;
-        fs.x1 = in;
-        fs.y2 = fs.y1;
-        fs.y1 = out;
-        
-        *samples++ = (float) out;
+        const int numLeft = numHistorySamples - numUsed;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            float* const data = history.getWritePointer (i);
+            memmove (data, data + numUsed, sizeof (float) * (size_t) numLeft);
+        }
+
+        numHistorySamples = numLeft;
+        position -= numUsed;
     }
-}
 
+    return numCreated;
+}
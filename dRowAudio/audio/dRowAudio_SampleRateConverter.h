@@ -34,59 +34,138 @@
 
 //==============================================================================
 /**
-    Simple sample rate converter class.
+    Streaming sample rate converter class.
  
-    This converts a block of samples from one sample rate to another. It is
-    based on a linear interpolation algorithm.
-    To use it simply create one with the desired number of channels and then
-    repeatedly call its process() method. The sample ratio is based on the
-    difference in input and output buffer sizes so for example to convert a
+    This converts a stream of samples from one sample rate to another using
+    polyphase windowed-sinc interpolation. The converter keeps a history of the
+    input between calls so the stream can be processed in blocks of any size and
+    the ratio changed between them without any discontinuities.
+
+    To use it create one with the desired number of channels and quality, set the
+    ratio and then repeatedly call process(), passing in as much input as you have
+    and getting back as many output samples as could be created.
+
+    The older form of process() is still available which bases the ratio on the
+    difference in input and output buffer sizes, so for example to convert a
     44.1KHz signal to a 22.05KHz one you could pass in buffers with sizes 512
     and 256 respectively.
  */
 class SampleRateConverter
 {
 public:
+    //==============================================================================
+    /** The quality of the conversion, given as the number of input samples used to
+        create each output sample.
+     */
+    enum Quality
+    {
+        lowQuality      = 8,
+        mediumQuality   = 16,
+        highQuality     = 32,
+        bestQuality     = 64
+    };
+
     //==============================================================================
     /** Creates a SampleRateConverter with a given number of channels.
      */
-    SampleRateConverter (const int numChannels = 1);
+    SampleRateConverter (const int numChannels = 1, Quality quality = mediumQuality);
 
     /** Destructor.
      */
     ~SampleRateConverter();
-    
-    /** Performs the conversion.
-        The minimum number of channels will be processed here so it is a good idea
-        to make sure that the number of input channels is equal to the number of
-        output channels. The input channel data is filtered during this process so
-        if you don't want to lose it then make a copy before calling this method.
+
+    //==============================================================================
+    /** Changes the quality of the conversion.
+        This will reset the converter.
+     */
+    void setQuality (Quality newQuality);
+
+    /** Returns the quality being used. */
+    Quality getQuality() const noexcept                 {   return quality;     }
+
+    /** Sets the number of input samples to use for each output sample.
+        For example a ratio of 2.0 would convert a 88.2KHz stream to 44.1KHz. This
+        can be changed between calls to process() and doesn't allocate or build
+        any filters, so it is safe to call on the audio thread. The ratio is
+        limited to 256.
+     */
+    void setRatio (double inputSamplesPerOutputSample);
+
+    /** Returns the current ratio. */
+    double getRatio() const noexcept                    {   return ratio;       }
+
+    /** Returns the delay the converter adds to the stream, in input samples. */
+    int getLatencyInInputSamples() const noexcept       {   return quality / 2 + 1;    }
+
+    /** Clears the history so the next call to process() starts a new stream.
+
+        By default the history starts with a kernel's worth of silence, which is
+        what delays the stream by getLatencyInInputSamples(). If you'd rather
+        prime the converter with real input pass false, in which case the first
+        output sample will line up with input sample getNumLeadInSamples().
+     */
+    void reset (bool startWithSilence = true);
+
+    /** Returns the number of input samples needed before the first output sample
+        when the converter is reset without silence.
+     */
+    int getNumLeadInSamples() const noexcept            {   return quality / 2 - 1;    }
+
+    //==============================================================================
+    /** Converts some input samples using the current ratio.
+
+        As many of the input samples as possible are used, and as many output
+        samples created as there is room for. Any input that isn't used should be
+        passed in again on the next call.
+
+        @param inputChannelData         an array of numChannels pointers to the input
+        @param numInputSamples          the number of input samples available
+        @param outputChannelData        an array of numChannels pointers to write to
+        @param maxNumOutputSamples      the space available in the output channels
+        @param numInputSamplesUsed      on return, how many input samples were used
+        @returns the number of output samples created
+     */
+    int process (const float* const* inputChannelData, int numInputSamples,
+                 float* const* outputChannelData, int maxNumOutputSamples,
+                 int& numInputSamplesUsed);
+
+    /** Performs the conversion based on the buffer sizes.
+        The ratio is set to numInputSamples / numOutputSamples, all of the input is
+        used and all of the output filled, as long as that ratio is within the
+        limit given in setRatio(). The minimum number of channels will be
+        processed here so it is a good idea to make sure that the number of input
+        channels is equal to the number of output channels.
      */
     void process (float** inputChannelData, int numInputChannels, int numInputSamples,
                   float** outputChannelData, int numOutputChannels, int numOutputSamples);
 
 private:
     //==============================================================================
-    double ratio;
-    double coefficients[6];
     const int numChannels;
-    
-    void setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6);
-    void createLowPass (double proportionalRate);
-    
-    struct FilterState
-    {
-        double x1, x2, y1, y2;
-    };
-    
-    HeapBlock<FilterState> filterStates;
-    void resetFilters();
-    
-    void applyFilter (float* samples, int num, FilterState& fs);
+    Quality quality;
+    double ratio;
+
+    HeapBlock<float> kernelData, windowData, blendedKernelData;
+    float* kernels;
+    float* window;
+    float* blendedKernel;
+    float* tableBlendKernel;
+    const float* currentKernels;
+    float tableProportion;
+
+    AudioSampleBuffer history;
+    int numHistorySamples;
+    double position;
+
+    //==============================================================================
+    void createWindow();
+    void createKernels (int tableIndex);
+    int appendToHistory (const float* const* inputChannelData, int numChannelsToUse, int startSample, int numSamples);
+    int createOutput (float* const* outputChannelData, int numChannelsToUse, int startSample, int maxNumSamples);
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleRateConverter);
 };
 
 
-#endif  // __SAMPLERATECONVERTER_H_65500721__
+#endif  // __DROWAUDIO_SAMPLERATECONVERTER_H__
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    const int scrubReadChunkSize = 4096;
+    const double maxScrubSpeed = 4.0;
+}
+
+//==============================================================================
+ScrubbingAudioSource::ScrubbingAudioSource (PositionableAudioSource* source_,
+                                            bool deleteSourceWhenDeleted,
+                                            TimeSliceThread& backgroundThread_,
+                                            int numSamplesEachSide_)
+    : source (source_, deleteSourceWhenDeleted),
+      backgroundThread (backgroundThread_),
+      numSamplesEachSide (jmax (scrubReadChunkSize, numSamplesEachSide_)),
+      // an extra chunk leaves room to read the next one without dropping any of the wanted range
+      windowSize (2 * numSamplesEachSide + scrubReadChunkSize),
+      window (2, windowSize),
+      readBuffer (2, scrubReadChunkSize),
+      validStart (0),
+      validEnd (0),
+      targetPosition (0.0),
+      responseTime (0.05),
+      playPosition (0.0),
+      velocity (0.0),
+      sampleRate (44100.0)
+{
+    jassert (source_ != nullptr);
+
+    backgroundThread.addTimeSliceClient (this);
+}
+
+ScrubbingAudioSource::~ScrubbingAudioSource()
+{
+    backgroundThread.removeTimeSliceClient (this);
+}
+
+//==============================================================================
+void ScrubbingAudioSource::setTargetPosition (double newTargetSample)
+{
+    targetPosition = newTargetSample;
+    backgroundThread.moveToFrontOfQueue (this);
+}
+
+void ScrubbingAudioSource::setResponseTime (double newResponseTimeSeconds)
+{
+    jassert (newResponseTimeSeconds > 0.0);
+
+    responseTime = newResponseTimeSeconds;
+}
+
+//==============================================================================
+void ScrubbingAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+void ScrubbingAudioSource::releaseResources()
+{
+}
+
+void ScrubbingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    // the lock is only held briefly whilst the window is moved
+    const ScopedTryLock sl (windowLock);
+
+    if (! sl.isLocked())
+    {
+        info.clearActiveBufferRegion();
+        return;
+    }
+
+    const double target = targetPosition;
+    const double catchUpSamples = jmax (1.0, responseTime * sampleRate);
+    const double smoothing = jmin (1.0, 4.0 / catchUpSamples);
+    const double start = (double) validStart;
+    const double end = (double) (validEnd - 1);
+
+    const int numChannels = jmin (info.buffer->getNumChannels(), window.getNumChannels());
+    const float* const leftIn = window.getReadPointer (0);
+    const float* const rightIn = window.getReadPointer (numChannels > 1 ? 1 : 0);
+    float* const leftOut = info.buffer->getWritePointer (0, info.startSample);
+    float* const rightOut = numChannels > 1 ? info.buffer->getWritePointer (1, info.startSample) : nullptr;
+
+    for (int i = numChannels; i < info.buffer->getNumChannels(); ++i)
+        info.buffer->clear (i, info.startSample, info.numSamples);
+
+    for (int s = 0; s < info.numSamples; ++s)
+    {
+        const double targetVelocity = jlimit (-maxScrubSpeed, maxScrubSpeed, (target - playPosition) / catchUpSamples);
+        velocity += (targetVelocity - velocity) * smoothing;
+        playPosition += velocity;
+
+        // fade out as the playhead comes to rest rather than holding a DC offset
+        const float gain = (float) jmin (1.0, std::abs (velocity) * 4.0);
+
+        if (gain > 0.0f && playPosition >= start && playPosition < end)
+        {
+            const int64 position = (int64) playPosition;
+            const float proportion = gain * (float) (playPosition - position);
+            const int index1 = (int) (position % windowSize);
+            const int index2 = index1 + 1 < windowSize ? index1 + 1 : 0;
+
+            leftOut[s] = gain * leftIn[index1] + proportion * (leftIn[index2] - leftIn[index1]);
+
+            if (rightOut != nullptr)
+                rightOut[s] = gain * rightIn[index1] + proportion * (rightIn[index2] - rightIn[index1]);
+        }
+        else
+        {
+            leftOut[s] = 0.0f;
+
+            if (rightOut != nullptr)
+                rightOut[s] = 0.0f;
+        }
+    }
+}
+
+//==============================================================================
+void ScrubbingAudioSource::setNextReadPosition (int64 newPosition)
+{
+    playPosition = targetPosition = (double) newPosition;
+    velocity = 0.0;
+
+    backgroundThread.moveToFrontOfQueue (this);
+}
+
+//==============================================================================
+int ScrubbingAudioSource::useTimeSlice()
+{
+    const int64 totalLength = source->getTotalLength();
+    const int64 centre = jlimit ((int64) 0, jmax ((int64) 0, totalLength), (int64) targetPosition);
+    const int64 wantedStart = jmax ((int64) 0, centre - numSamplesEachSide);
+    const int64 wantedEnd = jmin (totalLength, centre + numSamplesEachSide);
+
+    // if the target has jumped out of the window start again from there
+    if (centre < validStart || centre > validEnd)
+    {
+        const ScopedLock sl (windowLock);
+        validStart = validEnd = jmax (wantedStart, centre - scrubReadChunkSize / 2);
+    }
+
+    // fill whichever side of the target has the least loaded
+    const int64 numNeededAfter = wantedEnd - validEnd;
+    const int64 numNeededBefore = validStart - wantedStart;
+
+    if (numNeededAfter <= 0 && numNeededBefore <= 0)
+        return 10;
+
+    const bool readAfter = numNeededAfter >= numNeededBefore;
+    const int numToRead = (int) jmin ((int64) scrubReadChunkSize, readAfter ? numNeededAfter : numNeededBefore);
+    const int64 readStart = readAfter ? validEnd : validStart - numToRead;
+
+    // The new section would overwrite the far end of the window so drop that first.
+    // As the window is a chunk bigger than the wanted range this is always outside that range.
+    if (validEnd - validStart + numToRead > windowSize)
+    {
+        const ScopedLock sl (windowLock);
+
+        if (readAfter)
+            validStart = validEnd + numToRead - windowSize;
+        else
+            validEnd = validStart - numToRead + windowSize;
+    }
+
+    AudioSourceChannelInfo info;
+    info.buffer = &readBuffer;
+    info.startSample = 0;
+    info.numSamples = numToRead;
+
+    source->setNextReadPosition (readStart);
+    source->getNextAudioBlock (info);
+
+    const int writeIndex = (int) (readStart % windowSize);
+    const int numBeforeWrap = jmin (numToRead, windowSize - writeIndex);
+
+    for (int i = 0; i < window.getNumChannels(); ++i)
+    {
+        window.copyFrom (i, writeIndex, readBuffer, i, 0, numBeforeWrap);
+
+        if (numToRead > numBeforeWrap)
+            window.copyFrom (i, 0, readBuffer, i, numBeforeWrap, numToRead - numBeforeWrap);
+    }
+
+    {
+        const ScopedLock sl (windowLock);
+
+        if (readAfter)
+            validEnd = validEnd + numToRead;
+        else
+            validStart = readStart;
+    }
+
+    return 1;
+}
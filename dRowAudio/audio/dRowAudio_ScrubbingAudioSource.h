@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_SCRUBBINGAUDIOSOURCE_H__
+#define __DROWAUDIO_SCRUBBINGAUDIOSOURCE_H__
+
+#include "../utility/dRowAudio_Utility.h"
+
+//==============================================================================
+/** A PositionableAudioSource for scrubbing through a source.
+
+    This keeps a window of decoded audio either side of a target position in
+    memory, which is filled on a background thread as the target moves. The
+    playhead chases the target at a speed proportional to how far behind it is,
+    so moving the target back and forth plays the audio in either direction at
+    varying speed, just like moving a record by hand. The output fades out as
+    the playhead comes to rest.
+
+    Moving the target never flushes anything so this can be updated on every
+    mouse move without any stuttering.
+
+    @see AudioFilePlayer::setScrubbing
+*/
+class ScrubbingAudioSource  : public PositionableAudioSource,
+                              private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates a ScrubbingAudioSource.
+
+        @param source                   the source to read the window from. This is read and
+                                        repositioned on the background thread so mustn't be
+                                        used by anything else, e.g. the audio thread.
+        @param deleteSourceWhenDeleted  whether to delete the source when this is deleted
+        @param backgroundThread         the thread to fill the window on
+        @param numSamplesEachSide       the number of samples either side of the target to keep
+     */
+    ScrubbingAudioSource (PositionableAudioSource* source,
+                          bool deleteSourceWhenDeleted,
+                          TimeSliceThread& backgroundThread,
+                          int numSamplesEachSide);
+
+    /** Destructor. */
+    ~ScrubbingAudioSource();
+
+    //==============================================================================
+    /** Sets the sample position the playhead should move to. */
+    void setTargetPosition (double newTargetSample);
+
+    /** Returns the sample position the playhead is moving to. */
+    double getTargetPosition() const noexcept               {   return targetPosition;  }
+
+    /** Sets roughly how long the playhead takes to catch up with the target.
+        The default of 0.05 seconds suits targets set from mouse events.
+     */
+    void setResponseTime (double newResponseTimeSeconds);
+
+    //==============================================================================
+    /** Implementation of the AudioSource method. */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+
+    /** Implementation of the AudioSource method. */
+    void releaseResources();
+
+    /** Implementation of the AudioSource method. */
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+    //==============================================================================
+    /** Moves the playhead and target to a position straight away. */
+    void setNextReadPosition (int64 newPosition);
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getNextReadPosition() const                       {   return (int64) playPosition;        }
+
+    /** Implements the PositionableAudioSource method. */
+    int64 getTotalLength() const                            {   return source->getTotalLength();    }
+
+    /** Implements the PositionableAudioSource method. */
+    bool isLooping() const                                  {   return false;                       }
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<PositionableAudioSource> source;
+    TimeSliceThread& backgroundThread;
+    const int numSamplesEachSide, windowSize;
+    AudioSampleBuffer window, readBuffer;
+
+    CriticalSection windowLock;
+    int64 volatile validStart, validEnd;
+
+    double volatile targetPosition, responseTime;
+    double playPosition, velocity, sampleRate;
+
+    int useTimeSlice();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScrubbingAudioSource);
+};
+
+#endif   // __DROWAUDIO_SCRUBBINGAUDIOSOURCE_H__
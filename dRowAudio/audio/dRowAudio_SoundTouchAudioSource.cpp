@@ -31,7 +31,12 @@
 
 #if DROWAUDIO_USE_SOUNDTOUCH
 
-
+namespace
+{
+    // Mirrors the automatic seek window calculation in TDStretch
+    const double autoSeekTempoLow = 0.5, autoSeekTempoHigh = 2.0;
+    const double autoSeekMsAtLow = 25.0, autoSeekMsAtHigh = 15.0;
+}
 
 SoundTouchAudioSource::SoundTouchAudioSource (PositionableAudioSource* source_,
                                               bool deleteSourceWhenDeleted,
@@ -42,6 +47,8 @@ SoundTouchAudioSource::SoundTouchAudioSource (PositionableAudioSource* source_,
       numberOfChannels (numberOfChannels_),
       buffer (numberOfChannels_, 0),
       nextReadPos (0),
+      sampleRate (44100.0),
+      latencySamples (0),
       isPrepared (false)
 {
     jassert (source_ != nullptr);
@@ -62,7 +69,7 @@ void SoundTouchAudioSource::setPlaybackSettings (SoundTouchProcessor::PlaybackSe
 //==============================================================================
 void SoundTouchAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRate_)
 {
-    soundTouchProcessor.initialise (numberOfChannels, sampleRate);
+    soundTouchProcessor.initialise (numberOfChannels, sampleRate_);
     
     if (sampleRate_ != sampleRate
         || numberOfSamplesToBuffer != buffer.getNumSamples()
@@ -94,6 +101,8 @@ void SoundTouchAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& inf
                                      info.numSamples, info.startSample);
 
     effectiveNextPlayPos += (int64) (info.numSamples * soundTouchProcessor.getEffectivePlaybackRatio());
+
+    updateLatency();
 }
 
 //==============================================================================
@@ -131,5 +140,30 @@ void SoundTouchAudioSource::readNextBufferChunk()
     soundTouchProcessor.writeSamples (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), info.numSamples);
 }
 
+void SoundTouchAudioSource::updateLatency()
+{
+    const double ratio = soundTouchProcessor.getEffectivePlaybackRatio();
+
+    if (ratio <= 0.0)
+        return;
+
+    double seekWindowMs = soundTouchProcessor.getSoundTouchSetting (SETTING_SEEKWINDOW_MS);
+
+    if (seekWindowMs <= 0.0)
+    {
+        const SoundTouchProcessor::PlaybackSettings settings (soundTouchProcessor.getPlaybackSettings());
+        const double stretch = settings.pitch > 0.0f ? settings.tempo / settings.pitch : settings.tempo;
+        const double tempo = jlimit (autoSeekTempoLow, autoSeekTempoHigh, stretch);
+        const double proportion = (tempo - autoSeekTempoLow) / (autoSeekTempoHigh - autoSeekTempoLow);
+        seekWindowMs = autoSeekMsAtLow + proportion * (autoSeekMsAtHigh - autoSeekMsAtLow);
+    }
+
+    // both the lead and the input's latency are measured at the input so convert them to output samples
+    const double leadSamples = 0.5 * seekWindowMs * sampleRate / 1000.0;
+    const int inputLatency = getLatencySamplesOf (source);
+
+    latencySamples = roundToInt ((inputLatency - leadSamples) / ratio);
+}
+
 
 #endif
@@ -35,12 +35,14 @@
 #if DROWAUDIO_USE_SOUNDTOUCH || DOXYGEN
 
 #include "dRowAudio_SoundTouchProcessor.h"
+#include "dRowAudio_AudioSourceWithLatency.h"
 
 //==============================================================================
 /** An audio source that can independently change the rate, tempo and pitch of
     an audio source. This uses the SoundTouch library to perform the processing.
  */
-class SoundTouchAudioSource :   public PositionableAudioSource
+class SoundTouchAudioSource :   public PositionableAudioSource,
+                                public AudioSourceWithLatency
 {
 public:
     //==============================================================================
@@ -101,6 +103,16 @@ public:
     /** Implements the PositionableAudioSource method. */
     void setLooping (bool shouldLoop)           { source->setLooping (shouldLoop);  }
     
+    //==============================================================================
+    /** Implements the AudioSourceWithLatency method.
+        SoundTouch picks the best matching point within its seek window for each
+        sequence so its output leads the nominal play position by roughly half of
+        the window. This is only an estimate as the actual offset varies from
+        sequence to sequence and it is negative as the audio is early. The value
+        is updated each block so reflects the most recent playback settings.
+     */
+    int getLatencySamples() const               { return latencySamples;            }
+
 private:
     //==============================================================================
     OptionalScopedPointer<PositionableAudioSource> source;
@@ -109,11 +121,13 @@ private:
     CriticalSection bufferStartPosLock;
     int64 volatile nextReadPos, effectiveNextPlayPos;
     double volatile sampleRate;
+    int volatile latencySamples;
     bool isPrepared;
     
     SoundTouchProcessor soundTouchProcessor;
     
     void readNextBufferChunk();
+    void updateLatency();
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundTouchAudioSource);
@@ -130,6 +130,8 @@ void SoundTouchProcessor::setPlaybackSettings (PlaybackSettings newSettings)
 
 void SoundTouchProcessor::setSoundTouchSetting (int settingId, int settingValue)
 {
+    // some settings clear the buffers or rebuild the interpolator's tables
+    const ScopedLock sl (lock);
     soundTouch.setSetting (settingId, settingValue);
 }
 
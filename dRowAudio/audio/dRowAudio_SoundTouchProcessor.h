@@ -125,7 +125,8 @@ public:
     PlaybackSettings getPlaybackSettings()                      {   return settings;                            }
     
     /** Sets a custom SoundTouch setting.
-        See SoundTouch.h for details.
+        See SoundTouch.h for details. Some settings clear SoundTouch's buffers so
+        this blocks the audio thread whilst they are changed.
      */
     void setSoundTouchSetting (int settingId, int settingValue);
     
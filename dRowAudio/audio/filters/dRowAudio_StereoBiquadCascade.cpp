@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    typedef float StereoBiquadCoefficients[5];
+    typedef float StereoBiquadState[2][2];
+
+    /*  Each stage is a transposed direct form II biquad using the IIRCoefficients
+        layout of { b0, b1, b2, a1, a2 } normalised by a0. state[stage][channel]
+        holds the two delay elements.
+     */
+   #if DROWAUDIO_USE_SSE
+    void processStereoBiquads (float* left, float* right, int numSamples, int numStages,
+                               const StereoBiquadCoefficients* coeffs, const StereoBiquadCoefficients* deltas,
+                               StereoBiquadState* state) noexcept
+    {
+        __m128 c[StereoBiquadCascade::maxNumStages][5], d[StereoBiquadCascade::maxNumStages][5];
+        __m128 z1[StereoBiquadCascade::maxNumStages], z2[StereoBiquadCascade::maxNumStages];
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            for (int k = 0; k < 5; ++k)
+            {
+                c[s][k] = _mm_set1_ps (coeffs[s][k]);
+                d[s][k] = _mm_set1_ps (deltas != nullptr ? deltas[s][k] : 0.0f);
+            }
+
+            z1[s] = _mm_setr_ps (state[s][0][0], state[s][1][0], 0.0f, 0.0f);
+            z2[s] = _mm_setr_ps (state[s][0][1], state[s][1][1], 0.0f, 0.0f);
+        }
+
+        float out[4];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            __m128 x = _mm_setr_ps (left[i], right[i], 0.0f, 0.0f);
+
+            for (int s = 0; s < numStages; ++s)
+            {
+                const __m128 y = _mm_add_ps (_mm_mul_ps (c[s][0], x), z1[s]);
+                z1[s] = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (c[s][1], x), _mm_mul_ps (c[s][3], y)), z2[s]);
+                z2[s] = _mm_sub_ps (_mm_mul_ps (c[s][2], x), _mm_mul_ps (c[s][4], y));
+                x = y;
+
+                if (deltas != nullptr)
+                    for (int k = 0; k < 5; ++k)
+                        c[s][k] = _mm_add_ps (c[s][k], d[s][k]);
+            }
+
+            _mm_storeu_ps (out, x);
+            left[i] = out[0];
+            right[i] = out[1];
+        }
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            _mm_storeu_ps (out, z1[s]);
+            state[s][0][0] = out[0];
+            state[s][1][0] = out[1];
+
+            _mm_storeu_ps (out, z2[s]);
+            state[s][0][1] = out[0];
+            state[s][1][1] = out[1];
+        }
+    }
+   #else
+    void processStereoBiquads (float* left, float* right, int numSamples, int numStages,
+                               const StereoBiquadCoefficients* coeffs, const StereoBiquadCoefficients* deltas,
+                               StereoBiquadState* state) noexcept
+    {
+        float c[StereoBiquadCascade::maxNumStages][5];
+        memcpy (c, coeffs, sizeof (float) * 5 * (size_t) numStages);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float xL = left[i], xR = right[i];
+
+            for (int s = 0; s < numStages; ++s)
+            {
+                const float yL = c[s][0] * xL + state[s][0][0];
+                const float yR = c[s][0] * xR + state[s][1][0];
+                state[s][0][0] = c[s][1] * xL - c[s][3] * yL + state[s][0][1];
+                state[s][1][0] = c[s][1] * xR - c[s][3] * yR + state[s][1][1];
+                state[s][0][1] = c[s][2] * xL - c[s][4] * yL;
+                state[s][1][1] = c[s][2] * xR - c[s][4] * yR;
+                xL = yL;
+                xR = yR;
+
+                if (deltas != nullptr)
+                    for (int k = 0; k < 5; ++k)
+                        c[s][k] += deltas[s][k];
+            }
+
+            left[i] = xL;
+            right[i] = xR;
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+StereoBiquadCascade::StereoBiquadCascade (int numStages_)
+    : numStages (jlimit (1, (int) maxNumStages, numStages_)),
+      isRamping (false)
+{
+    jassert (numStages_ > 0 && numStages_ <= maxNumStages);
+
+    for (int s = 0; s < maxNumStages; ++s)
+    {
+        coefficients[s][0] = 1.0f;
+
+        for (int k = 1; k < 5; ++k)
+            coefficients[s][k] = 0.0f;
+    }
+
+    memcpy (targetCoefficients, coefficients, sizeof (targetCoefficients));
+    reset();
+}
+
+StereoBiquadCascade::~StereoBiquadCascade()
+{
+}
+
+//==============================================================================
+void StereoBiquadCascade::setCoefficients (int stageIndex, const IIRCoefficients& newCoefficients) noexcept
+{
+    jassert (isPositiveAndBelow (stageIndex, numStages));
+
+    if (isPositiveAndBelow (stageIndex, numStages))
+    {
+        memcpy (targetCoefficients[stageIndex], newCoefficients.coefficients, sizeof (targetCoefficients[stageIndex]));
+        isRamping = true;
+    }
+}
+
+void StereoBiquadCascade::snapToTargetCoefficients() noexcept
+{
+    memcpy (coefficients, targetCoefficients, sizeof (coefficients));
+    isRamping = false;
+}
+
+void StereoBiquadCascade::reset() noexcept
+{
+    zeromem (state, sizeof (state));
+}
+
+//==============================================================================
+void StereoBiquadCascade::processSamples (float* left, float* right, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    // a mono signal runs identically through both lanes
+    if (right == nullptr)
+        right = left;
+
+    if (isRamping)
+    {
+        float deltas[maxNumStages][5];
+        const float oneOverNumSamples = 1.0f / numSamples;
+
+        for (int s = 0; s < numStages; ++s)
+            for (int k = 0; k < 5; ++k)
+                deltas[s][k] = (targetCoefficients[s][k] - coefficients[s][k]) * oneOverNumSamples;
+
+        processStereoBiquads (left, right, numSamples, numStages, coefficients, deltas, state);
+
+        memcpy (coefficients, targetCoefficients, sizeof (coefficients));
+        isRamping = false;
+    }
+    else
+    {
+        processStereoBiquads (left, right, numSamples, numStages, coefficients, nullptr, state);
+    }
+
+    // avoid denormals when the input goes silent
+    for (int s = 0; s < numStages; ++s)
+        for (int c = 0; c < 2; ++c)
+            for (int k = 0; k < 2; ++k)
+                if (! (state[s][c][k] < -1.0e-8f || state[s][c][k] > 1.0e-8f))
+                    state[s][c][k] = 0.0f;
+}
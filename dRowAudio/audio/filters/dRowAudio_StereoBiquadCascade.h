@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_STEREOBIQUADCASCADE_H__
+#define __DROWAUDIO_STEREOBIQUADCASCADE_H__
+
+//==============================================================================
+/** A chain of biquad filters that processes a pair of channels in one pass.
+
+    Both channels are run through every stage of the cascade sample by sample,
+    using SIMD lanes for the left and right channels where the platform has them.
+    This avoids the separate pass over the buffer, and the lock, that an
+    IIRFilter per stage per channel needs.
+
+    New coefficients are not applied straight away, instead they are ramped to
+    linearly over the next call to processSamples(). Call this with small blocks
+    whilst the coefficients are changing to get smooth parameter changes.
+
+    This isn't thread safe so set the coefficients from the same thread that
+    processes the samples.
+ */
+class StereoBiquadCascade
+{
+public:
+    //==============================================================================
+    enum
+    {
+        maxNumStages = 8
+    };
+
+    //==============================================================================
+    /** Creates a cascade with a number of stages.
+        The stages will all initially pass the signal straight through.
+     */
+    StereoBiquadCascade (int numStages);
+
+    /** Destructor. */
+    ~StereoBiquadCascade();
+
+    /** Returns the number of stages in the cascade. */
+    int getNumStages() const noexcept                   {   return numStages;   }
+
+    //==============================================================================
+    /** Sets the coefficients for one of the stages.
+        These will be ramped to over the next call to processSamples().
+     */
+    void setCoefficients (int stageIndex, const IIRCoefficients& newCoefficients) noexcept;
+
+    /** Jumps straight to any coefficients that have been set rather than ramping. */
+    void snapToTargetCoefficients() noexcept;
+
+    /** Clears the state of the filters. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Filters a pair of channels in place.
+        If the right channel is nullptr the left one is processed as a mono signal.
+     */
+    void processSamples (float* left, float* right, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    const int numStages;
+    float coefficients[maxNumStages][5], targetCoefficients[maxNumStages][5];
+    float state[maxNumStages][2][2];
+    bool isRamping;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StereoBiquadCascade);
+};
+
+#endif // __DROWAUDIO_STEREOBIQUADCASCADE_H__
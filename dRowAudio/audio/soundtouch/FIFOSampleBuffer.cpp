@@ -7,7 +7,8 @@
 /// function, and are received from the beginning of the buffer by calling
 /// the 'receiveSamples' function. The class automatically removes the 
 /// outputted samples from the buffer, as well as grows the buffer size 
-/// whenever necessary.
+/// whenever necessary. The samples are held in a mirrored circular buffer
+/// so no data has to be moved when samples are removed.
 ///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
@@ -82,20 +83,50 @@ void FIFOSampleBuffer::setChannels(int numChannels)
 
     assert(numChannels > 0);
     usedBytes = channels * samplesInBuffer;
+
+    // the circular layout depends on the channel count so move the buffered data
+    // back to the start of the buffer before re-interpreting it
+    if (buffer && bufferPos && usedBytes)
+    {
+        memmove(buffer, ptrBegin(), sizeof(SAMPLETYPE) * usedBytes);
+    }
+    bufferPos = 0;
+
     channels = (uint)numChannels;
     samplesInBuffer = usedBytes / channels;
+
+    ensureCapacity(samplesInBuffer);
+    if (samplesInBuffer)
+    {
+        memcpy(buffer + getCapacity() * channels, buffer, sizeof(SAMPLETYPE) * channels * samplesInBuffer);
+    }
 }
 
 
-// if output location pointer 'bufferPos' isn't zero, 'rewinds' the buffer and
-// zeroes this pointer by copying samples from the 'bufferPos' pointer 
-// location on to the beginning of the buffer.
-void FIFOSampleBuffer::rewind()
+// Copies the 'numSamples' samples that follow the currently buffered data into the
+// other copy of the circular buffer so that both copies stay identical. The region
+// may straddle the boundary between the two copies, in which case the part in the
+// first copy is mirrored forwards and the part in the second copy backwards.
+void FIFOSampleBuffer::mirrorSamples(uint nSamples)
 {
-    if (buffer && bufferPos) 
+    const uint capacity = getCapacity();
+    const uint start = bufferPos + samplesInBuffer;
+    const uint end = start + nSamples;
+
+    assert(end <= 2 * capacity);
+
+    if (start < capacity)
     {
-        memmove(buffer, ptrBegin(), sizeof(SAMPLETYPE) * channels * samplesInBuffer);
-        bufferPos = 0;
+        const uint numToCopy = ((end < capacity) ? end : capacity) - start;
+        memcpy(buffer + (start + capacity) * channels, buffer + start * channels,
+               sizeof(SAMPLETYPE) * channels * numToCopy);
+    }
+
+    if (end > capacity)
+    {
+        const uint firstUpper = (start > capacity) ? start : capacity;
+        memcpy(buffer + (firstUpper - capacity) * channels, buffer + firstUpper * channels,
+               sizeof(SAMPLETYPE) * channels * (end - firstUpper));
     }
 }
 
@@ -105,6 +136,7 @@ void FIFOSampleBuffer::rewind()
 void FIFOSampleBuffer::putSamples(const SAMPLETYPE *samples, uint nSamples)
 {
     memcpy(ptrEnd(nSamples), samples, sizeof(SAMPLETYPE) * nSamples * channels);
+    mirrorSamples(nSamples);
     samplesInBuffer += nSamples;
 }
 
@@ -121,6 +153,7 @@ void FIFOSampleBuffer::putSamples(uint nSamples)
 
     req = samplesInBuffer + nSamples;
     ensureCapacity(req);
+    mirrorSamples(nSamples);
     samplesInBuffer += nSamples;
 }
 
@@ -134,13 +167,16 @@ void FIFOSampleBuffer::putSamples(uint nSamples)
 // succesfully insert all the required samples to the buffer. When necessary, 
 // the function grows the buffer size to comply with this requirement.
 //
+// Because the circular buffer is stored twice, the returned region is always
+// contiguous, even if it wraps around the end of the circular buffer.
+//
 // When using this function as means for inserting new samples, also remember 
 // to increase the sample count afterwards, by calling  the 
 // 'putSamples(numSamples)' function.
 SAMPLETYPE *FIFOSampleBuffer::ptrEnd(uint slackCapacity) 
 {
     ensureCapacity(samplesInBuffer + slackCapacity);
-    return buffer + samplesInBuffer * channels;
+    return buffer + (bufferPos + samplesInBuffer) * channels;
 }
 
 
@@ -162,6 +198,8 @@ SAMPLETYPE *FIFOSampleBuffer::ptrBegin()
 // 'capacityRequirement' number of samples. The buffer is grown in steps of
 // 4 kilobytes to eliminate the need for frequently growing up the buffer,
 // as well as to round the buffer size up to the virtual memory page size.
+// As the data never needs to be moved within the buffer, nothing happens
+// if the capacity is already large enough.
 void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
 {
     SAMPLETYPE *tempUnaligned, *temp;
@@ -169,9 +207,9 @@ void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
     if (capacityRequirement > getCapacity()) 
     {
         // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
-        sizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
-        assert(sizeInBytes % 2 == 0);
-        tempUnaligned = new SAMPLETYPE[sizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
+        const uint newSizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
+        assert(newSizeInBytes % 2 == 0);
+        tempUnaligned = new SAMPLETYPE[2 * newSizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
         if (tempUnaligned == NULL)
         {
             ST_THROW_RT_ERROR("Couldn't allocate memory!\n");
@@ -180,18 +218,17 @@ void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
         temp = (SAMPLETYPE *)(((ulong)tempUnaligned + 15) & (ulong)-16);
         if (samplesInBuffer)
         {
+            // copy the buffered data to the start of both copies of the new buffer
+            const uint newCapacity = newSizeInBytes / (channels * sizeof(SAMPLETYPE));
             memcpy(temp, ptrBegin(), samplesInBuffer * channels * sizeof(SAMPLETYPE));
+            memcpy(temp + newCapacity * channels, temp, samplesInBuffer * channels * sizeof(SAMPLETYPE));
         }
         delete[] bufferUnaligned;
         buffer = temp;
         bufferUnaligned = tempUnaligned;
+        sizeInBytes = newSizeInBytes;
         bufferPos = 0;
     } 
-    else 
-    {
-        // simply rewind the buffer (if necessary)
-        rewind();
-    }
 }
 
 
@@ -236,12 +273,20 @@ uint FIFOSampleBuffer::receiveSamples(uint maxSamples)
 
         temp = samplesInBuffer;
         samplesInBuffer = 0;
+        bufferPos = 0;
         return temp;
     }
 
     samplesInBuffer -= maxSamples;
     bufferPos += maxSamples;
 
+    // both copies of the buffer hold the same data so simply wrap the read position
+    const uint capacity = getCapacity();
+    if (bufferPos >= capacity)
+    {
+        bufferPos -= capacity;
+    }
+
     return maxSamples;
 }
 
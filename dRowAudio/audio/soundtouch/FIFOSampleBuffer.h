@@ -52,21 +52,27 @@ namespace soundtouch
 {
 
 /// Sample buffer working in FIFO (first-in-first-out) principle. The class takes
-/// care of storage size adjustment and data moving during input/output operations.
+/// care of storage size adjustment during input/output operations.
+///
+/// The samples are held in a circular buffer that is stored twice, back to back,
+/// so that the readable region always appears contiguous from 'ptrBegin' and the
+/// writable region always appears contiguous from 'ptrEnd'. This means no data
+/// has to be moved as samples are removed and once the buffer has grown to the
+/// largest size requested no further allocations take place.
 ///
 /// Notice that in case of stereo audio, one sample is considered to consist of 
 /// both channel data.
 class FIFOSampleBuffer : public FIFOSamplePipe
 {
 private:
-    /// Sample buffer.
+    /// Sample buffer. This holds two consecutive copies of the circular buffer.
     SAMPLETYPE *buffer;
 
     // Raw unaligned buffer memory. 'buffer' is made aligned by pointing it to first
     // 16-byte aligned location of this buffer
     SAMPLETYPE *bufferUnaligned;
 
-    /// Sample buffer size in bytes
+    /// Size in bytes of one copy of the circular buffer.
     uint sizeInBytes;
 
     /// How many samples are currently in buffer.
@@ -75,14 +81,13 @@ private:
     /// Channels, 1=mono, 2=stereo.
     uint channels;
 
-    /// Current position pointer to the buffer. This pointer is increased when samples are 
-    /// removed from the pipe so that it's necessary to actually rewind buffer (move data)
-    /// only new data when is put to the pipe.
+    /// Current read position in the circular buffer. This is always less than the
+    /// capacity and is increased (wrapping around) as samples are removed from the pipe.
     uint bufferPos;
 
-    /// Rewind the buffer by moving data from position pointed by 'bufferPos' to real 
-    /// beginning of the buffer.
-    void rewind();
+    /// Copies 'numSamples' samples, written directly after the current end of the
+    /// buffered data, to their mirrored location in the other copy of the buffer.
+    void mirrorSamples(uint numSamples);
 
     /// Ensures that the buffer has capacity for at least this many samples.
     void ensureCapacity(uint capacityRequirement);
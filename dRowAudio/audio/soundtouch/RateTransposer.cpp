@@ -44,6 +44,7 @@
 #include <stdio.h>
 #include "RateTransposer.h"
 #include "AAFilter.h"
+#include "SincInterpolator.h"
 
 using namespace soundtouch;
 
@@ -126,11 +127,15 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
 {
     numChannels = 2;
     bUseAAFilter = TRUE;
+    bUseSincInterpolation = FALSE;
+    sincPosition = 0;
     fRate = 0;
 
     // Instantiates the anti-alias filter with default tap length
     // of 32
     pAAFilter = new AAFilter(32);
+
+    pSincInterpolator = SincInterpolator::newInstance();
 }
 
 
@@ -138,6 +143,7 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
 RateTransposer::~RateTransposer()
 {
     delete pAAFilter;
+    delete pSincInterpolator;
 }
 
 
@@ -162,16 +168,70 @@ AAFilter *RateTransposer::getAAFilter()
 }
 
 
+SincInterpolator *RateTransposer::getSincInterpolator()
+{
+    return pSincInterpolator;
+}
+
+
+/// Enables/disables the windowed-sinc interpolator. As the interpolator keeps
+/// different data in 'storeBuffer' to the linear transposer, the buffered
+/// samples are discarded when the mode changes.
+void RateTransposer::enableSincInterpolation(bool newMode)
+{
+    if (newMode == bUseSincInterpolation) return;
+
+    bUseSincInterpolation = newMode;
+
+    storeBuffer.clear();
+    tempBuffer.clear();
+    sincPosition = 0;
+    resetRegisters();
+
+    if (bUseSincInterpolation)
+    {
+        pSincInterpolator->setRate(fRate);
+    }
+    else if (fRate > 0)
+    {
+        // the anti-alias filter isn't kept up to date whilst it's not being used
+        setAAFilterCutoff(fRate);
+    }
+}
+
+
+/// Returns nonzero if the windowed-sinc interpolator is enabled.
+bool RateTransposer::isSincInterpolationEnabled() const
+{
+    return bUseSincInterpolation;
+}
+
+
 
 // Sets new target iRate. Normal iRate = 1.0, smaller values represent slower 
 // iRate, larger faster iRates.
 void RateTransposer::setRate(float newRate)
 {
-    double fCutoff;
-
     fRate = newRate;
 
-    // design a new anti-alias filter
+    // the windowed-sinc interpolator replaces the anti-alias filter so there's
+    // no need to design a new one
+    if (bUseSincInterpolation)
+    {
+        pSincInterpolator->setRate(newRate);
+    }
+    else
+    {
+        setAAFilterCutoff(newRate);
+    }
+}
+
+
+// Designs a new anti-alias filter for the given rate
+void RateTransposer::setAAFilterCutoff(float newRate)
+{
+    double fCutoff;
+
     if (newRate > 1.0f) 
     {
         fCutoff = 0.5f / newRate;
@@ -272,6 +332,27 @@ void RateTransposer::downsample(const SAMPLETYPE *src, uint nSamples)
 }
 
 
+// Transposes the sample rate with the band-limited windowed-sinc interpolator.
+// The interpolator needs a window of input samples around each output position
+// so the input is collected in 'storeBuffer' and only the samples that have
+// passed out of the window are removed.
+void RateTransposer::sincTranspose(const SAMPLETYPE *src, uint nSamples)
+{
+    uint count, sizeReq, numUsed;
+
+    storeBuffer.putSamples(src, nSamples);
+
+    // (+16 is to reserve some slack in the destination buffer)
+    sizeReq = (uint)((float)storeBuffer.numSamples() / fRate + 16.0f);
+    count = pSincInterpolator->evaluate(outputBuffer.ptrEnd(sizeReq), 
+        storeBuffer.ptrBegin(), storeBuffer.numSamples(), (uint)numChannels, 
+        fRate, sincPosition, numUsed);
+    outputBuffer.putSamples(count);
+
+    storeBuffer.receiveSamples(numUsed);
+}
+
+
 // Transposes sample rate by applying anti-alias filter to prevent folding. 
 // Returns amount of samples returned in the "dest" buffer.
 // The maximum amount of samples that can be returned at a time is set by
@@ -284,6 +365,14 @@ void RateTransposer::processSamples(const SAMPLETYPE *src, uint nSamples)
     if (nSamples == 0) return;
     assert(pAAFilter);
 
+    // The windowed-sinc interpolator is band-limited by itself so it replaces
+    // both the linear interpolation and the anti-alias filter
+    if (bUseSincInterpolation)
+    {
+        sincTranspose(src, nSamples);
+        return;
+    }
+
     // If anti-alias filter is turned off, simply transpose without applying
     // the filter
     if (bUseAAFilter == FALSE) 
@@ -344,6 +433,7 @@ void RateTransposer::clear()
 {
     outputBuffer.clear();
     storeBuffer.clear();
+    sincPosition = 0;
 }
 
 
@@ -47,6 +47,7 @@
 
 #include <stddef.h>
 #include "AAFilter.h"
+#include "SincInterpolator.h"
 #include "FIFOSamplePipe.h"
 #include "FIFOSampleBuffer.h"
 
@@ -57,6 +58,10 @@ namespace soundtouch
 
 /// A common linear samplerate transposer class.
 ///
+/// Optionally the linear interpolation and anti-alias filter can be replaced
+/// by a band-limited polyphase windowed-sinc interpolator, see
+/// 'enableSincInterpolation'.
+///
 /// Note: Use function "RateTransposer::newInstance()" to create a new class 
 /// instance instead of the "new" operator; that function automatically 
 /// chooses a correct implementation depending on if integer or floating 
@@ -67,6 +72,12 @@ protected:
     /// Anti-alias filter object
     AAFilter *pAAFilter;
 
+    /// Windowed-sinc interpolator object
+    SincInterpolator *pSincInterpolator;
+
+    /// Fractional read position of the sinc interpolator in 'storeBuffer'
+    double sincPosition;
+
     float fRate;
 
     int numChannels;
@@ -83,6 +94,8 @@ protected:
 
     bool bUseAAFilter;
 
+    bool bUseSincInterpolation;
+
     virtual void resetRegisters() = 0;
 
     virtual uint transposeStereo(SAMPLETYPE *dest, 
@@ -99,6 +112,9 @@ protected:
                     uint numSamples);
     void upsample(const SAMPLETYPE *src, 
                  uint numSamples);
+    void sincTranspose(const SAMPLETYPE *src, 
+                       uint numSamples);
+    void setAAFilterCutoff(float newRate);
 
     /// Transposes sample rate by applying anti-alias filter to prevent folding. 
     /// Returns amount of samples returned in the "dest" buffer.
@@ -136,6 +152,16 @@ public:
     /// Returns nonzero if anti-alias filter is enabled.
     bool isAAFilterEnabled() const;
 
+    /// Return windowed-sinc interpolator object
+    SincInterpolator *getSincInterpolator();
+
+    /// Enables/disables the windowed-sinc interpolator. When enabled this replaces
+    /// both the linear interpolation and the anti-alias filter.
+    void enableSincInterpolation(bool newMode);
+
+    /// Returns nonzero if the windowed-sinc interpolator is enabled.
+    bool isSincInterpolationEnabled() const;
+
     /// Sets new target rate. Normal rate = 1.0, smaller values represent slower 
     /// rate, larger faster rates.
     virtual void setRate(float newRate);
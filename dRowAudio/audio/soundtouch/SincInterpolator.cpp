@@ -0,0 +1,434 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Polyphase windowed-sinc interpolator for band-limited sample rate
+/// transposing.
+///
+/// The interpolator keeps a table of Kaiser windowed sinc kernels for a fixed
+/// number of fractional phases. Output samples are calculated by linearly
+/// blending the two nearest phase kernels and convolving the result with the
+/// input. The kernel cut-off tracks the transposing rate so the interpolator
+/// also acts as the anti-alias filter when the rate is increased. The kernel is
+/// lengthened by the same factor as the cut-off is lowered, which keeps the
+/// transition band in proportion and the cost per input sample constant.
+///
+/// SSE optimized routines reside in 'sse_optimized.cpp'.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory.h>
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include "SincInterpolator.h"
+#include "cpu_detect.h"
+
+using namespace soundtouch;
+
+#ifndef PI
+ #define PI        3.141592655357989
+#endif
+
+/// Number of fractional phases in the kernel table. Intermediate phases are
+/// linearly interpolated so this can be kept small enough to stay in cache.
+#define SINC_NUM_PHASES     128
+
+/// Fraction of the nyquist frequency that is passed. Leaving some room for the
+/// transition band keeps the aliasing of the short kernels low.
+#define SINC_ROLLOFF        0.9
+
+/// Kaiser window shape parameter, ~80 dB side lobe attenuation
+#define SINC_KAISER_BETA    8.0
+
+/// Default number of kernel taps
+#define SINC_DEFAULT_LENGTH 16
+
+/// Maximum number of kernel taps, including the lengthening for rates above 1.0
+#define SINC_MAX_LENGTH     128
+
+/// Number of cut-off tables per octave of rate above 1.0
+#define SINC_TABLES_PER_OCTAVE  4
+
+
+// Zeroth order modified Bessel function of the first kind, used for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = 0.5 * x;
+
+    for (int k = 1; k < 32; k ++)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+
+        if (term < sum * 1e-12) break;
+    }
+
+    return sum;
+}
+
+
+/*****************************************************************************
+ *
+ * Implementation of the class 'SincInterpolator'
+ *
+ *****************************************************************************/
+
+SincInterpolator::SincInterpolator()
+{
+    baseLength = 0;
+    length = 0;
+    tapOffset = 0;
+    numPhases = SINC_NUM_PHASES;
+    currentRate = 1.0;
+    cutoffTables = NULL;
+
+    // Align the table to begin at 16byte cache line boundary for optimal performance
+    coeffsUnaligned = new float[(numPhases + 1) * SINC_MAX_LENGTH + 16 / sizeof(float)];
+    coeffs = (float *)(((ulong)coeffsUnaligned + 15) & (ulong)-16);
+}
+
+
+SincInterpolator::~SincInterpolator()
+{
+    delete[] coeffsUnaligned;
+    delete[] cutoffTables;
+    coeffsUnaligned = NULL;
+    cutoffTables = NULL;
+    coeffs = NULL;
+}
+
+
+// Sets the transposing rate. When the rate is above 1.0 the input is effectively
+// decimated, so the kernels of the cut-off tables either side of the rate are
+// blended together to lower the cut-off. The longer of the two tables' lengths is
+// used, the shorter one being padded with zeros either side.
+void SincInterpolator::setRate(double rate)
+{
+    double tablePosition;
+    uint tableIndex, phase, i, padding;
+    float proportion, a;
+    const float *rowA, *rowB;
+    float *row;
+
+    assert(rate > 0);
+    if (rate == currentRate) return;
+    currentRate = rate;
+
+    tablePosition = 0;
+    if (rate > 1.0)
+    {
+        tablePosition = log(rate) * (SINC_TABLES_PER_OCTAVE / log(2.0));
+        if (tablePosition > SINC_NUM_CUTOFF_TABLES - 1) tablePosition = SINC_NUM_CUTOFF_TABLES - 1;
+    }
+
+    tableIndex = (uint)tablePosition;
+    if (tableIndex > SINC_NUM_CUTOFF_TABLES - 2) tableIndex = SINC_NUM_CUTOFF_TABLES - 2;
+    proportion = (float)(tablePosition - tableIndex);
+
+    if (proportion == 0)
+    {
+        length = cutoffTableLengths[tableIndex];
+        memcpy(coeffs, cutoffTables + cutoffTableOffsets[tableIndex], 
+               (numPhases + 1) * length * sizeof(float));
+    }
+    else
+    {
+        const uint lengthA = cutoffTableLengths[tableIndex];
+
+        length = cutoffTableLengths[tableIndex + 1];
+        padding = (length - lengthA) / 2;
+
+        for (phase = 0; phase <= numPhases; phase ++)
+        {
+            rowA = cutoffTables + cutoffTableOffsets[tableIndex] + phase * lengthA;
+            rowB = cutoffTables + cutoffTableOffsets[tableIndex + 1] + phase * length;
+            row = coeffs + phase * length;
+
+            for (i = 0; i < length; i ++)
+            {
+                a = (i >= padding && i < padding + lengthA) ? rowA[i - padding] : 0.0f;
+                row[i] = a + proportion * (rowB[i] - a);
+            }
+        }
+    }
+
+    tapOffset = (SINC_MAX_LENGTH - length) / 2;
+}
+
+
+// Sets number of kernel taps used at rates up to 1.0 and builds the kernel table
+// for each cut-off. The table for a cut-off 'n' times lower is lengthened by the
+// same factor, to the nearest multiple of 8, so the transition band narrows with
+// the pass band; as there are correspondingly fewer output samples the cost per
+// input sample stays about the same.
+void SincInterpolator::setLength(uint newLength)
+{
+    uint i, tableLength, totalSize;
+    double rate;
+
+    assert(newLength >= 8 && newLength <= SINC_MAX_LENGTH);
+    assert(newLength % 8 == 0);
+
+    if (newLength == baseLength) return;
+
+    baseLength = newLength;
+    totalSize = 0;
+
+    for (i = 0; i < SINC_NUM_CUTOFF_TABLES; i ++)
+    {
+        tableLength = ((uint)(baseLength * pow(2.0, (double)i / SINC_TABLES_PER_OCTAVE) + 4.0)) & ~7u;
+        if (tableLength > SINC_MAX_LENGTH) tableLength = SINC_MAX_LENGTH;
+
+        cutoffTableLengths[i] = tableLength;
+        cutoffTableOffsets[i] = totalSize;
+        totalSize += (numPhases + 1) * tableLength;
+    }
+
+    delete[] cutoffTables;
+    cutoffTables = new float[totalSize];
+
+    for (i = 0; i < SINC_NUM_CUTOFF_TABLES; i ++)
+    {
+        calculateCoeffs(i);
+    }
+
+    // blend the new tables for the current rate
+    rate = currentRate;
+    currentRate = 0;
+    setRate(rate);
+}
+
+
+uint SincInterpolator::getLength() const
+{
+    return baseLength;
+}
+
+
+// Calculates the Kaiser windowed sinc kernel of one of the cut-off tables for each
+// of the fractional phases.
+// For phase 'p' tap 'i' is weighted by its distance from the interpolated point,
+// which lies 'length / 2 - 1 + p / numPhases' samples after the first tap. Each
+// kernel is normalised to unity gain at DC so the interpolation doesn't modulate
+// the signal level.
+void SincInterpolator::calculateCoeffs(uint tableIndex)
+{
+    uint phase, i, tableLength;
+    double halfLength, fraction, x, t, h, w, sum;
+    double cutoffFreq, fc2, wc, windowNorm;
+    float *row;
+
+    tableLength = cutoffTableLengths[tableIndex];
+    cutoffFreq = 0.5 * SINC_ROLLOFF / pow(2.0, (double)tableIndex / SINC_TABLES_PER_OCTAVE);
+
+    halfLength = (double)(tableLength / 2);
+    fc2 = 2.0 * cutoffFreq;
+    wc = PI * fc2;
+    windowNorm = 1.0 / besselI0(SINC_KAISER_BETA);
+
+    for (phase = 0; phase <= numPhases; phase ++)
+    {
+        fraction = (double)phase / (double)numPhases;
+        row = cutoffTables + cutoffTableOffsets[tableIndex] + phase * tableLength;
+        sum = 0;
+
+        for (i = 0; i < tableLength; i ++)
+        {
+            x = (double)i - (halfLength - 1.0) - fraction;
+
+            t = x * wc;
+            if (t != 0)
+            {
+                h = fc2 * sin(t) / t;                           // sinc function
+            }
+            else
+            {
+                h = fc2;
+            }
+
+            t = x / halfLength;
+            t = (t * t < 1.0) ? (1.0 - t * t) : 0.0;
+            w = besselI0(SINC_KAISER_BETA * sqrt(t)) * windowNorm;    // kaiser window
+
+            row[i] = (float)(h * w);
+            sum += h * w;
+        }
+
+        assert(sum > 0);
+
+        for (i = 0; i < tableLength; i ++)
+        {
+            row[i] = (float)(row[i] / sum);
+        }
+    }
+}
+
+
+// Converts an accumulated result back to the sample type
+static inline SAMPLETYPE toSample(float value)
+{
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    if (value > 32767.0f) return 32767;
+    if (value < -32768.0f) return -32768;
+    return (SAMPLETYPE)(value + ((value >= 0) ? 0.5f : -0.5f));
+#else
+    return value;
+#endif
+}
+
+
+uint SincInterpolator::evaluateStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, double rate, double &position) const
+{
+    uint i, j, srcPos, phaseIndex;
+    double phase;
+    float frac, c, suml, sumr;
+    const float *pC0, *pC1;
+    const SAMPLETYPE *pSrc;
+
+    for (i = 0; ; i ++)
+    {
+        srcPos = (uint)position;
+        if (srcPos + tapOffset + length > numSamples) break;
+
+        phase = (position - srcPos) * numPhases;
+        phaseIndex = (uint)phase;
+        frac = (float)(phase - phaseIndex);
+
+        pC0 = coeffs + phaseIndex * length;
+        pC1 = pC0 + length;
+        pSrc = src + 2 * (srcPos + tapOffset);
+
+        suml = sumr = 0;
+        for (j = 0; j < length; j ++)
+        {
+            c = pC0[j] + frac * (pC1[j] - pC0[j]);
+            suml += c * (float)pSrc[2 * j];
+            sumr += c * (float)pSrc[2 * j + 1];
+        }
+
+        dest[2 * i] = toSample(suml);
+        dest[2 * i + 1] = toSample(sumr);
+
+        position += rate;
+    }
+
+    return i;
+}
+
+
+uint SincInterpolator::evaluateMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, double rate, double &position) const
+{
+    uint i, j, srcPos, phaseIndex;
+    double phase;
+    float frac, sum;
+    const float *pC0, *pC1;
+    const SAMPLETYPE *pSrc;
+
+    for (i = 0; ; i ++)
+    {
+        srcPos = (uint)position;
+        if (srcPos + tapOffset + length > numSamples) break;
+
+        phase = (position - srcPos) * numPhases;
+        phaseIndex = (uint)phase;
+        frac = (float)(phase - phaseIndex);
+
+        pC0 = coeffs + phaseIndex * length;
+        pC1 = pC0 + length;
+        pSrc = src + srcPos + tapOffset;
+
+        sum = 0;
+        for (j = 0; j < length; j ++)
+        {
+            sum += (pC0[j] + frac * (pC1[j] - pC0[j])) * (float)pSrc[j];
+        }
+
+        dest[i] = toSample(sum);
+
+        position += rate;
+    }
+
+    return i;
+}
+
+
+// Interpolates as many output samples as the input allows. See the header for
+// a description of the 'position' and 'numUsed' book-keeping.
+uint SincInterpolator::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels,
+                                double rate, double &position, uint &numUsed) const
+{
+    uint count;
+
+    assert(numChannels == 1 || numChannels == 2);
+    assert(coeffs != NULL);
+    assert(position >= 0);
+
+    if (numChannels == 2)
+    {
+        count = evaluateStereo(dest, src, numSamples, rate, position);
+    }
+    else
+    {
+        count = evaluateMono(dest, src, numSamples, rate, position);
+    }
+
+    // the samples before the next kernel start are no longer needed
+    numUsed = (uint)position;
+    if (numUsed > numSamples) numUsed = numSamples;
+    position -= numUsed;
+
+    return count;
+}
+
+
+void * SincInterpolator::operator new(size_t /*s*/)
+{
+    // Notice! don't use "new SincInterpolator" directly, use "newInstance" to create a new instance instead!
+    ST_THROW_RT_ERROR("Error in SincInterpolator::new: Don't use 'new SincInterpolator', use 'newInstance' member instead!");
+    return newInstance();
+}
+
+
+SincInterpolator * SincInterpolator::newInstance()
+{
+    SincInterpolator *interpolator;
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (detectCPUextensions() & SUPPORT_SSE)
+    {
+        // SSE support
+        interpolator = ::new SincInterpolatorSSE;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+    {
+        // ISA optimizations not supported, use plain C version
+        interpolator = ::new SincInterpolator;
+    }
+
+    interpolator->setLength(SINC_DEFAULT_LENGTH);
+    return interpolator;
+}
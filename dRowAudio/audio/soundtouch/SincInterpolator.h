@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Polyphase windowed-sinc interpolator for band-limited sample rate
+/// transposing.
+///
+/// The interpolator keeps a table of Kaiser windowed sinc kernels for a fixed
+/// number of fractional phases. Output samples are calculated by linearly
+/// blending the two nearest phase kernels and convolving the result with the
+/// input. The kernel cut-off tracks the transposing rate so the interpolator
+/// also acts as the anti-alias filter when the rate is increased. The kernel is
+/// lengthened by the same factor as the cut-off is lowered, which keeps the
+/// transition band in proportion and the cost per input sample constant.
+///
+/// Kernel tables are built up front for cut-offs a quarter of an octave apart, so
+/// changing the rate only blends the two tables either side of it together.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SincInterpolator_H
+#define SincInterpolator_H
+
+#include <stddef.h>
+#include "STTypes.h"
+
+/// Number of kernel tables, one every quarter of an octave from rate 1.0 up to 16.0.
+/// Above that the cut-off stays at the one for rate 16.0.
+#define SINC_NUM_CUTOFF_TABLES  17
+
+namespace soundtouch
+{
+
+class SincInterpolator
+{
+protected:
+    /// Number of kernel taps used at rates up to 1.0
+    uint baseLength;
+
+    /// Number of kernel taps currently used, i.e. input samples used for each
+    /// output sample. This is 'baseLength' scaled up by the rate when above 1.0.
+    uint length;
+
+    /// Offset of the first kernel tap from the read position. The taps are centred
+    /// in a window of the maximum kernel length so that changing the length with
+    /// the rate doesn't move the interpolated point.
+    uint tapOffset;
+
+    /// Number of fractional phases stored in the kernel table
+    uint numPhases;
+
+    /// The rate the current kernel table was blended for
+    double currentRate;
+
+    /// Kernel table of 'numPhases + 1' rows of 'length' coefficients. Allocated for
+    /// the maximum length so rate changes don't reallocate. Aligned to 16-byte boundary.
+    float *coeffs;
+
+    /// Raw unaligned kernel table memory
+    float *coeffsUnaligned;
+
+    /// Kernel tables for each of the cut-offs, laid out like 'coeffs' one after another
+    float *cutoffTables;
+
+    /// Number of taps and offset into 'cutoffTables' of each of the cut-off tables
+    uint cutoffTableLengths[SINC_NUM_CUTOFF_TABLES];
+    uint cutoffTableOffsets[SINC_NUM_CUTOFF_TABLES];
+
+    /// Calculates the kernel table for one of the cut-offs
+    void calculateCoeffs(uint tableIndex);
+
+    virtual uint evaluateStereo(SAMPLETYPE *dest,
+                                const SAMPLETYPE *src,
+                                uint numSamples,
+                                double rate,
+                                double &position) const;
+    virtual uint evaluateMono(SAMPLETYPE *dest,
+                              const SAMPLETYPE *src,
+                              uint numSamples,
+                              double rate,
+                              double &position) const;
+
+public:
+    SincInterpolator();
+    virtual ~SincInterpolator();
+
+    /// Operator 'new' is overloaded so that it automatically creates a suitable instance
+    /// depending on if we've a SSE-capable CPU available or not.
+    static void * operator new(size_t s);
+
+    /// Use this function instead of "new" operator to create a new instance of this class.
+    /// This function automatically chooses a correct implementation, depending on if the
+    /// CPU supports SSE extensions.
+    static SincInterpolator *newInstance();
+
+    /// Sets the transposing rate. The kernel cut-off frequency is lowered and the kernel
+    /// lengthened for rates above 1.0 so that the output doesn't alias. This only blends
+    /// two of the prebuilt tables so is cheap enough to call whilst processing.
+    void setRate(double rate);
+
+    /// Sets number of kernel taps used at rates up to 1.0, i.e. ~interpolation quality.
+    /// Must be a multiple of 8, in range 8 .. 128. This rebuilds all of the kernel tables
+    /// so is fairly costly.
+    void setLength(uint newLength);
+
+    uint getLength() const;
+
+    /// Interpolates the given sequence of samples at positions 'position',
+    /// 'position + rate', 'position + 2 * rate' etc. for as long as there are enough
+    /// input samples available. The interpolated point lies 63 samples, i.e. half the
+    /// maximum kernel length less one, after 'position' so that there is enough
+    /// history in 'src'.
+    ///
+    /// On return 'numUsed' contains the number of input samples that are no longer
+    /// needed and 'position' is updated to be relative to 'src + numUsed'.
+    ///
+    /// \return Number of samples copied to 'dest'.
+    uint evaluate(SAMPLETYPE *dest,
+                  const SAMPLETYPE *src,
+                  uint numSamples,
+                  uint numChannels,
+                  double rate,
+                  double &position,
+                  uint &numUsed) const;
+};
+
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    /// Class that implements SSE optimized functions exclusive for floating point samples type.
+    class SincInterpolatorSSE : public SincInterpolator
+    {
+    protected:
+        virtual uint evaluateStereo(float *dest, const float *src, uint numSamples, double rate, double &position) const;
+        virtual uint evaluateMono(float *dest, const float *src, uint numSamples, double rate, double &position) const;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+}
+
+#endif  // SincInterpolator_H
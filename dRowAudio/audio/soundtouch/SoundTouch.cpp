@@ -410,6 +410,17 @@ bool SoundTouch::setSetting(int settingId, int value)
             pTDStretch->setParameters(sampleRate, sequenceMs, seekWindowMs, value);
             return TRUE;
 
+        case SETTING_USE_SINC_INTERPOLATION :
+            // enables / disables the windowed-sinc interpolator
+            pRateTransposer->enableSincInterpolation((value != 0) ? TRUE : FALSE);
+            return TRUE;
+
+        case SETTING_SINC_INTERPOLATION_LENGTH :
+            // sets windowed-sinc interpolator length
+            if (value < 8 || value > 128 || (value % 8) != 0) return FALSE;
+            pRateTransposer->getSincInterpolator()->setLength((uint)value);
+            return TRUE;
+
         default :
             return FALSE;
     }
@@ -453,6 +464,12 @@ int SoundTouch::getSetting(int settingId) const
 		case SETTING_NOMINAL_OUTPUT_SEQUENCE :
 			return pTDStretch->getOutputBatchSize();
 
+        case SETTING_USE_SINC_INTERPOLATION :
+            return (uint)pRateTransposer->isSincInterpolationEnabled();
+
+        case SETTING_SINC_INTERPOLATION_LENGTH :
+            return (int)pRateTransposer->getSincInterpolator()->getLength();
+
 		default :
             return 0;
     }
@@ -141,6 +141,20 @@ namespace soundtouch
 ///   tempo/pitch/rate/samplerate settings.
 #define SETTING_NOMINAL_OUTPUT_SEQUENCE		7
 
+/// Enable/disable the polyphase windowed-sinc interpolator in the pitch transposer
+/// (0 = disable, default). When enabled this replaces the linear interpolation and
+/// the anti-alias filter, giving a band-limited result with less aliasing at large
+/// pitch shifts. The kernel is lengthened at rates above 1.0 so its cost per input
+/// sample doesn't depend much on the rate. Measured on stereo input with SSE and the
+/// default 16 taps it costs about the same CPU as the default transposer up to rate
+/// 1.3 (between 7% less and 13% more) and 15-40% less at rates of 1.5 and above.
+#define SETTING_USE_SINC_INTERPOLATION      8
+
+/// Pitch transposer windowed-sinc interpolator length at rates up to 1.0 (8 .. 128
+/// taps in steps of 8, default = 16). Changing this rebuilds the interpolator's
+/// kernel tables which takes a few milliseconds.
+#define SETTING_SINC_INTERPOLATION_LENGTH   9
+
 class SoundTouch : public FIFOProcessor
 {
 private:
@@ -84,6 +84,7 @@
 #include "FIRFilter.h"
 #include "PeakFinder.h"
 #include "RateTransposer.h"
+#include "SincInterpolator.h"
 #include "SoundTouch.h"
 #include "soundtouch_config.h"
 #include "STTypes.h"
@@ -91,4 +92,4 @@
 
 //==============================================================================
 
-#endif //_DROWAUDIO_SOUNDTOUCHINCLUDES__H_
\ No newline at end of file
+#endif //_DROWAUDIO_SOUNDTOUCHINCLUDES__H_
\ No newline at end of file
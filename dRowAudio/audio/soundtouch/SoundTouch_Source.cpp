@@ -86,6 +86,7 @@
 #include "mmx_optimized.cpp"
 #include "PeakFinder.cpp"
 #include "RateTransposer.cpp"
+#include "SincInterpolator.cpp"
 #include "SoundTouch.cpp"
 #include "sse_optimized.cpp"
 #include "TDStretch.cpp"
@@ -425,4 +425,109 @@ uint FIRFilterSSE::evaluateFilterStereo(float *dest, const float *source, uint n
     */
 }
 
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of class 'SincInterpolator'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "SincInterpolator.h"
+
+// SSE-optimized version of the interpolation routine for stereo sound. Each
+// pass blends four taps of the two nearest phase kernels and duplicates them
+// for the interleaved left/right samples.
+uint SincInterpolatorSSE::evaluateStereo(float *dest, const float *src, uint numSamples, double rate, double &position) const
+{
+    uint i, j, srcPos, phaseIndex;
+    double phase;
+
+    assert((length % 8) == 0);
+    assert(((ulong)coeffs) % 16 == 0);
+
+    for (i = 0; ; i ++)
+    {
+        const float *pC0, *pC1, *pSrc;
+        __m128 vFrac, vC, sum1, sum2;
+
+        srcPos = (uint)position;
+        if (srcPos + tapOffset + length > numSamples) break;
+
+        phase = (position - srcPos) * numPhases;
+        phaseIndex = (uint)phase;
+        vFrac = _mm_set1_ps((float)(phase - phaseIndex));
+
+        pC0 = coeffs + phaseIndex * length;     // NOTE: rows are 16-byte aligned as length % 8 == 0
+        pC1 = pC0 + length;
+        pSrc = src + 2 * (srcPos + tapOffset);
+
+        sum1 = sum2 = _mm_setzero_ps();
+        for (j = 0; j < length; j += 4)
+        {
+            vC = _mm_load_ps(pC0 + j);
+            vC = _mm_add_ps(vC, _mm_mul_ps(vFrac, _mm_sub_ps(_mm_load_ps(pC1 + j), vC)));
+
+            // c0 c0 c1 c1 * l0 r0 l1 r1, c2 c2 c3 c3 * l2 r2 l3 r3
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pSrc), _mm_unpacklo_ps(vC, vC)));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pSrc + 4), _mm_unpackhi_ps(vC, vC)));
+
+            pSrc += 8;
+        }
+
+        // sum the hi- and lo-pairs of left/right results together
+        sum1 = _mm_add_ps(sum1, sum2);
+        sum1 = _mm_add_ps(sum1, _mm_movehl_ps(sum1, sum1));
+        _mm_storel_pi((__m64 *)(dest + 2 * i), sum1);
+
+        position += rate;
+    }
+
+    return i;
+}
+
+
+// SSE-optimized version of the interpolation routine for mono sound
+uint SincInterpolatorSSE::evaluateMono(float *dest, const float *src, uint numSamples, double rate, double &position) const
+{
+    uint i, j, srcPos, phaseIndex;
+    double phase;
+
+    assert((length % 8) == 0);
+    assert(((ulong)coeffs) % 16 == 0);
+
+    for (i = 0; ; i ++)
+    {
+        const float *pC0, *pC1, *pSrc;
+        __m128 vFrac, vC, sum;
+
+        srcPos = (uint)position;
+        if (srcPos + tapOffset + length > numSamples) break;
+
+        phase = (position - srcPos) * numPhases;
+        phaseIndex = (uint)phase;
+        vFrac = _mm_set1_ps((float)(phase - phaseIndex));
+
+        pC0 = coeffs + phaseIndex * length;
+        pC1 = pC0 + length;
+        pSrc = src + srcPos + tapOffset;
+
+        sum = _mm_setzero_ps();
+        for (j = 0; j < length; j += 4)
+        {
+            vC = _mm_load_ps(pC0 + j);
+            vC = _mm_add_ps(vC, _mm_mul_ps(vFrac, _mm_sub_ps(_mm_load_ps(pC1 + j), vC)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrc + j), vC));
+        }
+
+        // horizontal sum of the four partial results
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1,1,1,1)));
+        _mm_store_ss(dest + i, sum);
+
+        position += rate;
+    }
+
+    return i;
+}
+
 #endif  // SOUNDTOUCH_ALLOW_SSE
@@ -46,6 +46,11 @@
 
 #include "dRowAudio.h"
 
+#if JUCE_INTEL && (defined (__SSE__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 1))
+ #define DROWAUDIO_USE_SSE 1
+ #include <xmmintrin.h>
+#endif
+
 #if DROWAUDIO_USE_SOUNDTOUCH
  #include "audio/soundtouch/SoundTouch_Source.cpp"
 #endif
@@ -55,6 +60,8 @@ namespace drow {
 // Audio
 #include "audio/dRowAudio_AudioFilePlayer.cpp"
 #include "audio/dRowAudio_AudioFilePlayerExt.cpp"
+#include "audio/dRowAudio_GaplessAudioFilePlayer.cpp"
+#include "audio/dRowAudio_OfflinePlayerRenderer.cpp"
 #include "audio/dRowAudio_AudioSampleBufferAudioFormat.cpp"
 
 #include "audio/dRowAudio_SoundTouchProcessor.cpp"
@@ -63,16 +70,25 @@ namespace drow {
 #include "audio/dRowAudio_FilteringAudioSource.cpp"
 #include "audio/dRowAudio_ReversibleAudioSource.cpp"
 #include "audio/dRowAudio_LoopingAudioSource.cpp"
+#include "audio/dRowAudio_BidirectionalBufferingAudioSource.cpp"
+#include "audio/dRowAudio_PreloadingAudioSource.cpp"
+#include "audio/dRowAudio_DecodedAudioCache.cpp"
+#include "audio/dRowAudio_CueSnippetAudioSource.cpp"
+#include "audio/dRowAudio_ScrubbingAudioSource.cpp"
+#include "audio/dRowAudio_ParallelMixerAudioSource.cpp"
 
 #include "audio/dRowAudio_PitchDetector.cpp"
 
 #include "audio/dRowAudio_AudioUtilityUnitTests.cpp"
 
 #include "audio/dRowAudio_EnvelopeFollower.cpp"
+#include "audio/dRowAudio_MultichannelEnvelopeFollower.cpp"
 #include "audio/dRowAudio_SampleRateConverter.cpp"
+#include "audio/dRowAudio_ResamplingPositionableSource.cpp"
 
 #include "audio/filters/dRowAudio_BiquadFilter.cpp"
 #include "audio/filters/dRowAudio_OnePoleFilter.cpp"
+#include "audio/filters/dRowAudio_StereoBiquadCascade.cpp"
 
 #include "audio/fft/dRowAudio_Window.cpp"
 #include "audio/fft/dRowAudio_FFT.cpp"
@@ -112,6 +128,7 @@ namespace drow {
 // network
 #include "network/dRowAudio_CURLManager.cpp"
 #include "network/dRowAudio_CURLEasySession.cpp"
+#include "network/dRowAudio_CURLStreamingInputStream.cpp"
 
 // streams
 #include "streams/dRowAudio_MemoryInputSource.cpp"
@@ -215,6 +215,10 @@ using juce::UnitTest;
 //using juce::Rectangle;
 
 // Audio
+#ifndef __DROWAUDIO_AUDIOSOURCEWITHLATENCY_H__
+ #include "audio/dRowAudio_AudioSourceWithLatency.h"
+#endif
+
 #ifndef __DROWAUDIO_AUDIOFILEPLAYER_H__
  #include "audio/dRowAudio_AudioFilePlayer.h"
 #endif
@@ -223,6 +227,14 @@ using juce::UnitTest;
  #include "audio/dRowAudio_AudioFilePlayerExt.h"
 #endif
 
+#ifndef __DROWAUDIO_GAPLESSAUDIOFILEPLAYER_H__
+ #include "audio/dRowAudio_GaplessAudioFilePlayer.h"
+#endif
+
+#ifndef __DROWAUDIO_OFFLINEPLAYERRENDERER_H__
+ #include "audio/dRowAudio_OfflinePlayerRenderer.h"
+#endif
+
 #ifndef __DROWAUDIO_AUDIOSAMPLEBUFFERAUDIOFORMAT_H__
  #include "audio/dRowAudio_AudioSampleBufferAudioFormat.h"
 #endif
@@ -247,6 +259,30 @@ using juce::UnitTest;
  #include "audio/dRowAudio_LoopingAudioSource.h"
 #endif
 
+#ifndef __DROWAUDIO_BIDIRECTIONALBUFFERINGAUDIOSOURCE_H__
+ #include "audio/dRowAudio_BidirectionalBufferingAudioSource.h"
+#endif
+
+#ifndef __DROWAUDIO_PRELOADINGAUDIOSOURCE_H__
+ #include "audio/dRowAudio_PreloadingAudioSource.h"
+#endif
+
+#ifndef __DROWAUDIO_DECODEDAUDIOCACHE_H__
+ #include "audio/dRowAudio_DecodedAudioCache.h"
+#endif
+
+#ifndef __DROWAUDIO_CUESNIPPETAUDIOSOURCE_H__
+ #include "audio/dRowAudio_CueSnippetAudioSource.h"
+#endif
+
+#ifndef __DROWAUDIO_SCRUBBINGAUDIOSOURCE_H__
+ #include "audio/dRowAudio_ScrubbingAudioSource.h"
+#endif
+
+#ifndef __DROWAUDIO_PARALLELMIXERAUDIOSOURCE_H__
+ #include "audio/dRowAudio_ParallelMixerAudioSource.h"
+#endif
+
 #ifndef __DROWAUDIO_PITCH_H__
  #include "audio/dRowAudio_Pitch.h"
 #endif
@@ -271,10 +307,18 @@ using juce::UnitTest;
  #include "audio/dRowAudio_EnvelopeFollower.h"
 #endif
 
+#ifndef __DROWAUDIO_MULTICHANNELENVELOPEFOLLOWER_H__
+ #include "audio/dRowAudio_MultichannelEnvelopeFollower.h"
+#endif
+
 #ifndef __DROWAUDIO_SAMPLERATECONVERTER_H__
  #include "audio/dRowAudio_SampleRateConverter.h"
 #endif
 
+#ifndef __DROWAUDIO_RESAMPLINGPOSITIONABLESOURCE_H__
+ #include "audio/dRowAudio_ResamplingPositionableSource.h"
+#endif
+
 #ifndef __DROWAUDIO_BIQUADFILTER_H__
  #include "audio/filters/dRowAudio_BiquadFilter.h"
 #endif
@@ -283,6 +327,10 @@ using juce::UnitTest;
  #include "audio/filters/dRowAudio_OnePoleFilter.h"
 #endif
 
+#ifndef __DROWAUDIO_STEREOBIQUADCASCADE_H__
+ #include "audio/filters/dRowAudio_StereoBiquadCascade.h"
+#endif
+
 #ifndef __DROWAUDIO_WINDOW_H__
  #include "audio/fft/dRowAudio_Window.h"
 #endif
@@ -418,6 +466,10 @@ using juce::UnitTest;
  #include "network/dRowAudio_CURLEasySession.h"
 #endif 
 
+#ifndef __DROWAUDIO_CURLSTREAMINGINPUTSTREAM_H__
+ #include "network/dRowAudio_CURLStreamingInputStream.h"
+#endif
+
 // streams
 #ifndef __DROWAUDIO_STREAMANDFILEHANDLER_H__
  #include "audio/dRowAudio_StreamAndFileHandler.h"
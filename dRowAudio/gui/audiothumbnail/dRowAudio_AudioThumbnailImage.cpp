@@ -176,6 +176,19 @@ void AudioThumbnailImage::refreshFromFilePlayer()
                         sourceLoaded = true;
                     }
                 }
+               #if DROWAUDIO_USE_CURL
+                else if (filePlayer.getInputType() == AudioFilePlayer::urlStream)
+                {
+                    // this reads from the player's download so the file is only fetched once
+                    InputSource* inputSource = filePlayer.getInputSource();
+                    
+                    if (inputSource != nullptr)
+                    {
+                        audioThumbnail.setSource (inputSource);
+                        sourceLoaded = true;
+                    }
+                }
+               #endif
             }
         }
     }
@@ -39,7 +39,8 @@ DraggableWaveDisplay::DraggableWaveDisplay (AudioThumbnailImage& sourceToBeUsed)
       oneOverZoomRatio              (1.0f / zoomRatio),
       playheadPos                   (0.5f),
 	  isDraggable                   (true),
-	  mouseShouldTogglePlay         (true)
+	  mouseShouldTogglePlay         (true),
+      scrubsWhileDragging           (false)
 {
     setOpaque (true);
 
@@ -77,6 +78,11 @@ void DraggableWaveDisplay::setDraggable (bool isWaveformDraggable)
 	isDraggable = isWaveformDraggable;
 }
 
+void DraggableWaveDisplay::setScrubsWhileDragging (bool shouldScrub)
+{
+    scrubsWhileDragging = shouldScrub;
+}
+
 //====================================================================================
 void DraggableWaveDisplay::resized()
 {
@@ -98,7 +104,7 @@ void DraggableWaveDisplay::paint (Graphics &g)
 	    
     const int playHeadXPos = roundToInt (playheadPos * w);
     const double timeToPlayHead = pixelsToTime (playHeadXPos);
-    const double startTime = filePlayer.getAudioTransportSource()->getCurrentPosition() - timeToPlayHead;
+    const double startTime = filePlayer.getCurrentPosition() - timeToPlayHead;
     const double duration = filePlayer.getAudioTransportSource()->getLengthInSeconds();
     const double timeToDisplay = pixelsToTime (w);
 
@@ -125,7 +131,11 @@ void DraggableWaveDisplay::mouseDown (const MouseEvent &e)
 	
 	if (isDraggable)
 	{
-		if (mouseShouldTogglePlay)
+        if (scrubsWhileDragging)
+        {
+            filePlayer.setScrubbing (true);
+        }
+		else if (mouseShouldTogglePlay)
 		{
 			if (filePlayer.getAudioTransportSource()->isPlaying())
 			{
@@ -150,7 +160,11 @@ void DraggableWaveDisplay::mouseUp (const MouseEvent& /*e*/)
 	
 	if (isDraggable)
 	{
-		if (mouseShouldTogglePlay)
+        if (filePlayer.isScrubbing())
+        {
+            filePlayer.setScrubbing (false);
+        }
+		else if (mouseShouldTogglePlay)
 		{
 			if (shouldBePlaying && ! filePlayer.getAudioTransportSource()->isPlaying())
 				filePlayer.getAudioTransportSource()->start();
@@ -169,7 +183,7 @@ void DraggableWaveDisplay::timerCallback (const int timerId)
 {
 	if (timerId == waveformUpdated) //moved due to file position changing
 	{
-		movedX = roundToInt (timeToPixels (filePlayer.getAudioTransportSource()->getCurrentPosition()));
+		movedX = roundToInt (timeToPixels (filePlayer.getCurrentPosition()));
 
 		if (! movedX.areEqual())
 			repaint();
@@ -183,8 +197,12 @@ void DraggableWaveDisplay::timerCallback (const int timerId)
 			
 			if (currentXDrag != 0)
 			{
-				const double position = filePlayer.getAudioTransportSource()->getCurrentPosition() - pixelsToTime (currentXDrag);
-				filePlayer.getAudioTransportSource()->setPosition (position);
+				const double position = filePlayer.getCurrentPosition() - pixelsToTime (currentXDrag);
+
+                if (filePlayer.isScrubbing())
+                    filePlayer.setScrubPosition (position);
+                else
+                    filePlayer.getAudioTransportSource()->setPosition (position);
 
 				repaint();
 			}
@@ -195,7 +213,7 @@ void DraggableWaveDisplay::timerCallback (const int timerId)
         const int w = getWidth();
         const int playHeadXPos = roundToInt (playheadPos * w);
         const double timeToPlayHead = pixelsToTime (playHeadXPos);
-        const double startTime = filePlayer.getAudioTransportSource()->getCurrentPosition() - timeToPlayHead;
+        const double startTime = filePlayer.getCurrentPosition() - timeToPlayHead;
         const double timeToDisplay = pixelsToTime (w);
         
         const double timeAtEnd = startTime + timeToDisplay;
@@ -76,6 +76,18 @@ public:
 	/** Returns true if dragging the waveform will reposition the audio source 
      */
 	bool getDraggable()              {   return isDraggable;   }
+    
+    /** Sets whether dragging the waveform should scrub the audio.
+        When this is on the file player is put into scrubbing mode whilst the waveform
+        is dragged so you hear the audio move with it. When it is off playback is
+        paused during the drag. This is off by default.
+        @see AudioFilePlayer::setScrubbing
+     */
+    void setScrubsWhileDragging (bool shouldScrub);
+    
+    /** Returns true if dragging the waveform will scrub the audio.
+     */
+    bool getScrubsWhileDragging()    {   return scrubsWhileDragging;   }
 	    
     //====================================================================================
 	/** @internal */
@@ -131,7 +143,7 @@ private:
     CriticalSection lock;
     Image playheadImage;
 
-	bool isMouseDown, isDraggable, shouldBePlaying, mouseShouldTogglePlay;
+	bool isMouseDown, isDraggable, shouldBePlaying, mouseShouldTogglePlay, scrubsWhileDragging;
 	StateVariable<int> mouseX, movedX;
     
 	friend class SwitchableDraggableWaveDisplay;
@@ -141,4 +153,4 @@ private:
 };
 
 
-#endif  // __DROWAUDIO_DRAGGABLEWAVEDISPLAY_H__
\ No newline at end of file
+#endif  // __DROWAUDIO_DRAGGABLEWAVEDISPLAY_H__
\ No newline at end of file
@@ -99,7 +99,7 @@ void AudioTransportCursor::timerCallback()
     const int h = getHeight();
 
     const int startPixel = roundToInt (w * startOffsetRatio);
-    transportLineXCoord = startPixel + roundToInt ((w * oneOverFileLength * audioFilePlayer.getCurrentPosition()) / zoomRatio);
+    transportLineXCoord = startPixel + roundToInt ((w * oneOverFileLength * audioFilePlayer.getAudiblePosition()) / zoomRatio);
 
     // if the line has moved repaint the old and new positions of it
     if (! transportLineXCoord.areEqual())
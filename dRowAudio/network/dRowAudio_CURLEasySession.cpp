@@ -41,11 +41,32 @@
 
 namespace drow {
 
+namespace
+{
+    /** Downloads aren't split into segments smaller than this. */
+    const int64 curlSessionMinSegmentSize = 256 * 1024;
+    
+    /** The segment state file is saved each time this much more has been downloaded. */
+    const int64 curlSessionStateSaveInterval = 4 * 1024 * 1024;
+}
+
 //==============================================================================
 CURLEasySession::CURLEasySession()
     : handle      (CURLManager::getInstance()->createEasyCurlHandle()),
 	  remotePath  (String::empty),
-	  progress    (1.0f)
+      isUpload    (false),
+      shouldStopTransfer (false),
+	  progress    (1.0f),
+      numSegments (1),
+      numSegmentsFinished (0),
+      isProbingForSegments (false),
+      isDownloadingSegments (false),
+      serverAcceptsRanges (false),
+      segmentedFileLength (0),
+      numBytesSinceStateSaved (0),
+      parent (nullptr),
+      segmentPosition (0),
+      hasCheckedSegmentResponse (false)
 {
 	enableFullDebugging (true);
 	curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
@@ -56,9 +77,20 @@ CURLEasySession::CURLEasySession (String localPath,
                                   bool upload,
                                   String username,
                                   String password)
-    : handle      (CURLManager::getInstance()->createEasyCurlHandle())
+    : handle      (CURLManager::getInstance()->createEasyCurlHandle (remotePath)),
+      isUpload    (false),
+      shouldStopTransfer (false),
+      numSegments (1),
+      numSegmentsFinished (0),
+      isProbingForSegments (false),
+      isDownloadingSegments (false),
+      serverAcceptsRanges (false),
+      segmentedFileLength (0),
+      numBytesSinceStateSaved (0),
+      parent (nullptr),
+      segmentPosition (0),
+      hasCheckedSegmentResponse (false)
 {
-	handle = CURLManager::getInstance()->createEasyCurlHandle();
 	enableFullDebugging (true);
 	curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
 
@@ -68,12 +100,32 @@ CURLEasySession::CURLEasySession (String localPath,
 	beginTransfer (upload);
 }
 
+CURLEasySession::CURLEasySession (CURLEasySession& parentSession, Range<int64> range)
+    : handle      (CURLManager::getInstance()->createEasyCurlHandle (parentSession.remotePath)),
+      remotePath  (parentSession.remotePath),
+      userNameAndPassword (parentSession.userNameAndPassword),
+      isUpload    (false),
+      shouldStopTransfer (false),
+      progress    (0.0f),
+      numSegments (1),
+      numSegmentsFinished (0),
+      isProbingForSegments (false),
+      isDownloadingSegments (false),
+      serverAcceptsRanges (false),
+      segmentedFileLength (0),
+      numBytesSinceStateSaved (0),
+      parent      (&parentSession),
+      segmentRange (range),
+      segmentPosition (range.getStart()),
+      hasCheckedSegmentResponse (false)
+{
+    priority = parentSession.getPriority();
+}
+
 CURLEasySession::~CURLEasySession()
 {
-	CURLManager::getInstance()->removeTimeSliceClient (this);
-	if (CURLManager::getInstance()->getNumClients() == 0)
-		CURLManager::getInstance()->stopThread (1000);
-	
+	CURLManager::getInstance()->removeSession (this);
+    clearSegments();
 	CURLManager::getInstance()->cleanUpEasyCurlHandle (handle);
 }
 
@@ -180,10 +232,12 @@ void CURLEasySession::beginTransfer (bool transferIsUpload, bool performOnBackgr
 	isUpload = transferIsUpload;
     shouldStopTransfer = false;
     
+    clearSegments();
+    isProbingForSegments = performOnBackgroundThread && ! isUpload && numSegments > 1;
+    
     if (performOnBackgroundThread)
     {
-        CURLManager::getInstance()->addTimeSliceClient (this);
-        CURLManager::getInstance()->startThread();
+        CURLManager::getInstance()->addSession (this);
     }
     else
     {
@@ -194,6 +248,17 @@ void CURLEasySession::beginTransfer (bool transferIsUpload, bool performOnBackgr
 void CURLEasySession::stopTransfer()
 {
     shouldStopTransfer = true;
+    
+    const ScopedLock sl (transferLock);
+    
+    for (int i = 0; i < segments.size(); ++i)
+        segments.getUnchecked (i)->shouldStopTransfer = true;
+}
+
+void CURLEasySession::setNumSegments (int newNumSegments)
+{
+    jassert (newNumSegments > 0);
+    numSegments = jmax (1, newNumSegments);
 }
 
 void CURLEasySession::reset()
@@ -215,14 +280,6 @@ void CURLEasySession::removeListener (CURLEasySession::Listener* const listener)
     listeners.remove (listener);
 }
 
-//==============================================================================
-int CURLEasySession::useTimeSlice()
-{
-    performTransfer (isUpload);
-
-	return -1;
-}
-
 //==============================================================================
 size_t CURLEasySession::writeCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session)
 {
@@ -270,6 +327,10 @@ size_t CURLEasySession::directoryListingCallback (void* sourcePointer, size_t bl
 
 int CURLEasySession::internalProgressCallback (CURLEasySession* session, double dltotal, double dlnow, double /*ultotal*/, double ulnow)
 {
+    // the size isn't known until the probe has finished
+    if (session->isProbingForSegments)
+        return (int) session->shouldStopTransfer;
+    
 	session->progress = (float) (session->isUpload ? (ulnow / session->inputStream->getTotalLength()) : (dlnow / dltotal));
 	
     session->listeners.call (&CURLEasySession::Listener::transferProgressUpdate, session);
@@ -277,23 +338,118 @@ int CURLEasySession::internalProgressCallback (CURLEasySession* session, double
 	return (int) session->shouldStopTransfer;
 }
 
+size_t CURLEasySession::probeHeaderCallback (char* header, size_t blockSize, size_t numBlocks, CURLEasySession* session)
+{
+    const size_t numBytes = blockSize * numBlocks;
+    const String line (header, numBytes);
+    
+    if (line.startsWithIgnoreCase ("Accept-Ranges:") && line.containsIgnoreCase ("bytes"))
+        session->serverAcceptsRanges = true;
+    
+    return numBytes;
+}
+
+size_t CURLEasySession::segmentWriteCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* segment)
+{
+    const size_t numBytes = blockSize * numBlocks;
+    CURLEasySession& session = *segment->parent;
+    const ScopedLock sl (session.transferLock);
+    
+    if (session.segmentOutputStream == nullptr || segment->shouldStopTransfer)
+        return ! numBytes; // return a value not equal to numBytes to abort the transfer
+    
+    // a server that ignores the range sends the whole file
+    if (! segment->hasCheckedSegmentResponse)
+    {
+        long responseCode = 0;
+        curl_easy_getinfo (segment->handle, CURLINFO_RESPONSE_CODE, &responseCode);
+        
+        if (segment->remotePath.startsWithIgnoreCase ("http") && responseCode != 206)
+            return ! numBytes;
+        
+        segment->hasCheckedSegmentResponse = true;
+    }
+    
+    const int64 numToWrite = jmin ((int64) numBytes, segment->segmentRange.getEnd() - segment->segmentPosition);
+    
+    if (numToWrite <= 0
+         || ! session.segmentOutputStream->setPosition (segment->segmentPosition)
+         || ! session.segmentOutputStream->write (sourcePointer, (size_t) numToWrite))
+        return ! numBytes;
+    
+    session.completedRanges.addRange (Range<int64> (segment->segmentPosition, segment->segmentPosition + numToWrite));
+    segment->segmentPosition += numToWrite;
+    session.progress = (float) (session.completedRanges.size() / (double) session.segmentedFileLength);
+    
+    if ((session.numBytesSinceStateSaved += numToWrite) >= curlSessionStateSaveInterval)
+        session.saveSegmentState();
+    
+    session.listeners.call (&CURLEasySession::Listener::transferProgressUpdate, &session);
+    
+    // stop if the server sends more than was asked for
+    return numToWrite == (int64) numBytes ? numBytes : ! numBytes;
+}
+
 //==============================================================================
 int CURLEasySession::performTransfer (bool transferIsUpload)
 {
+    isUpload = transferIsUpload;
+    prepareTransfer();
+    
+	CURLcode result = curl_easy_perform (handle);
+	finishTransfer (result);
+    
+    return result;
+}
+
+void CURLEasySession::prepareTransfer()
+{
+    if (parent != nullptr)
+    {
+        const String range (String (segmentRange.getStart()) + "-" + String (segmentRange.getEnd() - 1));
+        
+        curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
+        curl_easy_setopt (handle, CURLOPT_RANGE, range.toUTF8().getAddress());
+        curl_easy_setopt (handle, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt (handle, CURLOPT_WRITEFUNCTION, segmentWriteCallback);
+        curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
+        curl_easy_setopt (handle, CURLOPT_PROGRESSDATA, this);
+        curl_easy_setopt (handle, CURLOPT_PROGRESSFUNCTION, internalProgressCallback);
+        
+        if (userNameAndPassword.isNotEmpty())
+            curl_easy_setopt (handle, CURLOPT_USERPWD, userNameAndPassword.toUTF8().getAddress());
+        
+        return;
+    }
+    
 	curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
-    curl_easy_setopt (handle, CURLOPT_UPLOAD, (long) transferIsUpload);
+    curl_easy_setopt (handle, CURLOPT_UPLOAD, (long) isUpload);
     curl_easy_setopt (handle, CURLOPT_PROGRESSDATA, this);
 	curl_easy_setopt (handle, CURLOPT_PROGRESSFUNCTION, internalProgressCallback);
     
-    if (transferIsUpload == true)
+    if (isUpload)
 	{
 		// sets the pointer to be passed to the read callback
 		curl_easy_setopt (handle, CURLOPT_READDATA, this);
 		curl_easy_setopt (handle, CURLOPT_READFUNCTION, readCallback);
         inputStream->setPosition (0);
 	}
+    else if (isProbingForSegments)
+    {
+        // just ask for the size and whether ranges can be used, the listeners are told once the segments start
+        serverAcceptsRanges = false;
+        curl_easy_setopt (handle, CURLOPT_NOBODY, 1L);
+        curl_easy_setopt (handle, CURLOPT_HEADERDATA, this);
+        curl_easy_setopt (handle, CURLOPT_HEADERFUNCTION, probeHeaderCallback);
+        
+        return;
+    }
 	else
 	{
+        curl_easy_setopt (handle, CURLOPT_NOBODY, 0L);
+        curl_easy_setopt (handle, CURLOPT_HEADERDATA, nullptr);
+        curl_easy_setopt (handle, CURLOPT_HEADERFUNCTION, nullptr);
+        
 		// sets the pointer to be passed to the write callback
 		curl_easy_setopt (handle, CURLOPT_WRITEDATA, this);
 		curl_easy_setopt (handle, CURLOPT_WRITEFUNCTION, writeCallback);
@@ -305,18 +461,208 @@ int CURLEasySession::performTransfer (bool transferIsUpload)
         outputStream = localFile.createOutputStream();
 	}
     
-	//perform the transfer
 	progress = 0.0f;
     listeners.call (&CURLEasySession::Listener::transferAboutToStart, this);
-	CURLcode result = curl_easy_perform (handle);
-	
+}
+
+void CURLEasySession::finishTransfer (int result)
+{
+    if (parent != nullptr)
+    {
+        parent->segmentFinished();
+        return;
+    }
+    
+    if (isProbingForSegments)
+    {
+        startSegments (result);
+        return;
+    }
+    
 	// delete the streams to flush the buffers
 	outputStream = nullptr;
     listeners.call (&CURLEasySession::Listener::transferEnded, this);
+}
+
+void CURLEasySession::cancelQueuedTransfer()
+{
+    if (parent != nullptr)
+        parent->segmentFinished();
+}
+
+//==============================================================================
+void CURLEasySession::startSegments (int probeResult)
+{
+    isProbingForSegments = false;
+    
+    if (shouldStopTransfer)
+        return;
+    
+    double contentLength = -1.0;
+    curl_easy_getinfo (handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+    
+    const bool canUseSegments = probeResult == CURLE_OK && contentLength > 0.0
+                                 && (serverAcceptsRanges || ! remotePath.startsWithIgnoreCase ("http"));
+    
+    if (! canUseSegments)
+    {
+        // download it in one go instead
+        CURLManager::getInstance()->addSession (this);
+        return;
+    }
+    
+    const ScopedLock sl (transferLock);
+    segmentedFileLength = (int64) contentLength;
+    numSegmentsFinished = 0;
+    numBytesSinceStateSaved = 0;
+    completedRanges.clear();
+    
+    if (! loadSegmentState() && localFile.existsAsFile())
+        localFile = localFile.getNonexistentSibling();
+    
+    segmentOutputStream = localFile.createOutputStream();
+    progress = (float) (completedRanges.size() / (double) segmentedFileLength);
+    listeners.call (&CURLEasySession::Listener::transferAboutToStart, this);
+    
+    // make the file full size so the segments can be written anywhere in it
+    if (segmentOutputStream == nullptr
+         || (localFile.getSize() < segmentedFileLength
+              && ! (segmentOutputStream->setPosition (segmentedFileLength - 1)
+                     && segmentOutputStream->writeByte (0))))
+    {
+        segmentOutputStream = nullptr;
+        listeners.call (&CURLEasySession::Listener::transferEnded, this);
+        return;
+    }
+    
+    isDownloadingSegments = true;
+    
+    // split up whatever hasn't already been downloaded
+    const int64 segmentSize = jmax (curlSessionMinSegmentSize, (segmentedFileLength + numSegments - 1) / numSegments);
+    int64 missingStart = 0;
+    
+    for (int i = 0; i <= completedRanges.getNumRanges(); ++i)
+    {
+        const bool isLastGap = i == completedRanges.getNumRanges();
+        const int64 missingEnd = isLastGap ? segmentedFileLength : completedRanges.getRange (i).getStart();
+        
+        for (int64 start = missingStart; start < missingEnd; start += segmentSize)
+            segments.add (new CURLEasySession (*this, Range<int64> (start, jmin (missingEnd, start + segmentSize))));
+        
+        if (! isLastGap)
+            missingStart = completedRanges.getRange (i).getEnd();
+    }
+    
+    saveSegmentState();
+    
+    if (segments.size() == 0)
+    {
+        finishSegmentedDownload();
+        return;
+    }
+    
+    for (int i = 0; i < segments.size(); ++i)
+        CURLManager::getInstance()->addSession (segments.getUnchecked (i));
+}
+
+void CURLEasySession::segmentFinished()
+{
+    const ScopedLock sl (transferLock);
+    
+    if (isDownloadingSegments && ++numSegmentsFinished >= segments.size())
+        finishSegmentedDownload();
+}
+
+void CURLEasySession::finishSegmentedDownload()
+{
+    isDownloadingSegments = false;
+    
+    if (completedRanges.containsRange (Range<int64> (0, segmentedFileLength)))
+    {
+        segmentOutputStream->flush();
+        getSegmentStateFile().deleteFile();
+    }
+    else
+    {
+        saveSegmentState();
+    }
+    
+    segmentOutputStream = nullptr;
+    listeners.call (&CURLEasySession::Listener::transferEnded, this);
+}
+
+File CURLEasySession::getSegmentStateFile() const
+{
+    return localFile.getSiblingFile (localFile.getFileName() + ".segments");
+}
+
+bool CURLEasySession::loadSegmentState()
+{
+    const File stateFile (getSegmentStateFile());
     
-    return result;
+    if (! (stateFile.existsAsFile() && localFile.existsAsFile()))
+        return false;
+    
+    StringArray lines;
+    lines.addLines (stateFile.loadFileAsString());
+    
+    // only resume the same download
+    if (lines.size() < 2 || lines[0] != remotePath || lines[1].getLargeIntValue() != segmentedFileLength)
+        return false;
+    
+    for (int i = 2; i < lines.size(); ++i)
+    {
+        const int64 start = lines[i].upToFirstOccurrenceOf (" ", false, false).getLargeIntValue();
+        const int64 end = jmin (segmentedFileLength, lines[i].fromFirstOccurrenceOf (" ", false, false).getLargeIntValue());
+        
+        if (isPositiveAndBelow (start, end))
+            completedRanges.addRange (Range<int64> (start, end));
+    }
+    
+    return true;
+}
+
+void CURLEasySession::saveSegmentState()
+{
+    // the data has to be in the file before the state says it is
+    segmentOutputStream->flush();
+    
+    String state;
+    state << remotePath << "\n" << String (segmentedFileLength) << "\n";
+    
+    for (int i = 0; i < completedRanges.getNumRanges(); ++i)
+    {
+        const Range<int64> range (completedRanges.getRange (i));
+        state << String (range.getStart()) << " " << String (range.getEnd()) << "\n";
+    }
+    
+    getSegmentStateFile().replaceWithText (state);
+    numBytesSinceStateSaved = 0;
+}
+
+void CURLEasySession::clearSegments()
+{
+    OwnedArray<CURLEasySession> oldSegments;
+    
+    {
+        const ScopedLock sl (transferLock);
+        oldSegments.swapWithArray (segments);
+    }
+    
+    // deleting them removes them from the CURLManager so nothing more will be written,
+    // this can't be done with the lock held as the manager may be waiting for it
+    oldSegments.clear();
+    
+    const ScopedLock sl (transferLock);
+    
+    if (isDownloadingSegments)
+    {
+        saveSegmentState();
+        segmentOutputStream = nullptr;
+        isDownloadingSegments = false;
+    }
 }
 
 
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
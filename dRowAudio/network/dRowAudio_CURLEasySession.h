@@ -47,7 +47,7 @@
 	@todo directory list is returned if this is found before a file transfer
 	@todo rename remote file if it already exists
  */
-class CURLEasySession : public TimeSliceClient
+class CURLEasySession
 {
 public:
 	//==============================================================================
@@ -122,13 +122,45 @@ public:
 		Returns an error code or an empty String if everything is set up ok.
 		The transfer will actually take place on a background thread so use getLastError()
 		to determine the last error that occured.
+		Background transfers are queued by the CURLManager and run alongside any
+		others up to its limit of concurrent transfers.
 	 */
 	void beginTransfer (bool transferIsUpload, bool performOnBackgroundThread = true);
 
     /** Stops the current transfer.
+        If it is still queued it is removed from the queue without starting.
      */
     void stopTransfer();
     
+    /** Sets the priority of this session's background transfers.
+        When there are more transfers than can run at once, queued sessions with
+        higher priorities are started first. This defaults to 0.
+        @see CURLManager::setMaxConcurrentTransfers
+     */
+    void setPriority (int newPriority) noexcept         {   priority = newPriority;  }
+    
+    /** Returns the priority of this session's background transfers. */
+    int getPriority() const noexcept                    {   return priority.get();  }
+    
+    /** Sets the number of segments background downloads are split into.
+     
+        When this is more than 1 the server is first asked for the size of the
+        file, which is then downloaded in that many byte ranges at once, each on
+        its own connection, and written straight into its place in the local file.
+        The segments are queued with the CURLManager so are subject to its limit
+        of concurrent transfers.
+     
+        Progress is saved to a file next to the local file with ".segments" added
+        to its name. If the transfer is stopped or fails, beginning it again with
+        the same local file carries on from the ranges that completed. Servers
+        that don't support ranges are downloaded with a single connection as usual.
+        This defaults to 1.
+     */
+    void setNumSegments (int newNumSegments);
+    
+    /** Returns the number of segments background downloads are split into. */
+    int getNumSegments() const noexcept                 {   return numSegments;   }
+    
 	/** Resets the state of the session to the parameters that have been specified.
      */
 	void reset();
@@ -167,16 +199,17 @@ public:
     /** Removes a previously-registered listener. */
     void removeListener (Listener* listener);
 	
-    //==============================================================================
-	/** @internal */
-	int useTimeSlice();
-	
 private:
     //==============================================================================
+    friend class CURLManager;
+    
+    CURLEasySession (CURLEasySession& parentSession, Range<int64> segmentRange);
+    
 	CURL* handle;
 	String remotePath, userNameAndPassword;
 	bool isUpload, shouldStopTransfer;
 	Atomic<float> progress;
+    Atomic<int> priority;
 	
 	File localFile;
 	ScopedPointer<FileOutputStream> outputStream;
@@ -185,14 +218,39 @@ private:
     
     CriticalSection transferLock;
     ListenerList<Listener> listeners;
+    
+    int numSegments, numSegmentsFinished;
+    bool isProbingForSegments, isDownloadingSegments, serverAcceptsRanges;
+    int64 segmentedFileLength, numBytesSinceStateSaved;
+    SparseSet<int64> completedRanges;
+    ScopedPointer<FileOutputStream> segmentOutputStream;
+    OwnedArray<CURLEasySession> segments;
+    
+    CURLEasySession* parent;
+    Range<int64> segmentRange;
+    int64 segmentPosition;
+    bool hasCheckedSegmentResponse;
 
     //==============================================================================
     int performTransfer (bool transferIsUpload);
+    void prepareTransfer();
+    void finishTransfer (int result);
+    void cancelQueuedTransfer();
+    
+    void startSegments (int probeResult);
+    void segmentFinished();
+    void finishSegmentedDownload();
+    File getSegmentStateFile() const;
+    bool loadSegmentState();
+    void saveSegmentState();
+    void clearSegments();
     
     static size_t writeCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session);
 	static size_t readCallback (void* destinationPointer, size_t blockSize, size_t numBlocks, CURLEasySession* session);
 	static size_t directoryListingCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session);
 	static int internalProgressCallback (CURLEasySession* session, double dltotal, double dlnow, double ultotal, double ulnow);
+	static size_t probeHeaderCallback (char* header, size_t blockSize, size_t numBlocks, CURLEasySession* session);
+	static size_t segmentWriteCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* segment);
 	    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLEasySession);
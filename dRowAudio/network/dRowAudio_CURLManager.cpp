@@ -41,32 +41,112 @@
 
 namespace drow {
 
+namespace
+{
+    /** The most handles that are kept in the pool waiting to be reused. */
+    const int curlManagerMaxIdleHandles = 8;
+}
+
 //==============================================================================
 juce_ImplementSingleton (CURLManager);
 
 CURLManager::CURLManager()
-    : TimeSliceThread ("cURL Thread")
+    : TimeSliceThread ("cURL Thread"),
+      multiHandle (nullptr),
+      sharedHandle (nullptr),
+      sessionInUse (nullptr),
+      isMultiHandleBusy (false),
+      maxConcurrentTransfers (4)
 {
 	CURLcode result = curl_global_init (CURL_GLOBAL_ALL);
     
     (void) result;
 	jassert (result == CURLE_OK);
+    
+    sharedHandle = curl_share_init();
+    curl_share_setopt (sharedHandle, CURLSHOPT_LOCKFUNC, lockSharedData);
+    curl_share_setopt (sharedHandle, CURLSHOPT_UNLOCKFUNC, unlockSharedData);
+    curl_share_setopt (sharedHandle, CURLSHOPT_USERDATA, this);
+    curl_share_setopt (sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt (sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    
+    // older versions of cURL can't share connections and will just return an error
+    curl_share_setopt (sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    
+    multiHandle = curl_multi_init();
+    addTimeSliceClient (this);
 }
 
 CURLManager::~CURLManager()
 {
+    stopThread (1000);
+    removeTimeSliceClient (this);
+    
+    for (int i = activeSessions.size(); --i >= 0;)
+        curl_multi_remove_handle (multiHandle, activeSessions.getUnchecked (i)->handle);
+    
+    curl_multi_cleanup (multiHandle);
+    
+    for (int i = 0; i < idleHandles.size(); ++i)
+        curl_easy_cleanup (idleHandles.getUnchecked (i));
+    
+    curl_share_cleanup (sharedHandle);
 	curl_global_cleanup();
 }
 
-CURL* CURLManager::createEasyCurlHandle()
+CURL* CURLManager::createEasyCurlHandle (const String& url)
 {
-    return curl_easy_init();
+    CURL* handle = nullptr;
+    
+    {
+        const ScopedLock sl (poolLock);
+        const int index = idleHandleHosts.indexOf (getHostForURL (url));
+        
+        if (index >= 0)
+        {
+            handle = idleHandles.getUnchecked (index);
+            idleHandles.remove (index);
+            idleHandleHosts.remove (index);
+        }
+    }
+    
+    // resetting keeps any open connections and the caches
+    if (handle != nullptr)
+        curl_easy_reset (handle);
+    else
+        handle = curl_easy_init();
+    
+    curl_easy_setopt (handle, CURLOPT_SHARE, sharedHandle);
+    
+    return handle;
 }
 
 void CURLManager::cleanUpEasyCurlHandle (CURL* handle)
 {
-	curl_easy_cleanup (handle);
-	handle = nullptr;
+    if (handle == nullptr)
+        return;
+    
+    char* lastURL = nullptr;
+    curl_easy_getinfo (handle, CURLINFO_EFFECTIVE_URL, &lastURL);
+    const String host (getHostForURL (lastURL != nullptr ? String (lastURL) : String::empty));
+    
+    CURL* handleToDelete = nullptr;
+    
+    {
+        const ScopedLock sl (poolLock);
+        idleHandles.add (handle);
+        idleHandleHosts.add (host);
+        
+        if (idleHandles.size() > curlManagerMaxIdleHandles)
+        {
+            handleToDelete = idleHandles.getUnchecked (0);
+            idleHandles.remove (0);
+            idleHandleHosts.remove (0);
+        }
+    }
+    
+    if (handleToDelete != nullptr)
+        curl_easy_cleanup (handleToDelete);
 }
 
 StringArray CURLManager::getSupportedProtocols()
@@ -77,4 +157,285 @@ StringArray CURLManager::getSupportedProtocols()
 	return StringArray();
 }
 
+//==============================================================================
+void CURLManager::setMaxConcurrentTransfers (int newMaxConcurrentTransfers)
+{
+    jassert (newMaxConcurrentTransfers > 0);
+    
+    const ScopedLock sl (sessionLock);
+    maxConcurrentTransfers = jmax (1, newMaxConcurrentTransfers);
+}
+
+int CURLManager::getNumActiveTransfers() const
+{
+    const ScopedLock sl (sessionLock);
+    return activeSessions.size();
+}
+
+int CURLManager::getNumQueuedTransfers() const
+{
+    const ScopedLock sl (sessionLock);
+    return queuedSessions.size();
+}
+
+void CURLManager::addSession (CURLEasySession* session)
+{
+    {
+        const ScopedLock sl (sessionLock);
+        
+        // this session is already transferring
+        if (queuedSessions.contains (session) || activeSessions.contains (session))
+        {
+            jassertfalse;
+            return;
+        }
+        
+        queuedSessions.add (session);
+    }
+    
+    startThread();
+    moveToFrontOfQueue (this);
+}
+
+void CURLManager::removeSession (CURLEasySession* session)
+{
+    {
+        const ScopedLock sl (sessionLock);
+        
+        // one that hasn't started yet can just be taken off the queue
+        if (queuedSessions.contains (session))
+        {
+            queuedSessions.removeFirstMatchingValue (session);
+            return;
+        }
+        
+        if (getThreadId() == Thread::getCurrentThreadId())
+        {
+            // removed by one of its own listeners, it won't be used again once they return
+            if (session == sessionInUse)
+                pendingRemovals.addIfNotAlreadyThere (session);
+            else
+                removeActiveSession (session);
+            
+            return;
+        }
+        
+        if (! isThreadRunning() || ! isMultiHandleBusy)
+            removeActiveSession (session);
+        
+        if (! activeSessions.contains (session) && session != sessionInUse)
+            return;
+        
+        pendingRemovals.addIfNotAlreadyThere (session);
+    }
+    
+    // the thread is transferring or calling this session's listeners so wait
+    // for it to finish, this never has to wait for any other session's listeners
+    for (;;)
+    {
+        {
+            const ScopedLock sl (sessionLock);
+            
+            if (! isThreadRunning())
+                removeActiveSession (session);
+            
+            if (! activeSessions.contains (session) && session != sessionInUse)
+            {
+                pendingRemovals.removeFirstMatchingValue (session);
+                return;
+            }
+        }
+        
+        sessionReleased.wait (10);
+    }
+}
+
+//==============================================================================
+int CURLManager::useTimeSlice()
+{
+    startQueuedTransfers();
+    
+    // the active sessions are only added on this thread so can be checked without the lock
+    if (activeSessions.size() == 0)
+        return 500;
+    
+    // the lock isn't held whilst transferring or calling the listeners so sessions
+    // can be added and removed from inside the callbacks or from other threads
+    int numRunning = 0;
+    setMultiHandleBusy (true);
+    curl_multi_perform (multiHandle, &numRunning);
+    setMultiHandleBusy (false);
+    
+    handleFinishedTransfers();
+    startQueuedTransfers();
+    
+    // keep the timeout short so sessions being removed don't have to wait long
+    int numFds = 0;
+    setMultiHandleBusy (true);
+    curl_multi_wait (multiHandle, nullptr, 0, 10, &numFds);
+    setMultiHandleBusy (false);
+    
+    return 0;
+}
+
+void CURLManager::setMultiHandleBusy (bool isBusy)
+{
+    const ScopedLock sl (sessionLock);
+    
+    isMultiHandleBusy = isBusy;
+    
+    // any sessions removed whilst the multi handle was busy can be taken out of it now
+    if (! isBusy && pendingRemovals.size() > 0)
+    {
+        for (int i = 0; i < pendingRemovals.size(); ++i)
+            removeActiveSession (pendingRemovals.getUnchecked (i));
+        
+        sessionReleased.signal();
+    }
+}
+
+void CURLManager::removeActiveSession (CURLEasySession* session)
+{
+    if (activeSessions.contains (session))
+    {
+        curl_multi_remove_handle (multiHandle, session->handle);
+        activeSessions.removeFirstMatchingValue (session);
+    }
+}
+
+void CURLManager::releaseSessionInUse()
+{
+    const ScopedLock sl (sessionLock);
+    
+    // if it was removed whilst it was in use it may have been deleted by now
+    pendingRemovals.removeFirstMatchingValue (sessionInUse);
+    sessionInUse = nullptr;
+    sessionReleased.signal();
+}
+
+void CURLManager::startQueuedTransfers()
+{
+    for (;;)
+    {
+        CURLEasySession* session = nullptr;
+        
+        {
+            const ScopedLock sl (sessionLock);
+            
+            if (activeSessions.size() >= maxConcurrentTransfers || queuedSessions.size() == 0)
+                return;
+            
+            // the highest priority goes first, then whichever was queued earliest
+            int next = 0;
+            
+            for (int i = 1; i < queuedSessions.size(); ++i)
+                if (queuedSessions.getUnchecked (i)->getPriority() > queuedSessions.getUnchecked (next)->getPriority())
+                    next = i;
+            
+            session = sessionInUse = queuedSessions.getUnchecked (next);
+            queuedSessions.remove (next);
+        }
+        
+        // stopped before it got the chance to start
+        if (session->shouldStopTransfer)
+        {
+            session->cancelQueuedTransfer();
+            releaseSessionInUse();
+            continue;
+        }
+        
+        session->prepareTransfer();
+        
+        bool wasRemoved;
+        
+        {
+            const ScopedLock sl (sessionLock);
+            
+            // it may have been removed whilst it was being prepared
+            wasRemoved = pendingRemovals.contains (session);
+            
+            if (! wasRemoved && curl_multi_add_handle (multiHandle, session->handle) == CURLM_OK)
+            {
+                activeSessions.add (session);
+                sessionInUse = nullptr;
+                continue;
+            }
+        }
+        
+        if (! wasRemoved)
+            session->finishTransfer (CURLE_FAILED_INIT);
+        
+        releaseSessionInUse();
+    }
+}
+
+void CURLManager::handleFinishedTransfers()
+{
+    for (;;)
+    {
+        CURLEasySession* session = nullptr;
+        CURLcode result = CURLE_OK;
+        
+        {
+            const ScopedLock sl (sessionLock);
+            
+            int numMessages = 0;
+            CURLMsg* const message = curl_multi_info_read (multiHandle, &numMessages);
+            
+            if (message == nullptr)
+                return;
+            
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            
+            // the message is invalid once the handle is removed so take a copy first
+            CURL* const handle = message->easy_handle;
+            result = message->data.result;
+            
+            for (int i = activeSessions.size(); --i >= 0;)
+            {
+                if (activeSessions.getUnchecked (i)->handle == handle)
+                {
+                    session = sessionInUse = activeSessions.getUnchecked (i);
+                    activeSessions.remove (i);
+                    curl_multi_remove_handle (multiHandle, handle);
+                    break;
+                }
+            }
+        }
+        
+        if (session != nullptr)
+        {
+            session->finishTransfer (result);
+            releaseSessionInUse();
+        }
+    }
+}
+
+//==============================================================================
+String CURLManager::getHostForURL (const String& url)
+{
+    // the scheme, user and port are kept as the connection can't be reused if they differ
+    const int hostStart = url.indexOf ("://");
+    
+    if (hostStart < 0)
+        return String::empty;
+    
+    const int hostEnd = url.indexOfChar (hostStart + 3, '/');
+    
+    return (hostEnd < 0 ? url : url.substring (0, hostEnd)).toLowerCase();
+}
+
+void CURLManager::lockSharedData (CURL* /*handle*/, int data, int /*access*/, CURLManager* manager)
+{
+    jassert (isPositiveAndBelow (data, numElementsInArray (manager->shareLocks)));
+    manager->shareLocks[data].enter();
+}
+
+void CURLManager::unlockSharedData (CURL* /*handle*/, int data, CURLManager* manager)
+{
+    jassert (isPositiveAndBelow (data, numElementsInArray (manager->shareLocks)));
+    manager->shareLocks[data].exit();
+}
+
 #endif
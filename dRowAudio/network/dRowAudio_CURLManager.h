@@ -36,10 +36,28 @@
 
 }
 typedef void CURL;
+typedef void CURLM;
+typedef void CURLSH;
 namespace drow {
 
+class CURLEasySession;
+
 //==============================================================================
+/**	Manages the cURL library and runs CURLEasySession transfers.
+ 
+	Background transfers are driven through a cURL multi handle on this thread
+	so several can run at once. Sessions are queued and started in order of
+	their priority, up to the maximum number of concurrent transfers.
+ 
+	All the handles it creates share a DNS cache, SSL sessions and, with cURL
+	7.57 or later, their open connections. Handles that are finished with are
+	kept in a pool and handed out again for the same host so back-to-back
+	transfers to one server can reuse its connection without a new handshake.
+ 
+	@see CURLEasySession
+ */
 class CURLManager : public TimeSliceThread,
+					private TimeSliceClient,
 					public DeletedAtShutdown
 {
 public:
@@ -52,16 +70,19 @@ public:
 	
 	//==============================================================================
 	/**	Creates a new easy curl session handle.
-		This simply creates the handle for you, it is the caller's responsibility
-		to clean up when the handle is no longer needed. This can be done with
-		cleanUpEasyCurlHandle().
+		If a URL is given and a handle last used for the same host is in the pool,
+		that is reset and returned instead so any connection it has open can be
+		reused. It is the caller's responsibility to clean up when the handle is
+		no longer needed. This can be done with cleanUpEasyCurlHandle().
 	 */
-	CURL* createEasyCurlHandle();
+	CURL* createEasyCurlHandle (const String& url = String::empty);
 	
 	/**	Cleans up an easy curl session for you.
 		You can pass this a handle generated with createEasyCurlHandle() to clean
-		up any resources associated with it. Be careful not to use the handle after
-		calling this function as it will be a nullptr.
+		up any resources associated with it. The handle is returned to the pool
+		to be used again for the same host, if the pool is full the oldest handle
+		in it is destroyed. Be careful not to use the handle after calling this
+		function.
 	 */
 	void cleanUpEasyCurlHandle (CURL* handle);
 	
@@ -69,10 +90,65 @@ public:
 	 */
 	StringArray getSupportedProtocols();
     
+	//==============================================================================
+	/**	Sets the maximum number of transfers that can run at the same time.
+		Any more sessions are queued until one of the running ones finishes.
+		This defaults to 4.
+	 */
+	void setMaxConcurrentTransfers (int newMaxConcurrentTransfers);
+    
+	/**	Returns the maximum number of transfers that can run at the same time. */
+	int getMaxConcurrentTransfers() const noexcept      {   return maxConcurrentTransfers;   }
+    
+	/**	Returns the number of transfers that are currently running. */
+	int getNumActiveTransfers() const;
+    
+	/**	Returns the number of transfers waiting to be started. */
+	int getNumQueuedTransfers() const;
+    
+	/**	Queues a session's transfer to be performed on this thread.
+		This is called by CURLEasySession::beginTransfer() so you shouldn't
+		need to call it yourself.
+	 */
+	void addSession (CURLEasySession* session);
+    
+	/**	Removes a session, stopping its transfer if it has already started.
+		No more callbacks will be made to the session once this returns. This
+		may have to wait for the thread to finish running the transfers, or
+		calling this session's listeners, so don't call it whilst holding a lock
+		that the transfer callbacks or this session's listeners need.
+	 */
+	void removeSession (CURLEasySession* session);
+    
 private:
+	//==============================================================================
+	CURLM* multiHandle;
+	CURLSH* sharedHandle;
+	CriticalSection sessionLock, poolLock;
+	CriticalSection shareLocks[16];
+	Array<CURL*> idleHandles;
+	StringArray idleHandleHosts;
+	Array<CURLEasySession*> queuedSessions, activeSessions, pendingRemovals;
+	CURLEasySession* sessionInUse;
+	bool isMultiHandleBusy;
+	WaitableEvent sessionReleased;
+	int maxConcurrentTransfers;
+    
+	//==============================================================================
+	int useTimeSlice();
+	void setMultiHandleBusy (bool isBusy);
+	void removeActiveSession (CURLEasySession* session);
+	void releaseSessionInUse();
+	void startQueuedTransfers();
+	void handleFinishedTransfers();
+    
+	static String getHostForURL (const String& url);
+	static void lockSharedData (CURL* handle, int data, int access, CURLManager* manager);
+	static void unlockSharedData (CURL* handle, int data, CURLManager* manager);
+    
 	//==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLManager);
 };
 
 #endif
-#endif  // __DROWAUDIO_CURLMANAGER_H__
\ No newline at end of file
+#endif  // __DROWAUDIO_CURLMANAGER_H__
\ No newline at end of file
@@ -0,0 +1,514 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_USE_CURL
+
+} //namespace drow
+
+#if JUCE_WINDOWS
+ #include "curl/include/curl/curl.h"
+#else
+ #include <curl/curl.h>
+#endif
+
+namespace drow {
+
+namespace
+{
+    /** Positions this far ahead of the transfer are waited for rather than
+        restarting the transfer with a range request.
+     */
+    const int64 curlStreamingMaxBytesToWaitFor = 256 * 1024;
+    
+    /** Several streams can wait on the same download and only one of them is woken
+        by each signal, so waits are done in steps of this long.
+     */
+    const int curlStreamingWaitStepMs = 50;
+}
+
+//==============================================================================
+/** The state of a transfer, shared by all the streams reading from it. */
+class CURLStreamingInputStream::Download  : public ReferenceCountedObject
+{
+public:
+    Download (const String& url_, int connectionTimeoutMs);
+    ~Download();
+    
+    //==============================================================================
+    const String url;
+    
+    CriticalSection lock;
+    WaitableEvent dataArrived;
+    MemoryBlock data;
+    SparseSet<int64> receivedRanges;
+    int64 totalLength, writePosition, requestedStart;
+    bool isTransferring, hasConnected, hasFailed, supportsRanges;
+    
+    ScopedPointer<Transfer> transfer;
+    
+    //==============================================================================
+    int64 getFirstMissingByte (int64 start) const;
+    bool willArriveSoon (int64 start) const;
+    void requestTransferFrom (int64 start);
+    void prepareToRead (int64 start);
+    bool waitForRange (int64 start, int64 end, int timeoutMs, bool canMoveTransfer);
+    
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE (Download);
+};
+
+//==============================================================================
+class CURLStreamingInputStream::Transfer  : public Thread
+{
+public:
+    Transfer (Download& owner_, int connectionTimeoutMs)
+        : Thread ("cURL Streaming Thread"),
+          owner (owner_),
+          handle (CURLManager::getInstance()->createEasyCurlHandle (owner_.url)),
+          rangeStart (0),
+          hasReceivedResponse (false),
+          hasSkippedToEnd (false)
+    {
+        curl_easy_setopt (handle, CURLOPT_URL, owner.url.toUTF8().getAddress());
+        curl_easy_setopt (handle, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt (handle, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt (handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt (handle, CURLOPT_CONNECTTIMEOUT_MS, (long) connectionTimeoutMs);
+        curl_easy_setopt (handle, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt (handle, CURLOPT_WRITEFUNCTION, writeCallback);
+        
+        // the progress callback is called even when no data is arriving so is used to abort stalled transfers
+        curl_easy_setopt (handle, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt (handle, CURLOPT_PROGRESSDATA, this);
+        curl_easy_setopt (handle, CURLOPT_PROGRESSFUNCTION, progressCallback);
+        
+        startThread();
+    }
+    
+    ~Transfer()
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread (4000);
+        
+        CURLManager::getInstance()->cleanUpEasyCurlHandle (handle);
+    }
+    
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            int64 start;
+            
+            {
+                const ScopedLock sl (owner.lock);
+                start = owner.requestedStart;
+                owner.requestedStart = -1;
+                owner.isTransferring = start >= 0;
+                
+                if (start >= 0)
+                    owner.writePosition = start;
+            }
+            
+            if (start < 0)
+            {
+                wait (-1);
+                continue;
+            }
+            
+            rangeStart = start;
+            hasReceivedResponse = false;
+            hasSkippedToEnd = false;
+            
+            const String range (String (start) + "-");
+            curl_easy_setopt (handle, CURLOPT_RANGE, start > 0 ? range.toUTF8().getAddress() : nullptr);
+            
+            const CURLcode result = curl_easy_perform (handle);
+            
+            {
+                const ScopedLock sl (owner.lock);
+                owner.isTransferring = false;
+                
+                if (result == CURLE_OK || hasSkippedToEnd)
+                {
+                    owner.hasConnected = true;
+                    
+                    if (owner.totalLength < 0)
+                        owner.totalLength = owner.writePosition;
+                    
+                    // go back for anything a range request skipped over so the whole file
+                    // ends up downloaded for streams that can't move the transfer themselves
+                    const int64 firstMissingByte = owner.getFirstMissingByte (0);
+                    
+                    if (owner.requestedStart < 0 && owner.supportsRanges
+                         && owner.writePosition > start && firstMissingByte < owner.totalLength)
+                        owner.requestedStart = firstMissingByte;
+                }
+                else if (owner.requestedStart < 0 && ! threadShouldExit())
+                {
+                    owner.hasFailed = true;
+                }
+                
+                owner.dataArrived.signal();
+            }
+        }
+    }
+    
+private:
+    //==============================================================================
+    Download& owner;
+    CURL* handle;
+    int64 rangeStart;
+    bool hasReceivedResponse, hasSkippedToEnd;
+    
+    //==============================================================================
+    bool shouldStop() const
+    {
+        return threadShouldExit() || owner.requestedStart >= 0;
+    }
+    
+    /** Called with the lock held when the first data of a transfer arrives. */
+    void handleResponse()
+    {
+        long responseCode = 0;
+        double contentLength = -1.0;
+        curl_easy_getinfo (handle, CURLINFO_RESPONSE_CODE, &responseCode);
+        curl_easy_getinfo (handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+        
+        int64 bodyStart = rangeStart;
+        
+        // the server has ignored the range and is sending the whole file
+        if (rangeStart > 0 && responseCode == 200)
+        {
+            owner.supportsRanges = false;
+            bodyStart = 0;
+        }
+        
+        owner.writePosition = bodyStart;
+        
+        if (owner.totalLength < 0 && contentLength >= 0.0)
+        {
+            owner.totalLength = bodyStart + (int64) contentLength;
+            owner.data.ensureSize ((size_t) owner.totalLength);
+        }
+    }
+    
+    bool write (const void* sourceData, size_t numBytes)
+    {
+        const ScopedLock sl (owner.lock);
+        
+        if (shouldStop())
+            return false;
+        
+        if (! hasReceivedResponse)
+        {
+            hasReceivedResponse = true;
+            handleResponse();
+        }
+        
+        const int64 start = owner.writePosition;
+        const int64 end = start + (int64) numBytes;
+        
+        if ((int64) owner.data.getSize() < end)
+            owner.data.ensureSize ((size_t) jmax (end, (int64) owner.data.getSize() * 2));
+        
+        memcpy (addBytesToPointer (owner.data.getData(), start), sourceData, numBytes);
+        
+        owner.receivedRanges.addRange (Range<int64> (start, end));
+        owner.writePosition = end;
+        owner.totalLength = owner.totalLength >= 0 ? jmax (owner.totalLength, end) : -1;
+        owner.hasConnected = true;
+        owner.dataArrived.signal();
+        
+        // no need to carry on if the rest of the file has already been downloaded
+        if (owner.totalLength >= 0 && end < owner.totalLength
+             && owner.getFirstMissingByte (end) >= owner.totalLength)
+        {
+            hasSkippedToEnd = true;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    static size_t writeCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, Transfer* transfer)
+    {
+        const size_t numBytes = blockSize * numBlocks;
+        
+        if (transfer != nullptr && transfer->write (sourcePointer, numBytes))
+            return numBytes;
+        
+        return ! numBytes; // return a value not equal to numBytes to abort the transfer
+    }
+    
+    static int progressCallback (Transfer* transfer, double /*dltotal*/, double /*dlnow*/, double /*ultotal*/, double /*ulnow*/)
+    {
+        const ScopedLock sl (transfer->owner.lock);
+        return (int) transfer->shouldStop();
+    }
+    
+    JUCE_DECLARE_NON_COPYABLE (Transfer);
+};
+
+//==============================================================================
+CURLStreamingInputStream::Download::Download (const String& url_, int connectionTimeoutMs)
+    : url (url_),
+      totalLength (-1),
+      writePosition (0),
+      requestedStart (0),
+      isTransferring (false),
+      hasConnected (false),
+      hasFailed (false),
+      supportsRanges (true)
+{
+    transfer = new Transfer (*this, connectionTimeoutMs);
+    
+    // wait for the response so the length is known before anything is read
+    const uint32 startTime = Time::getMillisecondCounter();
+    
+    for (;;)
+    {
+        {
+            const ScopedLock sl (lock);
+            
+            if (hasConnected || hasFailed)
+                return;
+        }
+        
+        const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+        
+        if (elapsed >= connectionTimeoutMs)
+            break;
+        
+        dataArrived.wait (connectionTimeoutMs - elapsed);
+    }
+    
+    transfer = nullptr;
+    
+    const ScopedLock sl (lock);
+    isTransferring = false;
+    hasFailed = true;
+}
+
+CURLStreamingInputStream::Download::~Download()
+{
+    transfer = nullptr;
+}
+
+int64 CURLStreamingInputStream::Download::getFirstMissingByte (int64 start) const
+{
+    for (int i = 0; i < receivedRanges.getNumRanges(); ++i)
+    {
+        const Range<int64> range (receivedRanges.getRange (i));
+        
+        if (range.contains (start))
+            return range.getEnd();
+    }
+    
+    return start;
+}
+
+bool CURLStreamingInputStream::Download::willArriveSoon (int64 start) const
+{
+    const int64 nextByte = requestedStart >= 0 ? requestedStart
+                                               : (isTransferring ? writePosition : -1);
+    
+    if (nextByte < 0 || start < nextByte)
+        return false;
+    
+    return ! supportsRanges || start - nextByte <= curlStreamingMaxBytesToWaitFor;
+}
+
+void CURLStreamingInputStream::Download::requestTransferFrom (int64 start)
+{
+    requestedStart = start;
+    
+    if (transfer != nullptr)
+        transfer->notify();
+}
+
+void CURLStreamingInputStream::Download::prepareToRead (int64 start)
+{
+    const int64 firstMissingByte = getFirstMissingByte (start);
+    
+    if (hasFailed
+         || (totalLength >= 0 && firstMissingByte >= totalLength)
+         || willArriveSoon (firstMissingByte))
+        return;
+    
+    requestTransferFrom (firstMissingByte);
+}
+
+bool CURLStreamingInputStream::Download::waitForRange (int64 start, int64 end, int timeoutMs, bool canMoveTransfer)
+{
+    const uint32 startTime = Time::getMillisecondCounter();
+    
+    for (;;)
+    {
+        {
+            const ScopedLock sl (lock);
+            
+            if (getFirstMissingByte (start) >= (totalLength >= 0 ? jmin (end, totalLength) : end))
+                return true;
+            
+            if (hasFailed || (! canMoveTransfer && ! isTransferring && requestedStart < 0))
+                return false;
+            
+            if (canMoveTransfer)
+                prepareToRead (start);
+        }
+        
+        const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+        
+        if (elapsed >= timeoutMs)
+            return false;
+        
+        dataArrived.wait (jmin (curlStreamingWaitStepMs, timeoutMs - elapsed));
+    }
+}
+
+//==============================================================================
+CURLStreamingInputStream::CURLStreamingInputStream (const String& url_, int connectionTimeoutMs)
+    : url (url_),
+      readTimeoutMs (10000),
+      download (new Download (url_, connectionTimeoutMs)),
+      canMoveTransfer (true),
+      position (0)
+{
+}
+
+CURLStreamingInputStream::CURLStreamingInputStream (Download* downloadToShare, int readTimeoutMs_)
+    : url (downloadToShare->url),
+      readTimeoutMs (readTimeoutMs_),
+      download (downloadToShare),
+      canMoveTransfer (false),
+      position (0)
+{
+}
+
+CURLStreamingInputStream::~CURLStreamingInputStream()
+{
+}
+
+CURLStreamingInputStream* CURLStreamingInputStream::createSharedStream() const
+{
+    return new CURLStreamingInputStream (download, readTimeoutMs);
+}
+
+//==============================================================================
+bool CURLStreamingInputStream::failedToOpen() const
+{
+    const ScopedLock sl (download->lock);
+    return ! download->hasConnected;
+}
+
+int64 CURLStreamingInputStream::getNumBytesAvailable (int64 startPosition) const
+{
+    const ScopedLock sl (download->lock);
+    return download->getFirstMissingByte (startPosition) - startPosition;
+}
+
+int64 CURLStreamingInputStream::getNumBytesDownloaded() const
+{
+    const ScopedLock sl (download->lock);
+    return download->receivedRanges.size();
+}
+
+bool CURLStreamingInputStream::isDownloadComplete() const
+{
+    const ScopedLock sl (download->lock);
+    return download->totalLength >= 0 && download->getFirstMissingByte (0) >= download->totalLength;
+}
+
+bool CURLStreamingInputStream::waitForData (int64 numBytes, int timeoutMs)
+{
+    return download->waitForRange (position, position + numBytes, timeoutMs, canMoveTransfer);
+}
+
+//==============================================================================
+int64 CURLStreamingInputStream::getTotalLength()
+{
+    const ScopedLock sl (download->lock);
+    return download->totalLength;
+}
+
+bool CURLStreamingInputStream::isExhausted()
+{
+    const ScopedLock sl (download->lock);
+    
+    if (download->totalLength >= 0)
+        return position >= download->totalLength;
+    
+    return ! download->isTransferring && download->requestedStart < 0
+            && download->getFirstMissingByte (position) == position;
+}
+
+int CURLStreamingInputStream::read (void* destBuffer, int maxBytesToRead)
+{
+    jassert (destBuffer != nullptr && maxBytesToRead >= 0);
+    
+    download->waitForRange (position, position + maxBytesToRead, readTimeoutMs, canMoveTransfer);
+    
+    const ScopedLock sl (download->lock);
+    const int numBytes = (int) jlimit ((int64) 0, (int64) maxBytesToRead,
+                                       download->getFirstMissingByte (position) - position);
+    
+    if (numBytes > 0)
+    {
+        memcpy (destBuffer, addBytesToPointer (download->data.getData(), position), (size_t) numBytes);
+        position += numBytes;
+    }
+    
+    return numBytes;
+}
+
+int64 CURLStreamingInputStream::getPosition()
+{
+    return position;
+}
+
+bool CURLStreamingInputStream::setPosition (int64 newPosition)
+{
+    const ScopedLock sl (download->lock);
+    position = jmax ((int64) 0, newPosition);
+    
+    if (download->totalLength >= 0)
+        position = jmin (position, download->totalLength);
+    
+    // get the transfer going whilst the caller works out what to read
+    if (canMoveTransfer)
+        download->prepareToRead (position);
+    
+    return true;
+}
+
+#endif
@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_CURLSTREAMINGINPUTSTREAM_H__
+#define __DROWAUDIO_CURLSTREAMINGINPUTSTREAM_H__
+
+#if DROWAUDIO_USE_CURL || DOXYGEN
+
+#include "dRowAudio_CURLManager.h"
+
+//==============================================================================
+/** An InputStream that reads from a URL whilst it is being downloaded.
+ 
+    The transfer is performed by cURL on a background thread into a buffer the
+    size of the remote file. A read only blocks until the bytes it asks for have
+    arrived so the stream can be used long before the download has finished,
+    e.g. to start playing a track after its first few seconds.
+ 
+    If the stream is moved to a position that hasn't been downloaded yet and
+    isn't just ahead of the transfer, the transfer is restarted from there with
+    a range request. Anything already downloaded is kept so moving back to it
+    won't download it again. Servers that don't support ranges are read from
+    the start. If the connection is lost part way through, reads just return
+    whatever has been downloaded.
+ 
+    Once the transfer reaches the end of the file it goes back for anything
+    that was skipped over, so the whole file ends up in memory. This is meant
+    for audio files rather than arbitrarily large downloads.
+ 
+    Use createSharedStream() to read the same download from somewhere else,
+    e.g. to draw a thumbnail, without fetching the file a second time.
+ 
+    @see CURLStreamingInputSource, StreamAndFileHandler::setURL
+ */
+class CURLStreamingInputStream :    public InputStream
+{
+public:
+    //==============================================================================
+    /** Creates a stream and starts downloading the URL.
+        This blocks until the server has responded or the connection times out so
+        that the length of the stream is known. Use failedToOpen() to find out if
+        it was successful.
+     */
+    CURLStreamingInputStream (const String& url, int connectionTimeoutMs = 10000);
+    
+    /** Destructor. */
+    ~CURLStreamingInputStream();
+    
+    /** Creates another stream that reads from this one's download.
+     
+        The new stream has its own position but shares the data, so nothing is
+        downloaded twice and it can outlive this stream. It never moves the
+        transfer though; reading a part that hasn't arrived yet waits for the
+        transfer to get there. The caller is responsible for deleting it.
+     */
+    CURLStreamingInputStream* createSharedStream() const;
+    
+    //==============================================================================
+    /** Returns the URL being read from. */
+    const String& getURL() const noexcept                   {   return url; }
+    
+    /** Returns true if the server couldn't be connected to or returned an error.
+     */
+    bool failedToOpen() const;
+    
+    /** Sets the longest time a read will wait for its data before giving up.
+        A read that times out returns the bytes that have arrived so far. This
+        defaults to 10 seconds.
+     */
+    void setReadTimeout (int newTimeoutMs) noexcept         {   readTimeoutMs = newTimeoutMs;   }
+    
+    /** Returns the read timeout. */
+    int getReadTimeout() const noexcept                     {   return readTimeoutMs;   }
+    
+    //==============================================================================
+    /** Returns the number of bytes from a position that can be read without
+        having to wait for them to download.
+     */
+    int64 getNumBytesAvailable (int64 position) const;
+    
+    /** Returns the total number of bytes that have been downloaded. */
+    int64 getNumBytesDownloaded() const;
+    
+    /** Returns true once the whole of the remote file has been downloaded. */
+    bool isDownloadComplete() const;
+    
+    /** Blocks until a number of bytes from the current position have been
+        downloaded, the transfer fails or the timeout expires.
+        @returns true if the bytes are available
+     */
+    bool waitForData (int64 numBytes, int timeoutMs);
+    
+    //==============================================================================
+    int64 getTotalLength() override;
+    bool isExhausted() override;
+    int read (void* destBuffer, int maxBytesToRead) override;
+    int64 getPosition() override;
+    bool setPosition (int64 newPosition) override;
+    
+private:
+    //==============================================================================
+    class Download;
+    class Transfer;
+    
+    const String url;
+    int readTimeoutMs;
+    ReferenceCountedObjectPtr<Download> download;
+    const bool canMoveTransfer;
+    int64 position;
+    
+    //==============================================================================
+    CURLStreamingInputStream (Download* downloadToShare, int readTimeoutMs);
+    
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLStreamingInputStream);
+};
+
+//==============================================================================
+/** A type of InputSource that streams a URL with a CURLStreamingInputStream.
+ 
+    A source created from a URL starts a new download for each stream it creates,
+    one created from a stream shares that stream's download instead. The hash code
+    is generated from the URL so sources for the same URL share entries in caches
+    such as the AudioThumbnailCache.
+ 
+    @see CURLStreamingInputStream
+ */
+class CURLStreamingInputSource :    public InputSource
+{
+public:
+    //==============================================================================
+    /** Creates a source for a URL. */
+    CURLStreamingInputSource (const String& url_)
+        : url (url_)
+    {
+    }
+    
+    /** Creates a source that reads from an existing stream's download.
+        The stream doesn't need to stay in existence.
+     */
+    CURLStreamingInputSource (const CURLStreamingInputStream& streamToShare)
+        : url (streamToShare.getURL()),
+          sharedStream (streamToShare.createSharedStream())
+    {
+    }
+    
+    InputStream* createInputStream()
+    {
+        if (sharedStream != nullptr)
+            return sharedStream->createSharedStream();
+        
+        ScopedPointer<CURLStreamingInputStream> stream (new CURLStreamingInputStream (url));
+        
+        return stream->failedToOpen() ? nullptr : stream.release();
+    }
+    
+    InputStream* createInputStreamFor (const String& relatedItemPath)
+    {
+        ScopedPointer<CURLStreamingInputStream> stream (new CURLStreamingInputStream (url.upToLastOccurrenceOf ("/", true, false)
+                                                                                      + relatedItemPath));
+        
+        return stream->failedToOpen() ? nullptr : stream.release();
+    }
+    
+    int64 hashCode() const
+    {
+        return url.hashCode64();
+    }
+    
+private:
+    //==============================================================================
+    const String url;
+    ScopedPointer<CURLStreamingInputStream> sharedStream;
+    
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLStreamingInputSource);
+};
+
+#endif
+#endif  // __DROWAUDIO_CURLSTREAMINGINPUTSTREAM_H__
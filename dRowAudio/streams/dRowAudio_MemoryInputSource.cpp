@@ -30,11 +30,45 @@
 */
 
 
+namespace
+{
+    // blocks larger than this only have sections of their data hashed
+    const size_t memoryInputSourceFullHashSize = 1024 * 1024;
+    const size_t memoryInputSourceSectionSize = 4096;
+    const int memoryInputSourceNumSections = 256;
+
+    inline uint64 mixMemoryHash (uint64 h, uint64 value) noexcept
+    {
+        h ^= value;
+        h *= literal64bit (0xff51afd7ed558ccd);
+        return h ^ (h >> 32);
+    }
+
+    uint64 hashMemory (uint64 h, const uint8* data, size_t numBytes) noexcept
+    {
+        for (; numBytes >= sizeof (uint64); numBytes -= sizeof (uint64), data += sizeof (uint64))
+        {
+            uint64 value;
+            memcpy (&value, data, sizeof (uint64));
+            h = mixMemoryHash (h, value);
+        }
+
+        uint64 tail = 0;
+
+        if (numBytes > 0)
+            memcpy (&tail, data, numBytes);
+
+        return mixMemoryHash (h, tail);
+    }
+}
 
 //==============================================================================
 MemoryInputSource::MemoryInputSource (MemoryInputStream* stream, bool useFileTimeInHashGeneration_)
     : memoryInputStream (stream),
-      useFileTimeInHashGeneration (useFileTimeInHashGeneration_)
+      useFileTimeInHashGeneration (useFileTimeInHashGeneration_),
+      creationTime (Time::getCurrentTime().toMilliseconds()),
+      hash (0),
+      hasCalculatedHash (false)
 {
 }
 
@@ -54,8 +88,34 @@ InputStream* MemoryInputSource::createInputStreamFor (const String& /*relatedIte
 
 int64 MemoryInputSource::hashCode() const
 {
-    int64 h = Time::getCurrentTime().toMilliseconds();
+    if (! hasCalculatedHash)
+    {
+        const uint8* const data = memoryInputStream != nullptr ? static_cast<const uint8*> (memoryInputStream->getData()) : nullptr;
+        const size_t size = memoryInputStream != nullptr ? memoryInputStream->getDataSize() : 0;
+        
+        uint64 h = mixMemoryHash (literal64bit (0xcbf29ce484222325), (uint64) size);
+        
+        if (size <= memoryInputSourceFullHashSize)
+        {
+            h = hashMemory (h, data, size);
+        }
+        else
+        {
+            // evenly spaced sections including the very start and end
+            const uint64 lastSectionStart = (uint64) (size - memoryInputSourceSectionSize);
+            
+            for (int i = 0; i < memoryInputSourceNumSections; ++i)
+                h = hashMemory (h, data + (size_t) (lastSectionStart * i / (memoryInputSourceNumSections - 1)),
+                                memoryInputSourceSectionSize);
+        }
+        
+        if (useFileTimeInHashGeneration)
+            h = mixMemoryHash (h, (uint64) creationTime);
+        
+        hash = (int64) h;
+        hasCalculatedHash = true;
+    }
     
-    return h;
+    return hash;
 }
 
@@ -35,12 +35,22 @@
 //==============================================================================
 /** A type of InputSource that represents a MemoryInputStream.
  
+    The hash code is calculated from the stream's data so sources holding the
+    same data will share entries in caches such as the AudioThumbnailCache. For
+    speed, large blocks only have evenly spaced sections of their data hashed.
+    The hash is only calculated the first time it is needed so the data must not
+    change during the source's lifetime.
+ 
     @see InputSource
  */
 class MemoryInputSource :   public InputSource
 {
 public:
     //==============================================================================
+    /** Creates a source for a stream.
+        If useFileTimeInHashGeneration is true the time the source was created is
+        mixed in to the hash so it won't match any other source.
+     */
     MemoryInputSource (MemoryInputStream* stream, bool useFileTimeInHashGeneration = false);
     ~MemoryInputSource();
     
@@ -52,6 +62,9 @@ private:
     //==============================================================================
     MemoryInputStream* memoryInputStream;
     bool useFileTimeInHashGeneration;
+    const int64 creationTime;
+    mutable int64 hash;
+    mutable bool hasCalculatedHash;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryInputSource);
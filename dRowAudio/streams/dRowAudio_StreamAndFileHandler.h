@@ -33,6 +33,7 @@
 #define __DROWAUDIO_STREAMANDFILEHANDLER_H__
 
 #include "dRowAudio_MemoryInputSource.h"
+#include "../network/dRowAudio_CURLStreamingInputStream.h"
 
 //==============================================================================
 /**
@@ -53,6 +54,7 @@ public:
         memoryBlock,
         memoryInputStream,
         unknownStream,
+        urlStream,
         noInput
     };
     
@@ -73,6 +75,7 @@ public:
     {
         inputType = noInput;
         currentFile = File::nonexistent;
+        currentURL = String::empty;
         inputStream = nullptr;
     }
     
@@ -96,6 +99,11 @@ public:
             return setFile (fis->getFile());
         }
         
+       #if DROWAUDIO_USE_CURL
+        if (CURLStreamingInputStream* cis = dynamic_cast<CURLStreamingInputStream*> (inputStream))
+            return setStreamingInputStream (cis);
+       #endif
+        
         return streamChanged (inputStream);
     }
     
@@ -103,7 +111,8 @@ public:
      
         It is the caller's responsibility to delete this stream unless it has the
         type unknownStream which it can't make a copy of. You could use a
-        dynamic_cast to do this yourself if you know the type.
+        dynamic_cast to do this yourself if you know the type. For a urlStream
+        this reads from the same download as the current stream.
      */
     InputStream* getInputStream()
     {
@@ -127,6 +136,17 @@ public:
             {
                 return inputStream;
             }
+           #if DROWAUDIO_USE_CURL
+            case urlStream:
+            {
+                CURLStreamingInputStream* streamingStream = getStreamingInputStream();
+                
+                if (streamingStream != nullptr)
+                    return streamingStream->createSharedStream();
+                else
+                    return nullptr;
+            }
+           #endif
             default:
             {
                 return nullptr;
@@ -156,6 +176,17 @@ public:
                 else
                     return nullptr;
             }
+           #if DROWAUDIO_USE_CURL
+            case urlStream:
+            {
+                CURLStreamingInputStream* streamingStream = getStreamingInputStream();
+                
+                if (streamingStream != nullptr)
+                    return new CURLStreamingInputSource (*streamingStream);
+                else
+                    return nullptr;
+            }
+           #endif
             default:
             {
                 return nullptr;
@@ -200,6 +231,44 @@ public:
         return streamChanged (inputStream);
     }
     
+   #if DROWAUDIO_USE_CURL
+    /** Sets the source to a remote file which is played whilst it downloads.
+        This blocks until the server has responded and enough of the file has
+        arrived to read its header.
+        @returns true if the stream loaded correctly
+        @see CURLStreamingInputStream
+     */
+    bool setURL (const String& newURL)
+    {
+        return setStreamingInputStream (new CURLStreamingInputStream (newURL));
+    }
+    
+    /** Sets the source to a CURLStreamingInputStream.
+        @returns true if the stream loaded correctly
+     */
+    bool setStreamingInputStream (CURLStreamingInputStream* newStream)
+    {
+        inputType = urlStream;
+        currentFile = File::nonexistent;
+        currentURL = newStream->getURL();
+        inputStream = newStream;
+        
+        return streamChanged (inputStream);
+    }
+    
+    /** Returns the stream being downloaded if the source was set with a URL,
+        otherwise nullptr.
+     */
+    CURLStreamingInputStream* getStreamingInputStream() const noexcept
+    {
+        return inputType == urlStream ? dynamic_cast<CURLStreamingInputStream*> (inputStream) : nullptr;
+    }
+   #endif
+    
+    /** Returns the current URL if it was set with one, otherwise an empty String.
+     */
+    String getURL() const                               { return inputType == urlStream ? currentURL : String::empty; }
+    
 	/** Returns the current file if it was set with a one.
         If a stream was used this will return File::nonexistant.
      */
@@ -222,10 +291,24 @@ public:
      */
     virtual bool streamChanged (InputStream* inputStream) = 0;
 
+protected:
+    //==============================================================================
+    /** Sets the current file without calling fileChanged().
+        This can be used by subclasses that open their files asynchronously to
+        record the file once it has been loaded.
+     */
+    void setCurrentFile (const File& newFile)
+    {
+        inputType = file;
+        inputStream = nullptr;
+        currentFile = newFile;
+    }
+
 private:
     //==============================================================================
     InputType inputType;
 	File currentFile;
+    String currentURL;
     InputStream* inputStream;
     
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamAndFileHandler)